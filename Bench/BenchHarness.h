@@ -0,0 +1,125 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace msgnet::bench
+{
+
+// 컴파일러가 결과를 버리지 못하게 한다 (Google Benchmark의 DoNotOptimize와 같은 역할)
+template <typename T>
+inline void doNotOptimize(const T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct BenchResult
+{
+    std::string name;
+    uint64_t iterations = 0;
+    double ns_per_op = 0.0;
+    double ops_per_sec = 0.0;
+    std::string note;
+};
+
+// 측정 설정 (--min-time, --filter)
+struct BenchConfig
+{
+    double min_time_sec = 0.2;
+    std::string filter;
+};
+
+// 자체 포함 벤치 하네스
+// - fn(iters)를 반복 횟수를 두 배씩 늘리며 호출하고, min_time을 넘긴 마지막 측정으로 ns/op를 낸다
+// - 멀티스레드 벤치는 measureTotal()로 (작업 수, 경과 시간)을 직접 보고한다
+class BenchRunner
+{
+public:
+    explicit BenchRunner(BenchConfig config) : config_(std::move(config)) {}
+
+    bool selected(const std::string &name) const
+    {
+        return config_.filter.empty() || name.find(config_.filter) != std::string::npos;
+    }
+
+    void run(const std::string &name, const std::function<void(uint64_t)> &fn, std::string note = "")
+    {
+        if (!selected(name))
+            return;
+
+        uint64_t iters = 1;
+        double elapsed = 0.0;
+        while (true)
+        {
+            auto t0 = std::chrono::steady_clock::now();
+            fn(iters);
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            if (elapsed >= config_.min_time_sec || iters >= (1ull << 34))
+                break;
+            // 목표 시간에 맞춰 다음 반복 횟수 추정 (최대 10배)
+            double scale = elapsed > 0 ? config_.min_time_sec * 1.2 / elapsed : 10.0;
+            if (scale > 10.0)
+                scale = 10.0;
+            if (scale < 2.0)
+                scale = 2.0;
+            iters = static_cast<uint64_t>(static_cast<double>(iters) * scale);
+        }
+        report(name, iters, elapsed, std::move(note));
+    }
+
+    // 작업 수와 경과 시간을 직접 측정하는 벤치 (멀티스레드 큐 등)
+    void measureTotal(const std::string &name, const std::function<double(uint64_t)> &fn, uint64_t ops,
+                      std::string note = "")
+    {
+        if (!selected(name))
+            return;
+        double elapsed = fn(ops);
+        report(name, ops, elapsed, std::move(note));
+    }
+
+    const std::vector<BenchResult> &results() const { return results_; }
+
+    void printTable() const
+    {
+        std::printf("%-48s %14s %14s %16s  %s\n", "benchmark", "iterations", "ns/op", "ops/s", "note");
+        for (auto &r : results_)
+        {
+            std::printf("%-48s %14llu %14.1f %16.0f  %s\n", r.name.c_str(),
+                        static_cast<unsigned long long>(r.iterations), r.ns_per_op, r.ops_per_sec, r.note.c_str());
+        }
+    }
+
+    void printJson() const
+    {
+        std::printf("[\n");
+        for (size_t i = 0; i < results_.size(); ++i)
+        {
+            auto &r = results_[i];
+            std::printf("  {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, \"ops_per_sec\": %.1f, \"note\": \"%s\"}%s\n",
+                        r.name.c_str(), static_cast<unsigned long long>(r.iterations), r.ns_per_op, r.ops_per_sec,
+                        r.note.c_str(), i + 1 < results_.size() ? "," : "");
+        }
+        std::printf("]\n");
+    }
+
+private:
+    void report(const std::string &name, uint64_t iters, double elapsed, std::string note)
+    {
+        BenchResult r;
+        r.name = name;
+        r.iterations = iters;
+        r.ns_per_op = iters ? elapsed * 1e9 / static_cast<double>(iters) : 0.0;
+        r.ops_per_sec = elapsed > 0 ? static_cast<double>(iters) / elapsed : 0.0;
+        r.note = std::move(note);
+        std::fprintf(stderr, "  %-48s %10.1f ns/op\n", name.c_str(), r.ns_per_op);
+        results_.push_back(std::move(r));
+    }
+
+    BenchConfig config_;
+    std::vector<BenchResult> results_;
+};
+
+} // namespace msgnet::bench
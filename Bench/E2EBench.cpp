@@ -0,0 +1,921 @@
+// msgnet_e2ebench: 같은 프로세스 안에서 TcpServer를 루프백 임시 포트로 띄우고 부하를 걸어
+// 스레드 구성 / 요청 타입 / payload 크기 조합별 결과를 JSON 또는 CSV로 남긴다.
+//
+// - 조합마다 서버를 새로 만들고 (port 0), 클라이언트 스레드가 각자 연결 하나로 depth개를 파이프라이닝한다
+// - 지표: 처리량, p50/p99/p999 지연, 요청당 CPU 시간 (서버 / 전체), 조합별 최대 RSS
+// - --baseline 이전결과.json을 주면 같은 조합끼리 비교해서 허용치 이상 나빠지면 종료 코드 2
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "json.hpp"
+#include "ExampleMessageHandler.h"
+#include "Frame.h"
+#include "LatencyHistogram.h"
+#include "Logger.h"
+#include "ShmTransport.h"
+#include "SocketAddress.h"
+#include "TcpServer.h"
+
+using namespace std;
+using namespace msgnet;
+using nlohmann::json;
+
+namespace
+{
+
+struct BenchOptions
+{
+    vector<int> recv_threads = {4};
+    vector<int> process_threads = {4};
+    vector<int> send_threads = {1};
+    vector<string> types = {"ping", "echo"};
+    vector<int> batches = {1};           // 프레임 하나에 담는 요청 수 (1보다 크면 JSON 배열 배치 프레임)
+    vector<string> transports = {"tcp"}; // tcp | unix (abstract namespace) | shm (unix + 공유 메모리 링)
+    vector<size_t> sizes = {16, 4096};
+    int clients = 8;
+    int depth = 1;
+    double duration_sec = 2.0;
+    double warmup_sec = 0.5;
+    string format = "table"; // table | json | csv
+    string out_path;         // 비어 있으면 stdout
+    string label;            // 결과에 같이 기록 (예: 커밋 해시)
+    string baseline_path;
+    double tolerance = 0.10; // baseline 대비 허용 악화 비율
+};
+
+// 조합 하나의 측정 결과
+struct RunResult
+{
+    int recv_threads = 0;
+    int process_threads = 0;
+    int send_threads = 0;
+    string type;
+    size_t payload_bytes = 0;
+    size_t request_bytes = 0; // 요청 프레임 하나 (배치면 배열 전체)
+    int batch = 1;
+    string transport = "tcp";
+
+    uint64_t completed = 0;
+    uint64_t errors = 0;
+    uint64_t conn_failures = 0;
+    double elapsed_sec = 0.0;
+    double throughput = 0.0;
+    LatencySummary latency;
+    double cpu_us_per_req = 0.0;        // 프로세스 전체 (서버 + 클라이언트)
+    double server_cpu_us_per_req = 0.0; // 전체 - 클라이언트 스레드
+    long peak_rss_kb = 0;
+
+    string key() const
+    {
+        return "r" + to_string(recv_threads) + "/p" + to_string(process_threads) + "/s" + to_string(send_threads) +
+               "/" + type + "/" + to_string(payload_bytes) + (batch > 1 ? "/b" + to_string(batch) : "") +
+               (transport == "tcp" ? "" : "/" + transport);
+    }
+};
+
+void usage(const char *prog)
+{
+    cerr << "Usage: " << prog << " [options]\n"
+         << "  --recv-threads L       comma list to sweep (default 4)\n"
+         << "  --process-threads L    comma list to sweep (default 4)\n"
+         << "  --send-threads L       comma list to sweep (default 1)\n"
+         << "  --types L              ping,echo,add (default ping,echo)\n"
+         << "  --transports L         tcp,unix,shm (default tcp; unix/shm use an abstract socket)\n"
+         << "  --sizes L              payload bytes, k/m suffix allowed (default 16,4k; max 4m)\n"
+         << "  --batch L              requests per frame to sweep, >1 sends JSON array frames (default 1)\n"
+         << "  --clients N            client threads, one connection each (default 8)\n"
+         << "  --depth D              in-flight requests per connection (default 1)\n"
+         << "  --duration S           measured seconds per run (default 2)\n"
+         << "  --warmup S             warmup seconds per run (default 0.5)\n"
+         << "  --format table|json|csv\n"
+         << "  --out FILE             write results to FILE instead of stdout\n"
+         << "  --label TEXT           tag stored with the results (e.g. commit id)\n"
+         << "  --baseline FILE        compare with a previous --format json result\n"
+         << "  --tolerance F          allowed regression ratio vs baseline (default 0.10)\n";
+}
+
+vector<string> splitList(const string &s)
+{
+    vector<string> out;
+    stringstream ss(s);
+    string item;
+    while (getline(ss, item, ','))
+    {
+        if (!item.empty())
+            out.push_back(item);
+    }
+    return out;
+}
+
+size_t parseSize(const string &s)
+{
+    size_t mult = 1;
+    string num = s;
+    const char last = s.empty() ? '\0' : static_cast<char>(tolower(s.back()));
+    if (last == 'k')
+        mult = 1024;
+    else if (last == 'm')
+        mult = 1024 * 1024;
+    if (mult != 1)
+        num.pop_back();
+    return static_cast<size_t>(stoull(num)) * mult;
+}
+
+bool parseArgs(int argc, char **argv, BenchOptions &o)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        string a = argv[i];
+        auto next = [&]() -> const char *
+        {
+            if (i + 1 >= argc)
+                throw invalid_argument("missing value for " + a);
+            return argv[++i];
+        };
+        auto intList = [&]()
+        {
+            vector<int> v;
+            for (auto &s : splitList(next()))
+                v.push_back(stoi(s));
+            return v;
+        };
+
+        if (a == "--recv-threads")
+            o.recv_threads = intList();
+        else if (a == "--process-threads")
+            o.process_threads = intList();
+        else if (a == "--send-threads")
+            o.send_threads = intList();
+        else if (a == "--types")
+            o.types = splitList(next());
+        else if (a == "--transports")
+            o.transports = splitList(next());
+        else if (a == "--sizes")
+        {
+            o.sizes.clear();
+            for (auto &s : splitList(next()))
+                o.sizes.push_back(parseSize(s));
+        }
+        else if (a == "--batch")
+            o.batches = intList();
+        else if (a == "--clients")
+            o.clients = stoi(next());
+        else if (a == "--depth")
+            o.depth = stoi(next());
+        else if (a == "--duration")
+            o.duration_sec = stod(next());
+        else if (a == "--warmup")
+            o.warmup_sec = stod(next());
+        else if (a == "--format")
+            o.format = next();
+        else if (a == "--out")
+            o.out_path = next();
+        else if (a == "--label")
+            o.label = next();
+        else if (a == "--baseline")
+            o.baseline_path = next();
+        else if (a == "--tolerance")
+            o.tolerance = stod(next());
+        else
+        {
+            usage(argv[0]);
+            return false;
+        }
+    }
+
+    if (o.clients < 1 || o.depth < 1)
+        throw invalid_argument("clients/depth must be positive");
+    if (o.format != "table" && o.format != "json" && o.format != "csv")
+        throw invalid_argument("unknown format: " + o.format);
+    for (const string &t : o.types)
+    {
+        if (t != "ping" && t != "echo" && t != "add")
+            throw invalid_argument("unknown type: " + t);
+    }
+    if (o.transports.empty())
+        throw invalid_argument("transport list is empty");
+    for (const string &t : o.transports)
+    {
+        if (t != "tcp" && t != "unix" && t != "shm")
+            throw invalid_argument("unknown transport: " + t);
+    }
+    for (auto *list : {&o.recv_threads, &o.process_threads, &o.send_threads, &o.batches})
+    {
+        if (list->empty())
+            throw invalid_argument("thread count/batch list is empty");
+        for (int n : *list)
+        {
+            if (n < 1)
+                throw invalid_argument("thread counts and batch sizes must be positive");
+        }
+    }
+    return true;
+}
+
+// 요청 본문은 req_id만 바꿔 끼우도록 앞/뒤 조각으로 미리 만들어 둔다
+// - payload.pad에 크기만큼 'x'를 채운다 (echo는 그대로 돌려주므로 응답도 같은 크기)
+// - 프레임 상한(kMaxFrameSize)을 넘지 않도록 JSON 오버헤드만큼 pad를 줄인다
+struct RequestTemplate
+{
+    string head; // ... "req_id":
+    string tail; // } 까지
+
+    size_t bodySize(uint64_t req_id) const
+    {
+        return head.size() + to_string(req_id).size() + tail.size();
+    }
+};
+
+RequestTemplate makeTemplate(const string &type, size_t payload_bytes)
+{
+    constexpr size_t kOverhead = 128;
+    const size_t pad = min(payload_bytes, static_cast<size_t>(kMaxFrameSize) - kOverhead);
+
+    RequestTemplate t;
+    t.head = "{\"type\":\"" + type + "\",\"payload\":{";
+    if (type == "add")
+        t.head += "\"a\":2,\"b\":3,";
+    t.head += "\"pad\":\"" + string(pad, 'x') + "\"},\"req_id\":";
+    t.tail = "}";
+    return t;
+}
+
+void appendRequest(string &out, const RequestTemplate &t, uint64_t req_id)
+{
+    const string id = to_string(req_id);
+    const uint32_t len_net = htonl(static_cast<uint32_t>(t.head.size() + id.size() + t.tail.size()));
+    out.append(reinterpret_cast<const char *>(&len_net), sizeof(len_net));
+    out += t.head;
+    out += id;
+    out += t.tail;
+}
+
+// 요청 batch개를 프레임 하나로 (1이면 객체 그대로, 아니면 JSON 배열). req_id는 first_id부터 연속
+void appendRequests(string &out, const RequestTemplate &t, uint64_t first_id, int batch)
+{
+    if (batch == 1)
+    {
+        appendRequest(out, t, first_id);
+        return;
+    }
+    string body = "[";
+    for (int i = 0; i < batch; ++i)
+    {
+        if (i > 0)
+            body += ',';
+        body += t.head;
+        body += to_string(first_id + static_cast<uint64_t>(i));
+        body += t.tail;
+    }
+    body += ']';
+    appendFrame(out, body);
+}
+
+bool parseReqIdAt(string_view body, size_t pos, uint64_t &req_id)
+{
+    size_t i = pos;
+    uint64_t v = 0;
+    bool any = false;
+    while (i < body.size() && body[i] >= '0' && body[i] <= '9')
+    {
+        v = v * 10 + static_cast<uint64_t>(body[i] - '0');
+        ++i;
+        any = true;
+    }
+    req_id = v;
+    return any;
+}
+
+// 응답에서 req_id와 ok만 꺼낸다 (dump()는 키를 정렬하므로 "ok"가 맨 앞, req_id는 payload 뒤)
+bool scanResponse(string_view body, uint64_t &req_id, bool &ok)
+{
+    ok = body.rfind("{\"ok\":true", 0) == 0;
+    const string_view key = "\"req_id\":";
+    const size_t pos = body.rfind(key);
+    if (pos == string_view::npos)
+        return false;
+    return parseReqIdAt(body, pos + key.size(), req_id);
+}
+
+// 배치 응답이면 요소 수와 성공 수를 세고, 첫 요소의 req_id(= 요청 프레임의 첫 id)를 꺼낸다
+bool scanResponses(string_view body, uint64_t &first_req_id, size_t &count, size_t &ok_count)
+{
+    if (body.empty() || body[0] != '[')
+    {
+        bool ok = false;
+        if (!scanResponse(body, first_req_id, ok))
+            return false;
+        count = 1;
+        ok_count = ok ? 1 : 0;
+        return true;
+    }
+
+    count = 0;
+    ok_count = 0;
+    for (size_t pos = body.find("{\"ok\":"); pos != string_view::npos; pos = body.find("{\"ok\":", pos + 6))
+    {
+        ++count;
+        if (body.compare(pos, 10, "{\"ok\":true") == 0)
+            ++ok_count;
+    }
+    const string_view key = "\"req_id\":";
+    const size_t pos = body.find(key);
+    return count > 0 && pos != string_view::npos && parseReqIdAt(body, pos + key.size(), first_req_id);
+}
+
+double threadCpuSec()
+{
+    timespec ts{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+}
+
+double processCpuSec()
+{
+    timespec ts{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+}
+
+// 최대 RSS를 현재 값으로 되돌린다 (Linux 4.0+). 실패하면 프로세스 전체 최대치가 그대로 남는다.
+void resetPeakRss()
+{
+    int fd = ::open("/proc/self/clear_refs", O_WRONLY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+    ssize_t ignored = ::write(fd, "5", 1);
+    (void)ignored;
+    ::close(fd);
+}
+
+long peakRssKb()
+{
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line))
+    {
+        if (line.rfind("VmHWM:", 0) == 0)
+            return stol(line.substr(6));
+    }
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+struct ClientResult
+{
+    LatencyHistogram latency;
+    uint64_t completed = 0;
+    uint64_t errors = 0;
+    bool conn_failed = false;
+    double cpu_sec = 0.0; // 측정 구간 동안 이 스레드의 CPU 시간
+};
+
+struct RunClock
+{
+    int64_t measure_start_ns = 0;
+    int64_t measure_end_ns = 0;
+    atomic<bool> go{false};
+};
+
+// 응답 프레임 하나를 완료 처리 (배치면 요소 수만큼, 지연은 프레임 왕복 시간으로 기록)
+void completeResponse(string_view body, unordered_map<uint64_t, int64_t> &inflight, const RunClock &clock,
+                      ClientResult &result)
+{
+    uint64_t req_id = 0;
+    size_t count = 0;
+    size_t ok_count = 0;
+    if (!scanResponses(body, req_id, count, ok_count))
+        return;
+    auto it = inflight.find(req_id);
+    if (it == inflight.end())
+        return;
+    const int64_t sent_ns = it->second;
+    inflight.erase(it);
+
+    if (sent_ns >= clock.measure_start_ns)
+    {
+        const uint64_t rtt = static_cast<uint64_t>(monotonicNowNs() - sent_ns);
+        for (size_t i = 0; i < count; ++i)
+            result.latency.record(rtt);
+        result.completed += count;
+        result.errors += count - ok_count;
+    }
+}
+
+// 연결 하나를 non-blocking으로 돌리며 프레임 depth개를 in-flight로 유지
+void clientLoop(SocketAddress addr, const RequestTemplate &tmpl, int depth, int batch, int client_index,
+                RunClock &clock, ClientResult &result)
+{
+    int fd = ::socket(addr.family(), SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::connect(fd, addr.get(), addr.length) < 0)
+    {
+        result.conn_failed = true;
+        if (fd >= 0)
+            ::close(fd);
+        return;
+    }
+    if (addr.family() == AF_INET)
+    {
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    while (!clock.go.load(memory_order_acquire))
+        this_thread::yield();
+
+    string out;
+    size_t out_off = 0;
+    string in;
+    size_t in_off = 0;
+    unordered_map<uint64_t, int64_t> inflight; // req_id -> 전송 시각
+    uint64_t next_seq = 0;
+    const uint64_t id_base = static_cast<uint64_t>(client_index) << 40;
+    double cpu_at_start = -1.0;
+    bool failed = false;
+
+    while (!failed)
+    {
+        const int64_t now = monotonicNowNs();
+        if (cpu_at_start < 0 && now >= clock.measure_start_ns)
+            cpu_at_start = threadCpuSec();
+        if (now >= clock.measure_end_ns)
+            break;
+
+        // 빈 자리만큼 요청 추가
+        while (static_cast<int>(inflight.size()) < depth)
+        {
+            const uint64_t req_id = id_base | next_seq;
+            next_seq += static_cast<uint64_t>(batch);
+            appendRequests(out, tmpl, req_id, batch);
+            inflight.emplace(req_id, monotonicNowNs()); // 배치는 첫 req_id로 추적
+        }
+
+        // 쓸 게 있으면 먼저 밀어 넣기
+        while (out_off < out.size())
+        {
+            ssize_t s = ::send(fd, out.data() + out_off, out.size() - out_off, MSG_NOSIGNAL);
+            if (s > 0)
+            {
+                out_off += static_cast<size_t>(s);
+                continue;
+            }
+            if (s < 0 && errno == EINTR)
+                continue;
+            if (s < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            failed = true;
+            break;
+        }
+        if (out_off == out.size())
+        {
+            out.clear();
+            out_off = 0;
+        }
+
+        pollfd pfd{fd, static_cast<short>(POLLIN | (out.empty() ? 0 : POLLOUT)), 0};
+        int ready = ::poll(&pfd, 1, 10);
+        if (ready <= 0 || !(pfd.revents & (POLLIN | POLLERR | POLLHUP)))
+            continue;
+
+        char buf[64 * 1024];
+        while (true)
+        {
+            ssize_t r = ::recv(fd, buf, sizeof(buf), 0);
+            if (r > 0)
+            {
+                in.append(buf, static_cast<size_t>(r));
+                continue;
+            }
+            if (r < 0 && errno == EINTR)
+                continue;
+            if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            failed = true; // EOF 또는 에러
+            break;
+        }
+
+        // 완성된 응답 프레임 처리
+        while (true)
+        {
+            string_view body;
+            FrameStatus st = decodeFrame(in.data() + in_off, in.size() - in_off, body);
+            if (st == FrameStatus::INCOMPLETE)
+                break;
+            if (st == FrameStatus::INVALID_LENGTH)
+            {
+                failed = true;
+                break;
+            }
+            in_off += kFrameHeaderSize + body.size();
+            completeResponse(body, inflight, clock, result);
+        }
+        if (in_off == in.size())
+        {
+            in.clear();
+            in_off = 0;
+        }
+        else if (in_off > (1u << 20))
+        {
+            in.erase(0, in_off);
+            in_off = 0;
+        }
+    }
+
+    if (cpu_at_start >= 0)
+        result.cpu_sec = threadCpuSec() - cpu_at_start;
+    result.conn_failed = failed && result.completed == 0;
+    ::close(fd);
+}
+
+// 공유 메모리 전송: 유닉스 소켓으로 붙어 링으로 전환한 뒤 응답 링을 돌며 기다린다
+// - 코어가 여럿이면 바쁜 대기 (응답 대기에 시스템 콜 없음), 하나뿐이면 바로 eventfd로 잠든다
+void shmClientLoop(SocketAddress addr, const RequestTemplate &tmpl, int depth, int batch, int client_index,
+                   RunClock &clock, ClientResult &result)
+{
+    ShmChannel channel;
+    int fd = ::socket(addr.family(), SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::connect(fd, addr.get(), addr.length) < 0 || !ShmChannel::clientAttach(fd, channel))
+    {
+        result.conn_failed = true;
+        if (fd >= 0)
+            ::close(fd);
+        return;
+    }
+
+    while (!clock.go.load(memory_order_acquire))
+        this_thread::yield();
+
+    string frame;
+    string scratch;
+    unordered_map<uint64_t, int64_t> inflight; // req_id -> 전송 시각
+    uint64_t next_seq = 0;
+    const uint64_t id_base = static_cast<uint64_t>(client_index) << 40;
+    double cpu_at_start = -1.0;
+    bool failed = false;
+    const int64_t spin_ns = thread::hardware_concurrency() > 1 ? 50000 : 0;
+    int64_t idle_since = monotonicNowNs();
+
+    while (!failed)
+    {
+        const int64_t now = monotonicNowNs();
+        if (cpu_at_start < 0 && now >= clock.measure_start_ns)
+            cpu_at_start = threadCpuSec();
+        if (now >= clock.measure_end_ns)
+            break;
+
+        while (!failed && static_cast<int>(inflight.size()) < depth)
+        {
+            const uint64_t req_id = id_base | next_seq;
+            next_seq += static_cast<uint64_t>(batch);
+            frame.clear();
+            appendRequests(frame, tmpl, req_id, batch);
+            inflight.emplace(req_id, monotonicNowNs());
+            failed = !ShmChannel::writeFrame(channel.c2s(), channel.toServerFd(), frame, 1000);
+        }
+
+        while (!failed)
+        {
+            string_view body;
+            FrameStatus st = channel.s2c().peekFrame(body, scratch);
+            if (st == FrameStatus::INCOMPLETE)
+            {
+                // 빈 자리가 있으면 먼저 다음 요청을 보낸다
+                if (static_cast<int>(inflight.size()) < depth)
+                    break;
+                if (monotonicNowNs() - idle_since < spin_ns)
+                {
+                    cpuRelax();
+                }
+                else
+                {
+                    if (channel.s2c().prepareSleep())
+                    {
+                        pollfd pfd{channel.toClientFd(), POLLIN, 0};
+                        if (::poll(&pfd, 1, 10) > 0)
+                            ShmChannel::drain(channel.toClientFd());
+                    }
+                    channel.s2c().endSleep();
+                    idle_since = monotonicNowNs();
+                }
+                break;
+            }
+            idle_since = monotonicNowNs();
+            if (st == FrameStatus::INVALID_LENGTH)
+            {
+                failed = true;
+                break;
+            }
+
+            completeResponse(body, inflight, clock, result);
+            channel.s2c().consume(kFrameHeaderSize + body.size());
+        }
+    }
+
+    if (cpu_at_start >= 0)
+        result.cpu_sec = threadCpuSec() - cpu_at_start;
+    result.conn_failed = failed && result.completed == 0;
+    ::close(fd);
+}
+
+RunResult runOne(const BenchOptions &o, const string &transport, int recv_threads, int process_threads,
+                 int send_threads, const string &type, size_t payload_bytes, int batch)
+{
+    RunResult res;
+    res.batch = batch;
+    res.transport = transport;
+    res.recv_threads = recv_threads;
+    res.process_threads = process_threads;
+    res.send_threads = send_threads;
+    res.type = type;
+    res.payload_bytes = payload_bytes;
+
+    const RequestTemplate tmpl = makeTemplate(type, payload_bytes);
+    string sample;
+    appendRequests(sample, tmpl, 0, batch);
+    res.request_bytes = sample.size();
+
+    resetPeakRss();
+
+    // unix/shm은 abstract 이름이라 정리할 파일이 없다. 실행마다 이름을 바꿔 이전 서버와 겹치지 않게 한다
+    static int run_index = 0;
+    const string unix_path = "@msgnet-e2e-" + to_string(::getpid()) + "-" + to_string(run_index++);
+
+    auto server = make_unique<TcpServer>();
+    if (transport != "tcp")
+        server->addListenUnixPath(unix_path);
+    else
+        server->addListenAddress("127.0.0.1", 0);
+    server->setRecvThreadCount(recv_threads);
+    server->setProcessThreadCount(process_threads);
+    server->setSendThreadCount(send_threads);
+    server->addMessageHandler("ping", ExampleMessageHandler::handlePing);
+    server->addMessageHandler("echo", ExampleMessageHandler::handleEcho);
+    server->addMessageHandler("add", ExampleMessageHandler::handleAdd);
+    if (!server->start())
+        throw runtime_error("server failed to start");
+
+    SocketAddress addr;
+    if (transport != "tcp")
+        SocketAddress::fromUnixPath(unix_path, addr);
+    else
+        SocketAddress::fromTcp("127.0.0.1", server->port(), addr);
+
+    RunClock clock;
+    vector<unique_ptr<ClientResult>> results;
+    vector<thread> clients;
+    for (int i = 0; i < o.clients; ++i)
+    {
+        results.push_back(make_unique<ClientResult>());
+        clients.emplace_back(transport == "shm" ? shmClientLoop : clientLoop, addr, cref(tmpl), o.depth, batch, i, ref(clock), ref(*results.back()));
+    }
+
+    const int64_t t0 = monotonicNowNs();
+    clock.measure_start_ns = t0 + static_cast<int64_t>(o.warmup_sec * 1e9);
+    clock.measure_end_ns = clock.measure_start_ns + static_cast<int64_t>(o.duration_sec * 1e9);
+    clock.go.store(true, memory_order_release);
+
+    // 측정 구간의 프로세스 CPU 시간
+    this_thread::sleep_until(chrono::steady_clock::time_point(chrono::nanoseconds(clock.measure_start_ns)));
+    const double cpu_start = processCpuSec();
+    this_thread::sleep_until(chrono::steady_clock::time_point(chrono::nanoseconds(clock.measure_end_ns)));
+    const double cpu_end = processCpuSec();
+
+    for (auto &t : clients)
+        t.join();
+    server->stop();
+    server.reset();
+
+    HistogramSnapshot merged;
+    double client_cpu = 0.0;
+    for (auto &r : results)
+    {
+        merged.merge(r->latency);
+        res.completed += r->completed;
+        res.errors += r->errors;
+        res.conn_failures += r->conn_failed ? 1 : 0;
+        client_cpu += r->cpu_sec;
+    }
+
+    res.elapsed_sec = o.duration_sec;
+    res.throughput = static_cast<double>(res.completed) / o.duration_sec;
+    res.latency = merged.summary();
+    if (res.completed > 0)
+    {
+        const double total_cpu = cpu_end - cpu_start;
+        res.cpu_us_per_req = total_cpu * 1e6 / static_cast<double>(res.completed);
+        res.server_cpu_us_per_req = max(0.0, total_cpu - client_cpu) * 1e6 / static_cast<double>(res.completed);
+    }
+    res.peak_rss_kb = peakRssKb();
+    return res;
+}
+
+json toJson(const RunResult &r)
+{
+    return {
+        {"key", r.key()},
+        {"recv_threads", r.recv_threads},
+        {"process_threads", r.process_threads},
+        {"send_threads", r.send_threads},
+        {"type", r.type},
+        {"transport", r.transport},
+        {"payload_bytes", r.payload_bytes},
+        {"request_bytes", r.request_bytes},
+        {"batch", r.batch},
+        {"completed", r.completed},
+        {"errors", r.errors},
+        {"conn_failures", r.conn_failures},
+        {"duration_sec", r.elapsed_sec},
+        {"throughput_rps", r.throughput},
+        {"latency_us",
+         {{"mean", r.latency.mean_ns / 1e3},
+          {"p50", static_cast<double>(r.latency.p50_ns) / 1e3},
+          {"p99", static_cast<double>(r.latency.p99_ns) / 1e3},
+          {"p999", static_cast<double>(r.latency.p999_ns) / 1e3},
+          {"max", static_cast<double>(r.latency.max_ns) / 1e3}}},
+        {"cpu_us_per_req", r.cpu_us_per_req},
+        {"server_cpu_us_per_req", r.server_cpu_us_per_req},
+        {"peak_rss_kb", r.peak_rss_kb},
+    };
+}
+
+string isoNow()
+{
+    time_t t = time(nullptr);
+    tm tm{};
+    gmtime_r(&t, &tm);
+    char buf[32];
+    strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &tm);
+    return buf;
+}
+
+void writeResults(ostream &os, const BenchOptions &o, const vector<RunResult> &results)
+{
+    if (o.format == "json")
+    {
+        json doc;
+        doc["label"] = o.label;
+        doc["timestamp"] = isoNow();
+        doc["cpus"] = thread::hardware_concurrency();
+        doc["clients"] = o.clients;
+        doc["depth"] = o.depth;
+        doc["results"] = json::array();
+        for (const RunResult &r : results)
+            doc["results"].push_back(toJson(r));
+        os << doc.dump(2) << '\n';
+        return;
+    }
+
+    if (o.format == "csv")
+    {
+        os << "label,transport,batch,recv_threads,process_threads,send_threads,type,payload_bytes,completed,errors,"
+              "throughput_rps,p50_us,p99_us,p999_us,cpu_us_per_req,server_cpu_us_per_req,peak_rss_kb\n";
+        for (const RunResult &r : results)
+        {
+            os << o.label << ',' << r.transport << ',' << r.batch << ',' << r.recv_threads << ',' << r.process_threads << ',' << r.send_threads << ','
+               << r.type << ',' << r.payload_bytes << ',' << r.completed << ',' << r.errors << ','
+               << r.throughput << ',' << r.latency.p50_ns / 1e3 << ',' << r.latency.p99_ns / 1e3 << ','
+               << r.latency.p999_ns / 1e3 << ',' << r.cpu_us_per_req << ',' << r.server_cpu_us_per_req << ','
+               << r.peak_rss_kb << '\n';
+        }
+        return;
+    }
+
+    char line[256];
+    snprintf(line, sizeof(line), "%-28s %12s %10s %10s %10s %10s %10s %10s\n", "config", "req/s", "p50(us)",
+             "p99(us)", "p999(us)", "cpu/req", "srv/req", "rss(KB)");
+    os << line;
+    for (const RunResult &r : results)
+    {
+        snprintf(line, sizeof(line), "%-28s %12.0f %10.1f %10.1f %10.1f %10.2f %10.2f %10ld%s\n", r.key().c_str(),
+                 r.throughput, r.latency.p50_ns / 1e3, r.latency.p99_ns / 1e3, r.latency.p999_ns / 1e3,
+                 r.cpu_us_per_req, r.server_cpu_us_per_req, r.peak_rss_kb, r.errors ? "  (errors)" : "");
+        os << line;
+    }
+}
+
+// baseline과 같은 key끼리 비교. 처리량이 떨어지거나 p99가 늘어난 비율이 tolerance를 넘으면 회귀로 본다.
+int compareBaseline(const BenchOptions &o, const vector<RunResult> &results)
+{
+    ifstream in(o.baseline_path);
+    if (!in)
+    {
+        cerr << "[e2ebench] Cannot open baseline " << o.baseline_path << "\n";
+        return 1;
+    }
+    json base = json::parse(in, nullptr, false);
+    if (base.is_discarded() || !base.contains("results"))
+    {
+        cerr << "[e2ebench] Invalid baseline " << o.baseline_path << "\n";
+        return 1;
+    }
+
+    unordered_map<string, json> by_key;
+    for (auto &r : base["results"])
+        by_key[r.value("key", "")] = r;
+
+    int regressions = 0;
+    for (const RunResult &r : results)
+    {
+        auto it = by_key.find(r.key());
+        if (it == by_key.end())
+            continue;
+        const double base_tput = it->second.value("throughput_rps", 0.0);
+        const double base_p99 = it->second["latency_us"].value("p99", 0.0);
+        const double p99 = r.latency.p99_ns / 1e3;
+
+        const bool tput_bad = base_tput > 0 && r.throughput < base_tput * (1.0 - o.tolerance);
+        const bool p99_bad = base_p99 > 0 && p99 > base_p99 * (1.0 + o.tolerance);
+        char line[256];
+        snprintf(line, sizeof(line), "[e2ebench] %-28s req/s %10.0f -> %10.0f  p99 %8.1f -> %8.1f us%s\n",
+                 r.key().c_str(), base_tput, r.throughput, base_p99, p99, (tput_bad || p99_bad) ? "  REGRESSION" : "");
+        cerr << line;
+        if (tput_bad || p99_bad)
+            ++regressions;
+    }
+    return regressions ? 2 : 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    BenchOptions opt;
+    try
+    {
+        if (!parseArgs(argc, argv, opt))
+            return 1;
+    }
+    catch (const exception &e)
+    {
+        cerr << "Argument error: " << e.what() << "\n";
+        usage(argv[0]);
+        return 1;
+    }
+
+    // 연결/해제 INFO 로그가 측정을 흐리지 않게
+    Logger::instance().setLevel(LogLevel::WARN);
+
+    vector<RunResult> results;
+    for (const string &transport : opt.transports)
+        for (int rt : opt.recv_threads)
+            for (int pt : opt.process_threads)
+                for (int st : opt.send_threads)
+                    for (const string &type : opt.types)
+                        for (size_t size : opt.sizes)
+                            for (int batch : opt.batches)
+                            {
+                                try
+                                {
+                                    RunResult r = runOne(opt, transport, rt, pt, st, type, size, batch);
+                                    cerr << "[e2ebench] " << r.key() << ": " << static_cast<uint64_t>(r.throughput)
+                                         << " req/s, p99 " << r.latency.p99_ns / 1000 << " us\n";
+                                    results.push_back(move(r));
+                                }
+                                catch (const exception &e)
+                                {
+                                    cerr << "[e2ebench] run failed: " << e.what() << "\n";
+                                    return 1;
+                                }
+                            }
+
+    if (opt.out_path.empty())
+    {
+        writeResults(cout, opt, results);
+    }
+    else
+    {
+        ofstream out(opt.out_path);
+        if (!out)
+        {
+            cerr << "[e2ebench] Cannot write " << opt.out_path << "\n";
+            return 1;
+        }
+        writeResults(out, opt, results);
+    }
+
+    if (!opt.baseline_path.empty())
+        return compareBaseline(opt, results);
+    return 0;
+}
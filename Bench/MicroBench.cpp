@@ -0,0 +1,341 @@
+// msgnet_microbench: 서버 내부 구성 요소를 각각 따로 측정한다.
+//
+// 사용법: msgnet_microbench [--filter <substr>] [--min-time <sec>] [--json]
+//
+// - ThreadSafeQueue push/pop (생산자 x 소비자 1x1 .. NxN)
+// - Dispatcher::dispatch (조회 + 핸들러 호출)
+// - JSON parse / dump (16B ~ 1MB payload)
+// - Logger (런타임 비활성 레벨, 동기 출력, 비동기 링)
+// - 프레임 encode / decode
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "json.hpp"
+#include "BenchHarness.h"
+#include "Dispatcher.h"
+#include "ExampleMessageHandler.h"
+#include "Frame.h"
+#include "Logger.h"
+#include "Message.h"
+#include "ThreadSafeQueue.h"
+
+using namespace std;
+using namespace msgnet;
+using namespace msgnet::bench;
+using nlohmann::json;
+
+namespace
+{
+
+// 출력을 버리는 streambuf (동기 로그 경로 측정용)
+class NullBuf : public std::streambuf
+{
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char *, std::streamsize n) override { return n; }
+};
+
+string sizeLabel(size_t bytes)
+{
+    if (bytes >= 1024 * 1024)
+        return to_string(bytes / (1024 * 1024)) + "MB";
+    if (bytes >= 1024)
+        return to_string(bytes / 1024) + "KB";
+    return to_string(bytes) + "B";
+}
+
+// 직렬화했을 때 대략 payload_bytes 크기가 되는 echo 요청
+json makeRequest(size_t payload_bytes)
+{
+    json req;
+    req["type"] = "echo";
+    req["req_id"] = 12345;
+    req["payload"] = {{"data", string(payload_bytes, 'x')}};
+    return req;
+}
+
+// ===== ThreadSafeQueue =====
+void benchQueue(BenchRunner &runner)
+{
+    const unsigned hw = max(2u, thread::hardware_concurrency());
+    vector<unsigned> pairs = {1, 2, 4, hw / 2};
+    sort(pairs.begin(), pairs.end());
+    pairs.erase(unique(pairs.begin(), pairs.end()), pairs.end());
+
+    // 단일 스레드 push+pop (경합 없는 락 비용)
+    runner.run("queue/push_pop/uncontended", [](uint64_t iters)
+               {
+                   ThreadSafeQueue<Message> q;
+                   for (uint64_t i = 0; i < iters; ++i)
+                   {
+                       q.push(Message{static_cast<int>(i), json()});
+                       auto m = q.try_pop();
+                       doNotOptimize(m);
+                   } });
+
+    for (unsigned n : pairs)
+    {
+        const string name = "queue/mpmc/" + to_string(n) + "x" + to_string(n);
+        const uint64_t ops = 400000;
+        runner.measureTotal(name, [n](uint64_t total) -> double
+                            {
+                                ThreadSafeQueue<Message> q;
+                                const uint64_t per_producer = total / n;
+                                atomic<bool> go{false};
+                                vector<thread> threads;
+
+                                for (unsigned p = 0; p < n; ++p)
+                                {
+                                    threads.emplace_back([&, p]
+                                                         {
+                                                             while (!go.load(memory_order_acquire))
+                                                                 this_thread::yield();
+                                                             for (uint64_t i = 0; i < per_producer; ++i)
+                                                                 q.push(Message{static_cast<int>(p), json()});
+                                                         });
+                                }
+                                atomic<uint64_t> consumed{0};
+                                for (unsigned c = 0; c < n; ++c)
+                                {
+                                    threads.emplace_back([&]
+                                                         {
+                                                             while (!go.load(memory_order_acquire))
+                                                                 this_thread::yield();
+                                                             while (q.pop())
+                                                             {
+                                                                 if (consumed.fetch_add(1, memory_order_relaxed) + 1 == per_producer * n)
+                                                                     q.shutdown();
+                                                             }
+                                                         });
+                                }
+
+                                auto t0 = chrono::steady_clock::now();
+                                go.store(true, memory_order_release);
+                                for (auto &t : threads)
+                                    t.join();
+                                return chrono::duration<double>(chrono::steady_clock::now() - t0).count(); },
+                            ops, "ns per message (end-to-end)");
+    }
+}
+
+// ===== Dispatcher =====
+void benchDispatcher(BenchRunner &runner)
+{
+    Dispatcher dispatcher;
+    dispatcher.registerMessageHandler("ping", ExampleMessageHandler::handlePing);
+    dispatcher.registerMessageHandler("echo", ExampleMessageHandler::handleEcho);
+    dispatcher.registerMessageHandler("add", ExampleMessageHandler::handleAdd);
+
+    struct Case
+    {
+        const char *name;
+        json req;
+    };
+    const Case cases[] = {
+        {"dispatch/ping", {{"type", "ping"}, {"req_id", 1}, {"payload", json::object()}}},
+        {"dispatch/echo", {{"type", "echo"}, {"req_id", 2}, {"payload", {{"msg", "hello"}}}}},
+        {"dispatch/add", {{"type", "add"}, {"req_id", 3}, {"payload", {{"a", 10}, {"b", 20}}}}},
+        {"dispatch/unknown_type", {{"type", "nope"}, {"req_id", 4}}},
+    };
+
+    for (const Case &c : cases)
+    {
+        const Message msg{1, c.req};
+        runner.run(c.name, [&](uint64_t iters)
+                   {
+                       for (uint64_t i = 0; i < iters; ++i)
+                       {
+                           json res = dispatcher.dispatch(msg);
+                           doNotOptimize(res);
+                       } });
+    }
+}
+
+// ===== JSON =====
+void benchJson(BenchRunner &runner)
+{
+    for (size_t bytes : {size_t(16), size_t(256), size_t(4096), size_t(65536), size_t(1024 * 1024)})
+    {
+        const json req = makeRequest(bytes);
+        const string text = req.dump();
+        const string label = sizeLabel(bytes);
+
+        runner.run("json/parse/" + label, [&](uint64_t iters)
+                   {
+                       for (uint64_t i = 0; i < iters; ++i)
+                       {
+                           json j = json::parse(text, nullptr, false);
+                           doNotOptimize(j);
+                       } },
+                   to_string(text.size()) + " bytes");
+
+        runner.run("json/dump/" + label, [&](uint64_t iters)
+                   {
+                       for (uint64_t i = 0; i < iters; ++i)
+                       {
+                           string s = req.dump();
+                           doNotOptimize(s);
+                       } },
+                   to_string(text.size()) + " bytes");
+    }
+}
+
+// ===== Logger =====
+void benchLogger(BenchRunner &runner)
+{
+    Logger &logger = Logger::instance();
+    const LogLevel saved_level = logger.getLevel();
+    const int client_id = 42;
+
+    // 런타임 비활성: 레벨 검사만 하고 인자는 평가하지 않는다
+    logger.setLevel(LogLevel::WARN);
+    runner.run("logger/disabled_level", [&](uint64_t iters)
+               {
+                   for (uint64_t i = 0; i < iters; ++i)
+                       LOG_INFO("[Bench] client ", client_id, " iteration ", i); });
+
+    logger.setLevel(LogLevel::INFO);
+
+    // 동기 경로: 포맷 + 뮤텍스 + ostream (stdout은 버리는 버퍼로 교체)
+    {
+        NullBuf null_buf;
+        std::streambuf *saved = std::cout.rdbuf(&null_buf);
+        runner.run("logger/sync_info", [&](uint64_t iters)
+                   {
+                       for (uint64_t i = 0; i < iters; ++i)
+                           LOG_INFO("[Bench] client ", client_id, " iteration ", i); });
+        std::cout.rdbuf(saved);
+    }
+
+    // 비동기 경로: 스레드별 링에 포맷 (가득 차면 DROP)
+    AsyncLogConfig config;
+    config.path = "/dev/null";
+    config.overflow = LogOverflowPolicy::DROP;
+    if (logger.startAsync(config))
+    {
+        const uint64_t dropped_before = logger.droppedCount();
+        uint64_t total = 0;
+        runner.run("logger/async_info", [&](uint64_t iters)
+                   {
+                       total += iters;
+                       for (uint64_t i = 0; i < iters; ++i)
+                           LOG_INFO("[Bench] client ", client_id, " iteration ", i); });
+        const uint64_t dropped = logger.droppedCount() - dropped_before;
+        logger.stopAsync();
+        if (!runner.results().empty() && runner.results().back().name == "logger/async_info")
+        {
+            cerr << "  (async: " << dropped << " of " << total << " records dropped)\n";
+        }
+    }
+
+    logger.setLevel(saved_level);
+}
+
+// ===== Frame =====
+void benchFrame(BenchRunner &runner)
+{
+    for (size_t bytes : {size_t(16), size_t(256), size_t(4096), size_t(65536)})
+    {
+        const json req = makeRequest(bytes);
+        const string body = req.dump();
+        const string label = sizeLabel(bytes);
+
+        runner.run("frame/encode_json/" + label, [&](uint64_t iters)
+                   {
+                       for (uint64_t i = 0; i < iters; ++i)
+                       {
+                           string frame = encodeFrame(req);
+                           doNotOptimize(frame);
+                       } },
+                   "dump + length prefix");
+
+        runner.run("frame/append/" + label, [&](uint64_t iters)
+                   {
+                       string out;
+                       for (uint64_t i = 0; i < iters; ++i)
+                       {
+                           out.clear();
+                           appendFrame(out, body);
+                           doNotOptimize(out);
+                       } },
+                   "length prefix + copy");
+
+        // 여러 프레임이 이어진 수신 버퍼를 처음부터 끝까지 잘라낸다
+        string stream;
+        const size_t frames_in_buffer = max<size_t>(1, (1 << 20) / (body.size() + kFrameHeaderSize));
+        for (size_t i = 0; i < frames_in_buffer; ++i)
+            appendFrame(stream, body);
+
+        runner.run("frame/decode/" + label, [&](uint64_t iters)
+                   {
+                       size_t offset = 0;
+                       for (uint64_t i = 0; i < iters; ++i)
+                       {
+                           if (offset >= stream.size())
+                               offset = 0;
+                           string_view payload;
+                           if (decodeFrame(stream.data() + offset, stream.size() - offset, payload) != FrameStatus::COMPLETE)
+                               abort();
+                           doNotOptimize(payload);
+                           offset += kFrameHeaderSize + payload.size();
+                       } },
+                   "header parse per frame");
+    }
+}
+
+void usage(const char *prog)
+{
+    cerr << "Usage: " << prog << " [--filter <substr>] [--min-time <sec>] [--json]\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    BenchConfig config;
+    bool json_out = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const string arg = argv[i];
+        if (arg == "--json")
+            json_out = true;
+        else if (arg == "--filter" && i + 1 < argc)
+            config.filter = argv[++i];
+        else if (arg == "--min-time" && i + 1 < argc)
+            config.min_time_sec = atof(argv[++i]);
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    cerr << "[microbench] build=" <<
+#ifdef NDEBUG
+        "release"
+#else
+        "debug (numbers are not representative)"
+#endif
+         << ", log_min_level=" << MSGNET_LOG_MIN_LEVEL << "\n";
+
+    BenchRunner runner(config);
+    benchQueue(runner);
+    benchDispatcher(runner);
+    benchJson(runner);
+    benchLogger(runner);
+    benchFrame(runner);
+
+    if (json_out)
+        runner.printJson();
+    else
+        runner.printTable();
+    return 0;
+}
@@ -0,0 +1,620 @@
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "AsyncClient.h"
+#include "Frame.h"
+#include "SocketAddress.h"
+
+namespace msgnet
+{
+
+namespace
+{
+
+// requestBatch()의 응답 모음. 요소별 callback이 자기 자리를 채우고, 마지막 하나가 배치 callback을 부른다
+struct BatchState
+{
+    BatchState(size_t n, AsyncClient::ResponseCallback cb)
+        : responses(n), remaining(n), callback(std::move(cb))
+    {
+    }
+
+    void complete(size_t index, nlohmann::json res)
+    {
+        responses[index] = std::move(res);
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            callback(nlohmann::json(std::move(responses)));
+    }
+
+    std::vector<nlohmann::json> responses;
+    std::atomic<size_t> remaining;
+    AsyncClient::ResponseCallback callback;
+};
+
+} // namespace
+
+AsyncClient::AsyncClient(AsyncClientConfig config) : config_(std::move(config))
+{
+}
+
+AsyncClient::~AsyncClient()
+{
+    close();
+}
+
+bool AsyncClient::connect()
+{
+    if (connected())
+        return true;
+    // goaway 뒤이거나 I/O 루프가 끝난 연결: 남은 스레드와 fd를 먼저 정리한다 (남은 요청은 connection_closed)
+    if (io_thread_.joinable() || fd_ >= 0)
+        close();
+
+    SocketAddress addr;
+    const bool resolved = config_.unix_path.empty()
+                              ? SocketAddress::fromTcp(config_.host, config_.port, addr)
+                              : SocketAddress::fromUnixPath(config_.unix_path, addr);
+    if (!resolved)
+        return false;
+
+    fd_ = ::socket(addr.family(), SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0)
+        return false;
+    if (::connect(fd_, addr.get(), addr.length) < 0)
+    {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    // 쓰기 합치기는 직접 하므로 Nagle은 끈다
+    if (addr.family() == AF_INET)
+    {
+        int one = 1;
+        ::setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    // 공유 메모리 전환은 소켓이 아직 블로킹일 때 첫 프레임으로 한다
+    if (config_.shm)
+    {
+        auto channel = std::make_unique<ShmChannel>();
+        if (addr.family() != AF_UNIX || !ShmChannel::clientAttach(fd_, *channel))
+        {
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(shm_write_mutex_);
+        shm_ = std::move(channel);
+    }
+    ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL) | O_NONBLOCK);
+
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0)
+    {
+        close();
+        return false;
+    }
+
+    epoll_event ev{};
+    ev.events = shm_ ? EPOLLRDHUP : EPOLLIN; // shm이면 소켓은 종료만 본다
+    ev.data.fd = fd_;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd_, &ev);
+    ev.events = EPOLLIN;
+    ev.data.fd = wake_fd_;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+    if (shm_)
+    {
+        ev.data.fd = shm_->toClientFd();
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, shm_->toClientFd(), &ev);
+    }
+
+    stop_ = false;
+    wake_pending_ = false;
+    goaway_ = false;
+    connected_ = true;
+    io_thread_ = std::thread(shm_ ? &AsyncClient::shmIoLoop : &AsyncClient::ioLoop, this);
+    return true;
+}
+
+void AsyncClient::close()
+{
+    stop_ = true;
+    if (wake_fd_ >= 0)
+        wake();
+    if (io_thread_.joinable())
+        io_thread_.join();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connected_ = false;
+    }
+    {
+        // 요청 링에 쓰는 중인 request()가 끝난 뒤에 매핑을 푼다
+        std::lock_guard<std::mutex> lock(shm_write_mutex_);
+        shm_.reset();
+    }
+
+    for (int *fd : {&fd_, &epoll_fd_, &wake_fd_})
+    {
+        if (*fd >= 0)
+        {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+    failAll("connection_closed");
+
+    send_buf_.clear();
+    send_off_ = 0;
+    want_write_ = false;
+    in_.clear();
+    in_off_ = 0;
+    shm_scratch_.clear();
+}
+
+void AsyncClient::request(nlohmann::json req, ResponseCallback callback)
+{
+    nlohmann::json original_id;
+    if (req.is_object())
+    {
+        auto it = req.find("req_id");
+        if (it != req.end())
+            original_id = std::move(*it);
+    }
+
+    {
+        // connected_는 mutex_ 안에서 확인해야 I/O 스레드의 failAll()과 엇갈려 요청이 남지 않는다
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!connected_.load(std::memory_order_acquire))
+        {
+            lock.unlock();
+            callback(makeError(original_id, "not_connected"));
+            return;
+        }
+        const uint64_t id = next_req_id_++;
+        req["req_id"] = id;
+        pending_.emplace(id, Pending{std::move(original_id), std::move(callback)});
+        if (!config_.shm)
+        {
+            appendFrame(out_, req.dump());
+            lock.unlock();
+            wake();
+            return;
+        }
+    }
+
+    // shm: I/O 스레드를 거치지 않고 요청 링에 바로 쓴다
+    std::string frame;
+    appendFrame(frame, req.dump());
+    writeShm(frame);
+}
+
+void AsyncClient::requestBatch(std::vector<nlohmann::json> reqs, ResponseCallback callback)
+{
+    if (reqs.empty())
+    {
+        callback(nlohmann::json::array());
+        return;
+    }
+
+    auto batch = std::make_shared<BatchState>(reqs.size(), std::move(callback));
+    std::vector<nlohmann::json> original_ids(reqs.size());
+    for (size_t i = 0; i < reqs.size(); ++i)
+    {
+        if (!reqs[i].is_object())
+            continue;
+        auto it = reqs[i].find("req_id");
+        if (it != reqs[i].end())
+            original_ids[i] = std::move(*it);
+    }
+
+    nlohmann::json frame_json = nlohmann::json::array();
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!connected_.load(std::memory_order_acquire))
+        {
+            lock.unlock();
+            for (size_t i = 0; i < reqs.size(); ++i)
+                batch->complete(i, makeError(original_ids[i], "not_connected"));
+            return;
+        }
+        for (size_t i = 0; i < reqs.size(); ++i)
+        {
+            const uint64_t id = next_req_id_++;
+            reqs[i]["req_id"] = id;
+            pending_.emplace(id, Pending{std::move(original_ids[i]), [batch, i](nlohmann::json res)
+                                        { batch->complete(i, std::move(res)); }});
+            frame_json.push_back(std::move(reqs[i]));
+        }
+        if (!config_.shm)
+        {
+            appendFrame(out_, frame_json.dump());
+            lock.unlock();
+            wake();
+            return;
+        }
+    }
+
+    std::string frame;
+    appendFrame(frame, frame_json.dump());
+    writeShm(frame);
+}
+
+std::future<nlohmann::json> AsyncClient::requestBatch(std::vector<nlohmann::json> reqs)
+{
+    auto promise = std::make_shared<std::promise<nlohmann::json>>();
+    std::future<nlohmann::json> future = promise->get_future();
+    requestBatch(std::move(reqs), [promise](nlohmann::json responses)
+                 { promise->set_value(std::move(responses)); });
+    return future;
+}
+
+void AsyncClient::writeShm(const std::string &frame)
+{
+    std::lock_guard<std::mutex> lock(shm_write_mutex_);
+    if (!shm_)
+        return; // close() 중. 대기 요청은 failAll()이 완료시킨다
+    if (!ShmChannel::writeFrame(shm_->c2s(), shm_->toServerFd(), frame, kShmWriteTimeoutMs))
+    {
+        // 서버가 링을 비우지 않는다: 소켓을 끊어 I/O 스레드가 남은 요청을 실패 처리하게 한다
+        ::shutdown(fd_, SHUT_RDWR);
+    }
+}
+
+std::future<nlohmann::json> AsyncClient::request(nlohmann::json req)
+{
+    auto promise = std::make_shared<std::promise<nlohmann::json>>();
+    std::future<nlohmann::json> future = promise->get_future();
+    request(std::move(req), [promise](nlohmann::json response)
+            { promise->set_value(std::move(response)); });
+    return future;
+}
+
+size_t AsyncClient::outstanding() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_.size();
+}
+
+void AsyncClient::wake()
+{
+    // I/O 스레드가 아직 깨어나지 않았으면 한 번만 알린다 (요청마다 eventfd write를 하지 않게)
+    if (!wake_pending_.exchange(true, std::memory_order_acq_rel))
+    {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wake_fd_, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+void AsyncClient::ioLoop()
+{
+    epoll_event events[4];
+    bool alive = true;
+
+    while (alive && !stop_.load(std::memory_order_acquire))
+    {
+        int n = ::epoll_wait(epoll_fd_, events, 4, -1);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        for (int i = 0; i < n && alive; ++i)
+        {
+            if (events[i].data.fd == wake_fd_)
+            {
+                uint64_t v;
+                ssize_t ignored = ::read(wake_fd_, &v, sizeof(v));
+                (void)ignored;
+                wake_pending_.store(false, std::memory_order_release);
+                alive = flushWrites();
+            }
+            else
+            {
+                if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+                    alive = readAvailable();
+                if (alive && (events[i].events & EPOLLOUT))
+                    alive = flushWrites();
+            }
+        }
+        if (goaway_ && outstanding() == 0)
+            break;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connected_.store(false, std::memory_order_release);
+    }
+    if (!stop_.load(std::memory_order_acquire))
+        failAll("connection_closed");
+}
+
+void AsyncClient::shmIoLoop()
+{
+    ShmRing &ring = shm_->s2c();
+    const int to_client_fd = shm_->toClientFd();
+    const int to_server_fd = shm_->toServerFd();
+    // 코어가 하나뿐이면 바쁜 대기는 서버 스레드의 시간만 뺏으므로 바로 잠든다
+    const auto spin = std::chrono::microseconds(std::thread::hardware_concurrency() > 1 ? config_.shm_spin_us : 0);
+    auto idle_since = std::chrono::steady_clock::now();
+    epoll_event events[4];
+    bool alive = true;
+
+    while (alive && !stop_.load(std::memory_order_acquire))
+    {
+        bool progressed = false;
+        for (int n = 0; n < 64; ++n)
+        {
+            std::string_view payload;
+            FrameStatus st = ring.peekFrame(payload, shm_scratch_);
+            if (st == FrameStatus::INCOMPLETE)
+                break;
+            if (st == FrameStatus::INVALID_LENGTH)
+            {
+                alive = false;
+                break;
+            }
+            handleFrame(payload.data(), payload.size());
+            ring.consume(kFrameHeaderSize + payload.size());
+            progressed = true;
+        }
+        // 서버가 응답 링이 차서 기다리고 있었으면 비운 자리를 알린다
+        if (progressed && ring.releaseProducer())
+            ShmChannel::notify(to_server_fd);
+        if (!alive)
+            break;
+
+        if (goaway_ && outstanding() == 0)
+            break;
+
+        const auto now = std::chrono::steady_clock::now();
+        if (progressed)
+        {
+            idle_since = now;
+            continue;
+        }
+        if (now - idle_since < spin)
+        {
+            cpuRelax();
+            continue;
+        }
+
+        if (ring.prepareSleep())
+        {
+            int n = ::epoll_wait(epoll_fd_, events, 4, -1);
+            for (int i = 0; i < n; ++i)
+            {
+                const int fd = events[i].data.fd;
+                if (fd == fd_)
+                    alive = false; // 서버 종료 (shm 이후 소켓으로는 프레임이 오지 않음)
+                else if (fd == wake_fd_)
+                    ShmChannel::drain(wake_fd_);
+                else if (fd == to_client_fd)
+                    ShmChannel::drain(to_client_fd);
+            }
+        }
+        ring.endSleep();
+        idle_since = std::chrono::steady_clock::now();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connected_.store(false, std::memory_order_release);
+    }
+    if (!stop_.load(std::memory_order_acquire))
+        failAll("connection_closed");
+}
+
+bool AsyncClient::flushWrites()
+{
+    while (true)
+    {
+        // 보낼 게 떨어지면 그 사이 request()가 쌓아 둔 프레임을 통째로 가져온다
+        if (send_off_ == send_buf_.size())
+        {
+            send_buf_.clear();
+            send_off_ = 0;
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (out_.empty())
+                break;
+            send_buf_.swap(out_);
+        }
+
+        const size_t chunk = std::min(send_buf_.size() - send_off_, config_.max_write_batch);
+        ssize_t s = ::send(fd_, send_buf_.data() + send_off_, chunk, MSG_NOSIGNAL);
+        if (s > 0)
+        {
+            send_off_ += static_cast<size_t>(s);
+            continue;
+        }
+        if (s < 0 && errno == EINTR)
+            continue;
+        if (s < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            if (!want_write_)
+            {
+                epoll_event ev{};
+                ev.events = EPOLLIN | EPOLLOUT;
+                ev.data.fd = fd_;
+                ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd_, &ev);
+                want_write_ = true;
+            }
+            return true;
+        }
+        return false;
+    }
+
+    if (want_write_)
+    {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd_;
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd_, &ev);
+        want_write_ = false;
+    }
+    return true;
+}
+
+bool AsyncClient::readAvailable()
+{
+    bool alive = true;
+    char buf[64 * 1024];
+    while (true)
+    {
+        ssize_t r = ::recv(fd_, buf, sizeof(buf), 0);
+        if (r > 0)
+        {
+            in_.append(buf, static_cast<size_t>(r));
+            if (static_cast<size_t>(r) < sizeof(buf))
+                break; // 소켓 버퍼를 비웠음
+            continue;
+        }
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        alive = false; // EOF 또는 에러: 이미 받은 응답은 처리하고 끝낸다
+        break;
+    }
+
+    while (true)
+    {
+        std::string_view payload;
+        FrameStatus st = decodeFrame(in_.data() + in_off_, in_.size() - in_off_, payload);
+        if (st == FrameStatus::INCOMPLETE)
+            break;
+        if (st == FrameStatus::INVALID_LENGTH)
+            return false;
+        in_off_ += kFrameHeaderSize + payload.size();
+        handleFrame(payload.data(), payload.size());
+    }
+
+    if (in_off_ == in_.size())
+    {
+        in_.clear();
+        in_off_ = 0;
+    }
+    else if (in_off_ > in_.size() / 2)
+    {
+        in_.erase(0, in_off_);
+        in_off_ = 0;
+    }
+    return alive;
+}
+
+void AsyncClient::handleFrame(const char *data, size_t size)
+{
+    nlohmann::json res = nlohmann::json::parse(data, data + size, nullptr, false);
+    if (res.is_discarded())
+        return;
+
+    // 배치 응답: 요소마다 req_id로 짝짓는다
+    if (res.is_array())
+    {
+        for (nlohmann::json &item : res)
+            handleResponse(std::move(item));
+        return;
+    }
+    handleResponse(std::move(res));
+}
+
+void AsyncClient::handleResponse(nlohmann::json res)
+{
+    auto id_it = res.is_object() ? res.find("req_id") : res.end();
+    if (id_it == res.end() || !id_it->is_number_unsigned())
+    {
+        // 서버 하트비트에는 바로 답한다 (서버의 유휴 타이머가 조용한 연결을 끊지 않게)
+        auto type = res.is_object() ? res.find("type") : res.end();
+        if (type != res.end() && type->is_string() && type->get_ref<const std::string &>() == kHeartbeatType)
+        {
+            sendHeartbeat();
+            return;
+        }
+        // 서버 drain: 새 요청은 not_connected로 바로 실패시켜 (ClientPool이면 다른/새 연결로 가게) 하고
+        // 이미 보낸 요청의 응답은 계속 받는다
+        if (type != res.end() && type->is_string() && type->get_ref<const std::string &>() == kGoawayType)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                connected_.store(false, std::memory_order_release);
+            }
+            goaway_ = true;
+            return;
+        }
+        if (message_handler_)
+            message_handler_(std::move(res));
+        return;
+    }
+
+    Pending pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = pending_.find(id_it->get<uint64_t>());
+        if (it == pending_.end())
+            return;
+        pending = std::move(it->second);
+        pending_.erase(it);
+    }
+
+    if (pending.original_req_id.is_null())
+        res.erase("req_id");
+    else
+        *id_it = std::move(pending.original_req_id);
+    pending.callback(std::move(res));
+}
+
+void AsyncClient::sendHeartbeat()
+{
+    std::string frame;
+    appendFrame(frame, nlohmann::json{{"type", kHeartbeatType}}.dump());
+    if (config_.shm)
+    {
+        writeShm(frame);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        out_ += frame;
+    }
+    wake();
+}
+
+void AsyncClient::failAll(const std::string &reason)
+{
+    std::unordered_map<uint64_t, Pending> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending.swap(pending_);
+        out_.clear();
+    }
+    for (auto &[id, p] : pending)
+        p.callback(makeError(p.original_req_id, reason));
+}
+
+nlohmann::json AsyncClient::makeError(const nlohmann::json &req_id, const std::string &reason)
+{
+    nlohmann::json res;
+    res["type"] = "error";
+    res["ok"] = false;
+    res["reason"] = reason;
+    if (!req_id.is_null())
+        res["req_id"] = req_id;
+    return res;
+}
+
+} // namespace msgnet
@@ -0,0 +1,133 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "json.hpp"
+#include "ShmTransport.h"
+
+namespace msgnet
+{
+
+struct AsyncClientConfig
+{
+    std::string host = "127.0.0.1";
+    int port = 55000;
+    std::string unix_path; // 있으면 host/port 대신 AF_UNIX로 연결 ("@name"은 abstract namespace)
+    size_t max_write_batch = 256 * 1024; // 한 번의 send로 내보낼 최대 바이트 (쓰기 합치기 상한)
+    bool shm = false;      // unix_path 연결을 공유 메모리 링으로 전환 (같은 호스트 서버 전용)
+    int shm_spin_us = 50;  // 응답 링이 비었을 때 잠들기 전 바쁜 대기 시간
+};
+
+// 비동기 파이프라이닝 클라이언트
+// - 연결 하나에 요청을 여러 개 동시에 보내고, 응답은 req_id로 짝지어 callback/future로 돌려준다
+// - 요청의 req_id는 전송 중에만 내부 번호로 바꿔 쓰고, 응답을 돌려줄 때 원래 값으로 되돌린다
+// - 전용 I/O 스레드가 epoll로 non-blocking 소켓을 돌린다. 여러 스레드에서 request()를 불러도 되며,
+//   그 사이 쌓인 요청은 한 번의 send로 합쳐서 보내고, 수신은 읽을 수 있는 만큼 한꺼번에 읽어 잘라낸다
+// - 응답 callback은 I/O 스레드에서 호출되므로 오래 막히면 안 되고, 그 안에서 close()를 부르면 안 된다
+// - 연결이 끊기면 남은 요청은 {"type":"error","ok":false,"reason":"connection_closed"}로 완료된다
+// - shm이면 connect()에서 공유 메모리 링으로 전환한다. request()가 요청 링에 직접 쓰고,
+//   I/O 스레드는 응답 링을 바쁜 대기로 읽다가 한가해지면 eventfd로 잠든다
+class AsyncClient
+{
+public:
+    using ResponseCallback = std::function<void(nlohmann::json response)>;
+
+    explicit AsyncClient(AsyncClientConfig config);
+    ~AsyncClient();
+
+    AsyncClient(const AsyncClient &) = delete;
+    AsyncClient &operator=(const AsyncClient &) = delete;
+
+    // 블로킹 connect 후 I/O 스레드 시작. 실패하면 false
+    // goaway를 받은 뒤에 다시 부르면 이전 연결을 close()로 정리하고 새로 연결한다
+    bool connect();
+
+    // I/O 스레드를 멈추고 연결을 닫는다 (남은 요청은 connection_closed로 완료)
+    void close();
+
+    // 서버가 goaway를 보낸 뒤에는 false (남은 응답은 계속 받고, 다 받으면 연결을 닫는다)
+    bool connected() const
+    {
+        return connected_.load(std::memory_order_acquire);
+    }
+
+    void request(nlohmann::json req, ResponseCallback callback);
+    std::future<nlohmann::json> request(nlohmann::json req);
+
+    // 요청 여러 개를 프레임 하나(JSON 배열)로 보낸다. 서버는 응답도 배열 하나로 돌려주고,
+    // callback은 요청 순서대로 모은 응답 배열로 한 번 호출된다 (연결 끊김 등은 해당 자리가 에러 응답)
+    void requestBatch(std::vector<nlohmann::json> reqs, ResponseCallback callback);
+    std::future<nlohmann::json> requestBatch(std::vector<nlohmann::json> reqs);
+
+    // req_id가 없는 서버 푸시 메시지 (sendToClient 등). connect() 전에 설정
+    void setMessageHandler(ResponseCallback handler)
+    {
+        message_handler_ = std::move(handler);
+    }
+
+    // 응답을 기다리는 요청 수
+    size_t outstanding() const;
+
+private:
+    struct Pending
+    {
+        nlohmann::json original_req_id; // null이면 요청에 req_id가 없었음
+        ResponseCallback callback;
+    };
+
+    void ioLoop();
+    void shmIoLoop();
+    void writeShm(const std::string &frame);
+    bool flushWrites();
+    bool readAvailable();
+    void handleFrame(const char *data, size_t size);
+    void handleResponse(nlohmann::json res);
+    void sendHeartbeat();
+    void failAll(const std::string &reason);
+    void wake();
+
+    static nlohmann::json makeError(const nlohmann::json &req_id, const std::string &reason);
+
+    static constexpr int kShmWriteTimeoutMs = 1000; // 요청 링이 이만큼 계속 차 있으면 연결을 끊는다
+
+    AsyncClientConfig config_;
+    int fd_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+
+    std::atomic<bool> connected_{false};
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> wake_pending_{false};
+    std::thread io_thread_;
+
+    // request()가 채우고 I/O 스레드가 가져가는 상태
+    mutable std::mutex mutex_;
+    std::string out_;                                  // 아직 I/O 스레드가 가져가지 않은 프레임들
+    std::unordered_map<uint64_t, Pending> pending_;    // 내부 req_id -> 요청 정보
+    uint64_t next_req_id_ = 1;
+
+    // I/O 스레드 전용
+    std::string send_buf_;
+    size_t send_off_ = 0;
+    bool want_write_ = false;
+    bool goaway_ = false; // 서버가 drain 중: 남은 응답을 다 받으면 I/O 루프를 끝낸다
+    std::string in_;
+    size_t in_off_ = 0;
+
+    ResponseCallback message_handler_;
+
+    // 공유 메모리 전송 (shm_write_mutex_: 요청 링의 단일 생산자 보장 + close()와의 교체 보호)
+    std::mutex shm_write_mutex_;
+    std::unique_ptr<ShmChannel> shm_;
+    std::string shm_scratch_; // I/O 스레드 전용 (링 끝에서 잘린 프레임 복사)
+};
+
+} // namespace msgnet
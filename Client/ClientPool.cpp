@@ -0,0 +1,379 @@
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+#include "ClientPool.h"
+
+namespace msgnet
+{
+
+namespace
+{
+
+// 응답의 "ok" 값 (없거나 bool이 아니면 false)
+bool responseOk(const nlohmann::json &res)
+{
+    if (!res.is_object())
+        return false;
+    auto it = res.find("ok");
+    return it != res.end() && it->is_boolean() && it->get<bool>();
+}
+
+bool isConnectionError(const nlohmann::json &res)
+{
+    if (!res.is_object())
+        return false;
+    auto it = res.find("reason");
+    return it != res.end() && it->is_string() &&
+           (*it == "connection_closed" || *it == "not_connected");
+}
+
+} // namespace
+
+ClientPool::ClientPool(ClientPoolConfig config) : config_(std::move(config))
+{
+    const int per_endpoint = std::max(1, config_.connections_per_endpoint);
+    for (const PoolEndpoint &ep : config_.endpoints)
+    {
+        for (int i = 0; i < per_endpoint; ++i)
+        {
+            auto slot = std::make_unique<Slot>();
+            slot->endpoint = ep;
+            slots_.push_back(std::move(slot));
+        }
+    }
+}
+
+ClientPool::~ClientPool()
+{
+    stop();
+}
+
+bool ClientPool::start()
+{
+    if (running_.exchange(true))
+        return connectedCount() > 0;
+
+    const int64_t now = monotonicNowNs();
+    for (auto &slot : slots_)
+    {
+        if (!connectSlot(*slot))
+        {
+            slot->backoff_ms = config_.reconnect_min_ms;
+            slot->next_attempt_ns = now + static_cast<int64_t>(slot->backoff_ms) * 1000000;
+        }
+    }
+
+    maintenance_thread_ = std::thread(&ClientPool::maintenanceLoop, this);
+    return connectedCount() > 0;
+}
+
+void ClientPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        if (!running_.exchange(false))
+            return;
+    }
+    wake_cv_.notify_all();
+    if (maintenance_thread_.joinable())
+        maintenance_thread_.join();
+
+    for (auto &slot : slots_)
+    {
+        std::shared_ptr<AsyncClient> client;
+        {
+            std::lock_guard<std::mutex> lock(slot->client_mutex);
+            client.swap(slot->client);
+        }
+        if (client)
+            client->close();
+        closeRetired(*slot, true);
+        // 닫았으므로 지금 연결의 히스토그램도 합계로 옮긴다 (stats()는 계속 읽을 수 있다)
+        std::lock_guard<std::mutex> lock(slot->client_mutex);
+        if (slot->latency)
+            slot->past_latency.merge(*slot->latency);
+        slot->latency.reset();
+    }
+}
+
+bool ClientPool::closeRetired(Slot &slot, bool all)
+{
+    std::vector<std::shared_ptr<AsyncClient>> done;
+    {
+        std::lock_guard<std::mutex> lock(slot.client_mutex);
+        for (const Slot::Retired &r : slot.retired)
+        {
+            if (all || r.client->outstanding() == 0)
+                done.push_back(r.client);
+        }
+        if (done.empty())
+            return !slot.retired.empty();
+    }
+    // close()가 I/O 스레드를 join하므로 그 뒤로는 이 연결들의 히스토그램에 쓰는 스레드가 없다
+    for (auto &client : done)
+        client->close();
+
+    std::lock_guard<std::mutex> lock(slot.client_mutex);
+    std::erase_if(slot.retired, [&](const Slot::Retired &r)
+                  {
+                      if (std::find(done.begin(), done.end(), r.client) == done.end())
+                          return false;
+                      slot.past_latency.merge(*r.latency);
+                      return true; });
+    return !slot.retired.empty();
+}
+
+bool ClientPool::connectSlot(Slot &slot)
+{
+    AsyncClientConfig cc;
+    cc.host = slot.endpoint.host;
+    cc.port = slot.endpoint.port;
+    cc.unix_path = slot.endpoint.unix_path;
+    cc.shm = slot.endpoint.shm;
+    cc.max_write_batch = config_.max_write_batch;
+
+    auto client = std::make_shared<AsyncClient>(cc);
+    if (config_.message_handler)
+        client->setMessageHandler(config_.message_handler);
+    if (!client->connect())
+        return false;
+
+    if (slot.ever_connected)
+        slot.reconnects.fetch_add(1, std::memory_order_relaxed);
+    slot.ever_connected = true;
+    slot.backoff_ms = 0;
+
+    // 이전 연결(끊겼거나 서버 goaway)은 남은 응답을 다 받을 때까지 자기 히스토그램과 함께 살려 둔다
+    // 닫고 합계로 옮기는 것은 관리 루프가 한다
+    std::lock_guard<std::mutex> lock(slot.client_mutex);
+    if (slot.client)
+        slot.retired.push_back({std::move(slot.client), std::move(slot.latency)});
+    slot.client = std::move(client);
+    slot.latency = std::make_shared<LatencyHistogram>();
+    return true;
+}
+
+void ClientPool::maintenanceLoop()
+{
+    std::mt19937 rng(std::random_device{}());
+
+    while (running_.load(std::memory_order_acquire))
+    {
+        const int64_t now = monotonicNowNs();
+        int64_t next_wake = now + 1000LL * 1000000; // 1s마다 연결 상태 재확인
+
+        for (auto &slot : slots_)
+        {
+            if (closeRetired(*slot, false))
+                next_wake = std::min<int64_t>(next_wake, now + 100LL * 1000000);
+
+            auto client = slot->current();
+            if (client && client->connected())
+                continue;
+
+            // 끊긴 것을 처음 본 시점에 백오프 시작
+            if (slot->backoff_ms == 0)
+            {
+                slot->backoff_ms = config_.reconnect_min_ms;
+                slot->next_attempt_ns = now;
+            }
+
+            if (now >= slot->next_attempt_ns)
+            {
+                if (connectSlot(*slot))
+                    continue;
+
+                // 지수 백오프 + 지터 (여러 클라이언트가 같은 순간에 몰려 재연결하지 않게)
+                std::uniform_int_distribution<int> jitter(0, std::max(1, slot->backoff_ms / 2));
+                slot->next_attempt_ns = now + static_cast<int64_t>(slot->backoff_ms + jitter(rng)) * 1000000;
+                slot->backoff_ms = std::min(slot->backoff_ms * 2, config_.reconnect_max_ms);
+            }
+            next_wake = std::min(next_wake, slot->next_attempt_ns);
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        const int64_t wait_ns = std::max<int64_t>(next_wake - monotonicNowNs(), 1000000);
+        wake_cv_.wait_for(lock, std::chrono::nanoseconds(wait_ns),
+                          [&]
+                          { return !running_.load(std::memory_order_acquire) || wake_requested_; });
+        wake_requested_ = false;
+    }
+}
+
+void ClientPool::wakeMaintenance()
+{
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        wake_requested_ = true;
+    }
+    wake_cv_.notify_one();
+}
+
+ClientPool::Slot *ClientPool::pickSlot()
+{
+    const size_t n = slots_.size();
+    if (n == 0)
+        return nullptr;
+
+    // 시작 위치를 돌려서 동률일 때 한 연결로만 몰리지 않게 한다
+    const size_t start = rr_.fetch_add(1, std::memory_order_relaxed);
+    Slot *best = nullptr;
+    size_t best_outstanding = SIZE_MAX;
+    for (size_t i = 0; i < n; ++i)
+    {
+        Slot *slot = slots_[(start + i) % n].get();
+        const size_t outstanding = slot->outstanding.load(std::memory_order_relaxed);
+        if (outstanding >= best_outstanding)
+            continue;
+        auto client = slot->current();
+        if (!client || !client->connected())
+            continue;
+        best = slot;
+        best_outstanding = outstanding;
+        if (outstanding == 0)
+            break;
+    }
+    return best;
+}
+
+void ClientPool::request(nlohmann::json req, ResponseCallback callback)
+{
+    Slot *slot = pickSlot();
+    std::shared_ptr<LatencyHistogram> latency;
+    std::shared_ptr<AsyncClient> client = slot ? slot->current(latency) : nullptr;
+    if (!client)
+    {
+        callback(makeError(req, "no_connection"));
+        wakeMaintenance(); // 관리 스레드가 바로 재연결을 시도하도록
+        return;
+    }
+
+    slot->outstanding.fetch_add(1, std::memory_order_relaxed);
+    slot->requests.fetch_add(1, std::memory_order_relaxed);
+    const int64_t sent_ns = monotonicNowNs();
+
+    client->request(std::move(req), [slot, latency, sent_ns, cb = std::move(callback)](nlohmann::json res)
+                    {
+                        slot->outstanding.fetch_sub(1, std::memory_order_relaxed);
+                        if (isConnectionError(res))
+                        {
+                            slot->errors.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        else
+                        {
+                            latency->record(static_cast<uint64_t>(monotonicNowNs() - sent_ns));
+                            if (!responseOk(res))
+                                slot->errors.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        cb(std::move(res)); });
+}
+
+std::future<nlohmann::json> ClientPool::request(nlohmann::json req)
+{
+    auto promise = std::make_shared<std::promise<nlohmann::json>>();
+    std::future<nlohmann::json> future = promise->get_future();
+    request(std::move(req), [promise](nlohmann::json response)
+            { promise->set_value(std::move(response)); });
+    return future;
+}
+
+void ClientPool::requestBatch(std::vector<nlohmann::json> reqs, ResponseCallback callback)
+{
+    Slot *slot = pickSlot();
+    std::shared_ptr<LatencyHistogram> latency;
+    std::shared_ptr<AsyncClient> client = slot ? slot->current(latency) : nullptr;
+    if (!client)
+    {
+        nlohmann::json responses = nlohmann::json::array();
+        for (const nlohmann::json &req : reqs)
+            responses.push_back(makeError(req, "no_connection"));
+        callback(std::move(responses));
+        wakeMaintenance();
+        return;
+    }
+
+    const size_t n = reqs.size();
+    slot->outstanding.fetch_add(n, std::memory_order_relaxed);
+    slot->requests.fetch_add(n, std::memory_order_relaxed);
+    const int64_t sent_ns = monotonicNowNs();
+
+    client->requestBatch(std::move(reqs), [slot, latency, n, sent_ns, cb = std::move(callback)](nlohmann::json responses)
+                         {
+                             slot->outstanding.fetch_sub(n, std::memory_order_relaxed);
+                             bool recorded = false;
+                             for (const nlohmann::json &res : responses)
+                             {
+                                 if (isConnectionError(res) || !responseOk(res))
+                                     slot->errors.fetch_add(1, std::memory_order_relaxed);
+                                 if (!recorded && !isConnectionError(res))
+                                 {
+                                     latency->record(static_cast<uint64_t>(monotonicNowNs() - sent_ns));
+                                     recorded = true;
+                                 }
+                             }
+                             cb(std::move(responses)); });
+}
+
+std::future<nlohmann::json> ClientPool::requestBatch(std::vector<nlohmann::json> reqs)
+{
+    auto promise = std::make_shared<std::promise<nlohmann::json>>();
+    std::future<nlohmann::json> future = promise->get_future();
+    requestBatch(std::move(reqs), [promise](nlohmann::json responses)
+                 { promise->set_value(std::move(responses)); });
+    return future;
+}
+
+size_t ClientPool::connectedCount() const
+{
+    size_t n = 0;
+    for (auto &slot : slots_)
+    {
+        auto client = slot->current();
+        if (client && client->connected())
+            ++n;
+    }
+    return n;
+}
+
+std::vector<PoolConnectionStats> ClientPool::stats() const
+{
+    std::vector<PoolConnectionStats> out;
+    out.reserve(slots_.size());
+    for (auto &slot : slots_)
+    {
+        PoolConnectionStats s;
+        s.endpoint = slot->endpoint.toString();
+        auto client = slot->current();
+        s.connected = client && client->connected();
+        s.outstanding = slot->outstanding.load(std::memory_order_relaxed);
+        s.requests = slot->requests.load(std::memory_order_relaxed);
+        s.errors = slot->errors.load(std::memory_order_relaxed);
+        s.reconnects = slot->reconnects.load(std::memory_order_relaxed);
+
+        {
+            std::lock_guard<std::mutex> lock(slot->client_mutex);
+            HistogramSnapshot snap = slot->past_latency;
+            if (slot->latency)
+                snap.merge(*slot->latency);
+            for (const Slot::Retired &r : slot->retired)
+                snap.merge(*r.latency);
+            s.latency = snap.summary();
+        }
+        out.push_back(std::move(s));
+    }
+    return out;
+}
+
+nlohmann::json ClientPool::makeError(const nlohmann::json &req, const std::string &reason)
+{
+    nlohmann::json res;
+    res["type"] = "error";
+    res["ok"] = false;
+    res["reason"] = reason;
+    if (req.is_object() && req.contains("req_id"))
+        res["req_id"] = req["req_id"];
+    return res;
+}
+
+} // namespace msgnet
@@ -0,0 +1,150 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "json.hpp"
+#include "AsyncClient.h"
+#include "LatencyHistogram.h"
+
+namespace msgnet
+{
+
+struct PoolEndpoint
+{
+    std::string host = "127.0.0.1";
+    int port = 55000;
+    std::string unix_path; // 있으면 AF_UNIX ("@name"은 abstract namespace)
+    bool shm = false;      // unix_path 연결을 공유 메모리 링으로 전환
+
+    std::string toString() const
+    {
+        if (unix_path.empty())
+            return host + ":" + std::to_string(port);
+        return (shm ? "shm:" : "unix:") + unix_path;
+    }
+};
+
+struct ClientPoolConfig
+{
+    std::vector<PoolEndpoint> endpoints;
+    int connections_per_endpoint = 2;
+    int reconnect_min_ms = 100;  // 첫 재연결 대기
+    int reconnect_max_ms = 5000; // 지수 백오프 상한
+    size_t max_write_batch = 256 * 1024;
+    AsyncClient::ResponseCallback message_handler; // req_id 없는 서버 푸시 (구독한 topic 메시지 등). 각 연결의 I/O 스레드에서 호출
+};
+
+// 연결 하나의 상태/통계 (stats()가 돌려주는 스냅샷)
+struct PoolConnectionStats
+{
+    std::string endpoint; // "host:port", "unix:path" 또는 "shm:path"
+    bool connected = false;
+    size_t outstanding = 0;
+    uint64_t requests = 0;
+    uint64_t errors = 0;     // ok=false 응답 + 연결 끊김으로 실패한 요청
+    uint64_t reconnects = 0; // 최초 연결 이후 다시 연결한 횟수
+    LatencySummary latency;  // 성공/실패 응답 모두 포함, 연결 끊김 제외
+};
+
+// 여러 엔드포인트에 지속 연결 N개를 유지하는 클라이언트 풀
+// - 요청은 연결된 것 중 응답 대기 수가 가장 적은 연결로 보낸다 (동률이면 돌아가며)
+// - 끊긴 연결은 관리 스레드가 지수 백오프(+지터)로 다시 연결한다
+// - 연결마다 지연 히스토그램을 둔다. 기록은 그 연결의 I/O 스레드만 하므로 락이 없다
+//   (재연결로 바뀐 연결은 닫아서 I/O 스레드가 끝난 뒤에 슬롯의 합계로 옮긴다)
+// - 보낼 연결이 하나도 없으면 {"type":"error","ok":false,"reason":"no_connection"}으로 바로 완료된다
+class ClientPool
+{
+public:
+    using ResponseCallback = AsyncClient::ResponseCallback;
+
+    explicit ClientPool(ClientPoolConfig config);
+    ~ClientPool();
+
+    ClientPool(const ClientPool &) = delete;
+    ClientPool &operator=(const ClientPool &) = delete;
+
+    // 모든 연결을 한 번 시도하고 관리 스레드를 시작한다. 하나라도 연결되면 true
+    bool start();
+    void stop();
+
+    void request(nlohmann::json req, ResponseCallback callback);
+    std::future<nlohmann::json> request(nlohmann::json req);
+
+    // 배치 하나는 통째로 한 연결로 간다 (AsyncClient::requestBatch). 지연은 배치 단위로 기록
+    void requestBatch(std::vector<nlohmann::json> reqs, ResponseCallback callback);
+    std::future<nlohmann::json> requestBatch(std::vector<nlohmann::json> reqs);
+
+    size_t connectedCount() const;
+    std::vector<PoolConnectionStats> stats() const;
+
+private:
+    struct Slot
+    {
+        PoolEndpoint endpoint;
+
+        // 바뀐 연결: goaway면 남은 응답을 받는 중이고, 그동안 자기 히스토그램에 계속 기록한다
+        struct Retired
+        {
+            std::shared_ptr<AsyncClient> client;
+            std::shared_ptr<LatencyHistogram> latency;
+        };
+
+        mutable std::mutex client_mutex; // client/latency 교체(재연결)와 요청 시 참조 복사, retired/past_latency 보호
+        std::shared_ptr<AsyncClient> client;
+        std::shared_ptr<LatencyHistogram> latency; // 지금 연결의 지연 (연결과 함께 바뀐다)
+        std::vector<Retired> retired;              // 응답이 남았거나 아직 닫지 않은 이전 연결
+        HistogramSnapshot past_latency;            // 닫아서 정리한 이전 연결들의 지연
+
+        std::atomic<size_t> outstanding{0};
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> errors{0};
+        std::atomic<uint64_t> reconnects{0};
+
+        // 관리 스레드 전용
+        bool ever_connected = false;
+        int backoff_ms = 0;
+        int64_t next_attempt_ns = 0;
+
+        std::shared_ptr<AsyncClient> current() const
+        {
+            std::lock_guard<std::mutex> lock(client_mutex);
+            return client;
+        }
+
+        // 요청을 보낼 연결과 그 연결의 히스토그램
+        std::shared_ptr<AsyncClient> current(std::shared_ptr<LatencyHistogram> &hist) const
+        {
+            std::lock_guard<std::mutex> lock(client_mutex);
+            hist = latency;
+            return client;
+        }
+    };
+
+    bool connectSlot(Slot &slot);
+    // 응답이 남지 않은(all이면 모든) 이전 연결을 닫고 히스토그램을 합계로 옮긴다. 아직 남은 게 있으면 true
+    bool closeRetired(Slot &slot, bool all);
+    void maintenanceLoop();
+    Slot *pickSlot();
+    void wakeMaintenance();
+
+    static nlohmann::json makeError(const nlohmann::json &req, const std::string &reason);
+
+    ClientPoolConfig config_;
+    std::vector<std::unique_ptr<Slot>> slots_;
+    std::atomic<size_t> rr_{0};
+
+    std::atomic<bool> running_{false};
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    bool wake_requested_ = false; // wake_mutex_ 보호. 보낼 연결이 없을 때 관리 스레드를 바로 깨운다
+    std::thread maintenance_thread_;
+};
+
+} // namespace msgnet
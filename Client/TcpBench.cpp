@@ -0,0 +1,620 @@
+// tcp_bench: 다중 연결 부하 생성기
+//
+// - 여러 스레드가 각각 epoll로 많은 연결을 관리하고, 연결마다 최대 depth개 요청을 파이프라이닝한다
+// - closed-loop: 연결마다 depth개를 항상 in-flight로 유지 (고정 동시성)
+// - open-loop: 전체 --rate req/s로 도착을 스케줄링. 지연은 "의도한 전송 시각"부터 재서
+//   서버가 밀릴 때 측정이 낙관적으로 왜곡되는 coordinated omission을 보정한다
+// - 메시지 구성은 test/client_json.txt 같은 파일(한 줄에 JSON 하나)에서 읽어 순서대로 재생한다
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "json.hpp"
+#include "LatencyHistogram.h"
+#include "SocketAddress.h"
+
+using namespace std;
+using namespace msgnet;
+
+struct BenchOptions
+{
+    string host = "127.0.0.1";
+    int port = 55000;
+    string unix_path; // 있으면 host/port 대신 AF_UNIX ("@name"은 abstract namespace)
+    int connections = 64;
+    int threads = 4;
+    int depth = 1;
+    double duration_sec = 10.0;
+    double warmup_sec = 1.0;
+    bool open_loop = false;
+    double rate = 10000.0; // open-loop 전체 도착률 (req/s)
+    string mix_file = "test/client_json.txt";
+};
+
+struct Conn
+{
+    int fd = -1;
+    string out;
+    size_t out_off = 0;
+    string in;
+    size_t in_off = 0;
+    bool want_write = false;
+    uint64_t next_seq = 0;
+    unordered_map<uint64_t, int64_t> inflight; // req_id -> 의도한 전송 시각(ns)
+};
+
+struct WorkerResult
+{
+    LatencyHistogram latency;
+    uint64_t sent = 0;
+    uint64_t completed = 0;
+    uint64_t completed_measured = 0; // 측정 구간 안에 받은 응답 (처리량 계산용)
+    uint64_t errors = 0;         // ok=false 응답
+    uint64_t conn_failures = 0;
+    uint64_t backlog_peak = 0;   // open-loop에서 보낼 연결을 못 찾아 밀린 요청 최대치
+    uint64_t unfinished = 0;     // open-loop에서 끝날 때 못 보냈거나 응답을 못 받은 요청 (지연은 종료 시각까지로 기록)
+};
+
+// 나노초 단위 대기 (epoll_pwait2, 커널 5.11+). 없으면 밀리초로 올림해서 바쁜 대기를 피한다
+static int waitEvents(int epfd, epoll_event *events, int max_events, int64_t timeout_ns)
+{
+    static std::atomic<bool> has_pwait2{true};
+    if (has_pwait2.load(std::memory_order_relaxed))
+    {
+        timespec ts{static_cast<time_t>(timeout_ns / 1000000000), static_cast<long>(timeout_ns % 1000000000)};
+        int n = ::epoll_pwait2(epfd, events, max_events, &ts, nullptr);
+        if (n >= 0 || errno != ENOSYS)
+            return n;
+        has_pwait2.store(false, std::memory_order_relaxed);
+    }
+    return ::epoll_wait(epfd, events, max_events, static_cast<int>((timeout_ns + 999999) / 1000000));
+}
+
+static void usage(const char *prog)
+{
+    cerr << "Usage: " << prog << " [options]\n"
+         << "  --host H           server address (default 127.0.0.1)\n"
+         << "  --port P           server port (default 55000)\n"
+         << "  --unix PATH        connect over AF_UNIX instead (@name for abstract namespace)\n"
+         << "  --connections N    total connections (default 64)\n"
+         << "  --threads T        worker threads (default 4)\n"
+         << "  --depth D          max in-flight requests per connection (default 1)\n"
+         << "  --duration S       measured seconds (default 10)\n"
+         << "  --warmup S         warmup seconds, not recorded (default 1)\n"
+         << "  --mode closed|open closed-loop (fixed concurrency) or open-loop (fixed rate)\n"
+         << "  --rate R           open-loop arrival rate in req/s (default 10000)\n"
+         << "  --mix FILE         request mix, one JSON per line (default test/client_json.txt)\n";
+}
+
+static bool parseArgs(int argc, char **argv, BenchOptions &o)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        string a = argv[i];
+        auto next = [&]() -> const char *
+        {
+            if (i + 1 >= argc)
+                throw invalid_argument("missing value for " + a);
+            return argv[++i];
+        };
+
+        if (a == "--host")
+            o.host = next();
+        else if (a == "--port")
+            o.port = stoi(next());
+        else if (a == "--unix")
+            o.unix_path = next();
+        else if (a == "--connections")
+            o.connections = stoi(next());
+        else if (a == "--threads")
+            o.threads = stoi(next());
+        else if (a == "--depth")
+            o.depth = stoi(next());
+        else if (a == "--duration")
+            o.duration_sec = stod(next());
+        else if (a == "--warmup")
+            o.warmup_sec = stod(next());
+        else if (a == "--rate")
+            o.rate = stod(next());
+        else if (a == "--mix")
+            o.mix_file = next();
+        else if (a == "--mode")
+        {
+            string m = next();
+            if (m == "open")
+                o.open_loop = true;
+            else if (m == "closed")
+                o.open_loop = false;
+            else
+                throw invalid_argument("unknown mode: " + m);
+        }
+        else
+        {
+            usage(argv[0]);
+            return false;
+        }
+    }
+
+    if (o.connections < 1 || o.threads < 1 || o.depth < 1 || o.rate <= 0)
+        throw invalid_argument("connections/threads/depth/rate must be positive");
+    if (o.threads > o.connections)
+        o.threads = o.connections;
+    return true;
+}
+
+static vector<nlohmann::json> loadMix(const string &path)
+{
+    ifstream in(path);
+    if (!in)
+        throw runtime_error("cannot open mix file: " + path);
+
+    vector<nlohmann::json> mix;
+    string line;
+    while (getline(in, line))
+    {
+        if (line.find_first_not_of(" \t\r") == string::npos)
+            continue;
+        auto j = nlohmann::json::parse(line, nullptr, false);
+        if (j.is_discarded() || !j.is_object())
+            throw runtime_error("invalid JSON in mix file: " + line);
+        mix.push_back(std::move(j));
+    }
+    if (mix.empty())
+        throw runtime_error("mix file has no requests: " + path);
+    return mix;
+}
+
+static void raiseFdLimit()
+{
+    rlimit rl{};
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max)
+    {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+}
+
+static int connectTo(const SocketAddress &addr)
+{
+    int fd = ::socket(addr.family(), SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+    if (::connect(fd, addr.get(), addr.length) < 0)
+    {
+        ::close(fd);
+        return -1;
+    }
+    if (addr.family() == AF_INET)
+    {
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+class Worker
+{
+public:
+    Worker(const BenchOptions &opt, const vector<nlohmann::json> &mix, int index, int conn_count,
+           const SocketAddress &addr, WorkerResult &result)
+        : opt_(opt), mix_(mix), index_(index), result_(result)
+    {
+        epfd_ = ::epoll_create1(EPOLL_CLOEXEC);
+        for (int i = 0; i < conn_count; ++i)
+        {
+            int fd = connectTo(addr);
+            if (fd < 0)
+            {
+                ++result_.conn_failures;
+                continue;
+            }
+            auto c = make_unique<Conn>();
+            c->fd = fd;
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.ptr = c.get();
+            ::epoll_ctl(epfd_, EPOLL_CTL_ADD, fd, &ev);
+            conns_.push_back(std::move(c));
+        }
+        mix_pos_ = static_cast<size_t>(index) % mix_.size();
+    }
+
+    ~Worker()
+    {
+        for (auto &c : conns_)
+        {
+            if (c->fd >= 0)
+                ::close(c->fd);
+        }
+        ::close(epfd_);
+    }
+
+    void run(int64_t start_ns, int64_t warmup_end_ns, int64_t end_ns)
+    {
+        warmup_end_ns_ = warmup_end_ns;
+        if (conns_.empty())
+            return;
+
+        const double thread_rate = opt_.rate / opt_.threads;
+        const int64_t interval_ns = static_cast<int64_t>(1e9 / thread_rate);
+        int64_t next_arrival = start_ns;
+
+        if (!opt_.open_loop)
+        {
+            for (auto &c : conns_)
+            {
+                for (int d = 0; d < opt_.depth; ++d)
+                    sendRequest(*c, start_ns);
+                flush(*c);
+            }
+        }
+
+        vector<epoll_event> events(256);
+        while (true)
+        {
+            int64_t now = monotonicNowNs();
+            if (now >= end_ns)
+                break;
+
+            int64_t timeout_ns = 100000000;
+            if (opt_.open_loop)
+            {
+                // 도착 시각이 된 요청을 backlog에 쌓고, 여유 있는 연결로 보낸다
+                while (next_arrival <= now)
+                {
+                    backlog_.push_back(next_arrival);
+                    next_arrival += interval_ns;
+                }
+                drainBacklog();
+                timeout_ns = max<int64_t>(0, min(next_arrival, end_ns) - monotonicNowNs());
+            }
+
+            int n = waitEvents(epfd_, events.data(), static_cast<int>(events.size()), timeout_ns);
+            for (int i = 0; i < n; ++i)
+            {
+                Conn &c = *static_cast<Conn *>(events[i].data.ptr);
+                if (c.fd < 0)
+                    continue;
+                if (events[i].events & (EPOLLERR | EPOLLHUP))
+                {
+                    closeConn(c);
+                    continue;
+                }
+                if (events[i].events & EPOLLIN)
+                    readResponses(c);
+                if (c.fd >= 0 && (events[i].events & EPOLLOUT))
+                    flush(c);
+            }
+        }
+
+        if (opt_.open_loop)
+            recordUnfinished(end_ns);
+    }
+
+private:
+    void sendRequest(Conn &c, int64_t intended_ns)
+    {
+        nlohmann::json req = mix_[mix_pos_];
+        mix_pos_ = (mix_pos_ + 1) % mix_.size();
+
+        // 연결별 시퀀스로 응답을 매칭 (상위 비트는 스레드 번호: 서버 트레이스에서 구분용)
+        const uint64_t req_id = (static_cast<uint64_t>(index_) << 48) | c.next_seq++;
+        req["req_id"] = req_id;
+        const string body = req.dump();
+        const uint32_t len = htonl(static_cast<uint32_t>(body.size()));
+        c.out.append(reinterpret_cast<const char *>(&len), sizeof(len));
+        c.out.append(body);
+        c.inflight.emplace(req_id, intended_ns);
+        ++result_.sent;
+    }
+
+    void drainBacklog()
+    {
+        if (backlog_.size() > result_.backlog_peak)
+            result_.backlog_peak = backlog_.size();
+
+        size_t scanned = 0;
+        while (!backlog_.empty() && scanned < conns_.size())
+        {
+            Conn &c = *conns_[rr_];
+            rr_ = (rr_ + 1) % conns_.size();
+            if (c.fd < 0 || static_cast<int>(c.inflight.size()) >= opt_.depth)
+            {
+                ++scanned;
+                continue;
+            }
+            scanned = 0;
+            sendRequest(c, backlog_.front());
+            backlog_.pop_front();
+            flush(c);
+        }
+    }
+
+    void flush(Conn &c)
+    {
+        while (c.out_off < c.out.size())
+        {
+            ssize_t w = ::send(c.fd, c.out.data() + c.out_off, c.out.size() - c.out_off, MSG_NOSIGNAL);
+            if (w < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    break;
+                closeConn(c);
+                return;
+            }
+            c.out_off += static_cast<size_t>(w);
+        }
+        if (c.out_off == c.out.size())
+        {
+            c.out.clear();
+            c.out_off = 0;
+        }
+
+        bool want_write = !c.out.empty();
+        if (want_write != c.want_write)
+        {
+            epoll_event ev{};
+            ev.events = want_write ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+            ev.data.ptr = &c;
+            ::epoll_ctl(epfd_, EPOLL_CTL_MOD, c.fd, &ev);
+            c.want_write = want_write;
+        }
+    }
+
+    void readResponses(Conn &c)
+    {
+        char buf[64 * 1024];
+        while (true)
+        {
+            ssize_t r = ::recv(c.fd, buf, sizeof(buf), 0);
+            if (r > 0)
+            {
+                c.in.append(buf, static_cast<size_t>(r));
+                if (static_cast<size_t>(r) < sizeof(buf))
+                    break;
+                continue;
+            }
+            if (r < 0 && errno == EINTR)
+                continue;
+            if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            closeConn(c); // r == 0 또는 에러
+            return;
+        }
+
+        const int64_t now = monotonicNowNs();
+        bool sent_more = false;
+        while (c.in.size() - c.in_off >= sizeof(uint32_t))
+        {
+            uint32_t len_net;
+            memcpy(&len_net, c.in.data() + c.in_off, sizeof(len_net));
+            const uint32_t len = ntohl(len_net);
+            if (c.in.size() - c.in_off - sizeof(len_net) < len)
+                break;
+
+            auto resp = nlohmann::json::parse(c.in.data() + c.in_off + sizeof(len_net),
+                                              c.in.data() + c.in_off + sizeof(len_net) + len, nullptr, false);
+            c.in_off += sizeof(len_net) + len;
+            onResponse(c, resp, now);
+
+            if (!opt_.open_loop)
+            {
+                sendRequest(c, now);
+                sent_more = true;
+            }
+        }
+
+        if (c.in_off == c.in.size())
+        {
+            c.in.clear();
+            c.in_off = 0;
+        }
+        else if (c.in_off > 64 * 1024)
+        {
+            c.in.erase(0, c.in_off);
+            c.in_off = 0;
+        }
+
+        if (sent_more)
+            flush(c);
+    }
+
+    void onResponse(Conn &c, const nlohmann::json &resp, int64_t now)
+    {
+        if (resp.is_discarded() || !resp.is_object())
+        {
+            ++result_.errors;
+            return;
+        }
+
+        auto ok = resp.find("ok");
+        if (ok == resp.end() || !ok->is_boolean() || !ok->get<bool>())
+            ++result_.errors;
+
+        auto id = resp.find("req_id");
+        if (id == resp.end() || !id->is_number_unsigned())
+            return;
+        auto it = c.inflight.find(id->get<uint64_t>());
+        if (it == c.inflight.end())
+            return;
+
+        const int64_t intended = it->second;
+        c.inflight.erase(it);
+        ++result_.completed;
+        if (now >= warmup_end_ns_)
+            ++result_.completed_measured;
+        if (intended >= warmup_end_ns_)
+            result_.latency.record(static_cast<uint64_t>(now - intended));
+    }
+
+    // 끝날 때 남은 요청을 빼면 서버가 밀린 만큼이 분포에서 사라진다 (coordinated omission)
+    // 종료 시각까지 기다린 것으로 기록한다 (실제 지연의 하한)
+    void recordUnfinished(int64_t end_ns)
+    {
+        auto record = [&](int64_t intended)
+        {
+            if (intended < warmup_end_ns_)
+                return;
+            ++result_.unfinished;
+            result_.latency.record(static_cast<uint64_t>(max<int64_t>(0, end_ns - intended)));
+        };
+        for (int64_t intended : backlog_)
+            record(intended);
+        backlog_.clear();
+        for (auto &c : conns_)
+        {
+            for (auto &[req_id, intended] : c->inflight)
+                record(intended);
+            c->inflight.clear();
+        }
+    }
+
+    void closeConn(Conn &c)
+    {
+        ::epoll_ctl(epfd_, EPOLL_CTL_DEL, c.fd, nullptr);
+        ::close(c.fd);
+        c.fd = -1;
+        c.inflight.clear();
+        ++result_.conn_failures;
+    }
+
+    const BenchOptions &opt_;
+    const vector<nlohmann::json> &mix_;
+    int index_;
+    WorkerResult &result_;
+
+    int epfd_ = -1;
+    vector<unique_ptr<Conn>> conns_;
+    size_t mix_pos_ = 0;
+    size_t rr_ = 0;
+    deque<int64_t> backlog_;
+    int64_t warmup_end_ns_ = 0;
+};
+
+static void printReport(const BenchOptions &opt, const vector<unique_ptr<WorkerResult>> &results)
+{
+    HistogramSnapshot merged;
+    uint64_t sent = 0, completed = 0, errors = 0, failures = 0, backlog = 0, unfinished = 0;
+    uint64_t completed_measured = 0;
+    for (auto &r : results)
+    {
+        merged.merge(r->latency);
+        sent += r->sent;
+        completed += r->completed;
+        errors += r->errors;
+        failures += r->conn_failures;
+        backlog = max(backlog, r->backlog_peak);
+        unfinished += r->unfinished;
+        completed_measured += r->completed_measured;
+    }
+
+    const double measured = opt.duration_sec;
+    printf("\n=== tcp_bench (%s-loop) ===\n", opt.open_loop ? "open" : "closed");
+    if (opt.unix_path.empty())
+        printf("target        %s:%d\n", opt.host.c_str(), opt.port);
+    else
+        printf("target        unix:%s\n", opt.unix_path.c_str());
+    printf("connections   %d (threads %d, depth %d)\n", opt.connections, opt.threads, opt.depth);
+    if (opt.open_loop)
+        printf("target rate   %.0f req/s\n", opt.rate);
+    printf("duration      %.1fs (+%.1fs warmup)\n", opt.duration_sec, opt.warmup_sec);
+    printf("sent          %llu\n", static_cast<unsigned long long>(sent));
+    printf("completed     %llu\n", static_cast<unsigned long long>(completed));
+    printf("errors        %llu (ok=false responses)\n", static_cast<unsigned long long>(errors));
+    printf("conn failures %llu\n", static_cast<unsigned long long>(failures));
+    if (opt.open_loop)
+    {
+        printf("backlog peak  %llu (per thread)\n", static_cast<unsigned long long>(backlog));
+        printf("unfinished    %llu (unsent or unanswered at end, recorded up to end time)\n",
+               static_cast<unsigned long long>(unfinished));
+    }
+    printf("throughput    %.1f req/s (measured window)\n", static_cast<double>(completed_measured) / measured);
+
+    printf("\nLatency distribution (%s):\n", opt.open_loop ? "from intended send time, CO-corrected" : "from send time");
+    const double qs[] = {0.50, 0.75, 0.90, 0.99, 0.999, 0.9999, 1.0};
+    for (double q : qs)
+    {
+        const uint64_t v = q >= 1.0 ? merged.summary().max_ns : merged.percentile(q);
+        printf("  %8.4f%%  %12.3f us\n", q * 100.0, static_cast<double>(v) / 1000.0);
+    }
+    const LatencySummary s = merged.summary();
+    printf("  mean       %12.3f us (samples %llu)\n", s.mean_ns / 1000.0, static_cast<unsigned long long>(s.count));
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions opt;
+    vector<nlohmann::json> mix;
+    try
+    {
+        if (!parseArgs(argc, argv, opt))
+            return 1;
+        mix = loadMix(opt.mix_file);
+    }
+    catch (const exception &e)
+    {
+        cerr << e.what() << "\n";
+        usage(argv[0]);
+        return 1;
+    }
+
+    raiseFdLimit();
+
+    SocketAddress addr;
+    if (!opt.unix_path.empty())
+    {
+        if (!SocketAddress::fromUnixPath(opt.unix_path, addr))
+        {
+            cerr << "invalid unix socket path: " << opt.unix_path << "\n";
+            return 1;
+        }
+    }
+    else if (!SocketAddress::fromTcp(opt.host, opt.port, addr))
+    {
+        cerr << "cannot resolve host: " << opt.host << "\n";
+        return 1;
+    }
+
+    vector<unique_ptr<WorkerResult>> results;
+    vector<unique_ptr<Worker>> workers;
+    for (int t = 0; t < opt.threads; ++t)
+    {
+        int count = opt.connections / opt.threads + (t < opt.connections % opt.threads ? 1 : 0);
+        results.push_back(make_unique<WorkerResult>());
+        workers.push_back(make_unique<Worker>(opt, mix, t, count, addr, *results.back()));
+    }
+
+    const int64_t start_ns = monotonicNowNs();
+    const int64_t warmup_end_ns = start_ns + static_cast<int64_t>(opt.warmup_sec * 1e9);
+    const int64_t end_ns = warmup_end_ns + static_cast<int64_t>(opt.duration_sec * 1e9);
+
+    vector<thread> threads;
+    for (auto &w : workers)
+        threads.emplace_back([&, wp = w.get()]
+                             { wp->run(start_ns, warmup_end_ns, end_ns); });
+    for (auto &t : threads)
+        t.join();
+
+    printReport(opt, results);
+    return 0;
+}
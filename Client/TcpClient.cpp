@@ -1,98 +1,130 @@
-#include <arpa/inet.h>
-#include <netinet/in.h>
-#include <sys/socket.h>
 #include <unistd.h>
 
+#include <cstring>
+#include <deque>
+#include <future>
 #include <iostream>
+#include <mutex>
 #include <string>
 #include "json.hpp"
+#include "ClientPool.h"
 
 using namespace std;
-using namespace std::chrono;
 
-static bool recvAll(int fd, void *buf, size_t len)
+static mutex print_mutex; // 응답(메인 스레드)과 푸시(I/O 스레드) 출력이 섞이지 않게
+
+static void printResponse(const nlohmann::json &resp)
 {
-    char *p = static_cast<char *>(buf);
-    size_t got = 0;
-    while (got < len)
-    {
-        ssize_t r = ::recv(fd, p + got, len - got, 0);
-        if (r == 0)
-            return false; // peer closed
-        if (r < 0)
-        {
-            if (errno == EINTR)
-                continue;
-            return false;
-        }
-        got += static_cast<size_t>(r);
-    }
-    return true;
+    lock_guard<mutex> lock(print_mutex);
+    cout << "[RESPONSE]\n"
+         << resp.dump(2) << "\n";
 }
 
-static bool sendAll(int fd, const void *buf, size_t len)
+// 구독한 topic 메시지 등 req_id 없는 서버 푸시
+static void printPush(const nlohmann::json &msg)
 {
-    const char *p = static_cast<const char *>(buf);
-    size_t sent = 0;
-    while (sent < len)
+    lock_guard<mutex> lock(print_mutex);
+    cout << "[PUSH]\n"
+         << msg.dump(2) << "\n";
+}
+
+// "55000", "55001,55002", "55001-55010" (run_multi.sh로 띄운 서버 묶음)
+static vector<int> parsePorts(const string &spec)
+{
+    vector<int> ports;
+    size_t pos = 0;
+    while (pos <= spec.size())
     {
-        ssize_t s = ::send(fd, p + sent, len - sent, 0);
-        if (s <= 0)
+        size_t comma = spec.find(',', pos);
+        string item = spec.substr(pos, comma == string::npos ? string::npos : comma - pos);
+        size_t dash = item.find('-');
+        if (dash != string::npos)
+        {
+            int first = stoi(item.substr(0, dash));
+            int last = stoi(item.substr(dash + 1));
+            for (int p = first; p <= last; ++p)
+                ports.push_back(p);
+        }
+        else if (!item.empty())
         {
-            if (s < 0 && errno == EINTR)
-                continue;
-            return false;
+            ports.push_back(stoi(item));
         }
-        sent += static_cast<size_t>(s);
+        if (comma == string::npos)
+            break;
+        pos = comma + 1;
     }
-    return true;
+    return ports;
 }
 
 int main(int argc, char **argv)
 {
-    char *SERVER_IP = "127.0.0.1";
-    int SERVER_PORT = 55000;
+    string server_ip = "127.0.0.1";
+    vector<int> ports = {55000};
+    int connections_per_endpoint = 1;
 
     if (argc >= 2)
     {
         if (strcmp(argv[1], "d") != 0)
-            SERVER_IP = argv[1];
+            server_ip = argv[1];
     }
     if (argc >= 3)
     {
-        SERVER_PORT = std::stoi(argv[2]);
+        ports = parsePorts(argv[2]);
+    }
+    if (argc >= 4)
+    {
+        connections_per_endpoint = std::stoi(argv[3]);
     }
 
-    // 소켓 생성
-    int sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0)
+    msgnet::ClientPoolConfig config;
+    if (server_ip.rfind("unix:", 0) == 0 || server_ip.rfind("shm:", 0) == 0 || server_ip.rfind("@", 0) == 0)
     {
-        perror("socket");
-        return 1;
+        // AF_UNIX: "unix:/tmp/msgnet.sock" 또는 "@msgnet" (포트 인자는 무시)
+        // "shm:/tmp/msgnet.sock", "shm:@msgnet": 같은 소켓으로 붙은 뒤 공유 메모리 링으로 전환
+        msgnet::PoolEndpoint ep;
+        ep.shm = server_ip.rfind("shm:", 0) == 0;
+        ep.unix_path = server_ip[0] == '@' ? server_ip : server_ip.substr(server_ip.find(':') + 1);
+        config.endpoints.push_back(ep);
     }
+    else
+    {
+        for (int port : ports)
+        {
+            msgnet::PoolEndpoint ep;
+            ep.host = server_ip;
+            ep.port = port;
+            config.endpoints.push_back(ep);
+        }
+    }
+    config.connections_per_endpoint = connections_per_endpoint;
+    config.message_handler = printPush;
 
-    sockaddr_in addr{};
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(SERVER_PORT);
-    inet_pton(AF_INET, SERVER_IP, &addr.sin_addr);
+    msgnet::ClientPool pool(config);
 
-    // 연결
-    if (connect(sock, (sockaddr *)&addr, sizeof(addr)) < 0)
+    // 연결 (하나라도 되면 시작, 나머지는 백그라운드에서 재시도)
+    if (!pool.start())
     {
         perror("connect");
-        close(sock);
         return 1;
     }
 
-    cout << "Connected to server\n";
-    cout << "Enter JSON (one line). Ctrl+D to quit.\n\n";
+    // 표준 입력이 터미널이 아니면 (파일/파이프) 모든 줄을 응답을 기다리지 않고 파이프라이닝한다
+    const bool interactive = isatty(STDIN_FILENO);
+
+    cout << "Connected to server (" << pool.connectedCount() << " connections)\n";
+    if (interactive)
+        cout << "Enter JSON (one line). Ctrl+D to quit.\n\n";
 
+    deque<future<nlohmann::json>> in_flight;
     string line;
     while (true)
     {
-        cout << "> ";
+        if (interactive)
+            cout << "> ";
         if (!getline(cin, line))
             break;
+        if (line.empty())
+            continue;
 
         // JSON 파싱 검사
         auto j = nlohmann::json::parse(line, nullptr, false);
@@ -102,50 +134,36 @@ int main(int argc, char **argv)
             continue;
         }
 
-        string payload = j.dump();
-
-        // length prefix
-        uint32_t len = htonl(payload.size());
-
-        if (!sendAll(sock, &len, sizeof(len)) ||
-            !sendAll(sock, payload.data(), payload.size()))
-        {
-            cerr << "Send failed\n";
-            break;
-        }
-
-        // 응답 수신
-        uint32_t resp_len_net;
-        if (!recvAll(sock, &resp_len_net, sizeof(resp_len_net)))
+        // 한 줄이 JSON 배열이면 배치 프레임 하나로 보낸다 (응답도 배열 하나)
+        if (j.is_array())
+            in_flight.push_back(pool.requestBatch(j.get<vector<nlohmann::json>>()));
+        else
+            in_flight.push_back(pool.request(std::move(j)));
+        if (interactive)
         {
-            cerr << "Server closed connection\n";
-            break;
+            printResponse(in_flight.front().get());
+            in_flight.pop_front();
         }
+    }
 
-        uint32_t resp_len = ntohl(resp_len_net);
-        string resp(resp_len, '\0');
-
-        if (!recvAll(sock, resp.data(), resp_len))
-        {
-            cerr << "Failed to receive response\n";
-            break;
-        }
+    // 파이프라이닝한 요청은 보낸 순서대로 출력
+    for (auto &f : in_flight)
+        printResponse(f.get());
 
-        // 출력
-        auto resp_json = nlohmann::json::parse(resp, nullptr, false);
-        if (resp_json.is_discarded())
-        {
-            cout << "[RAW RESPONSE]\n"
-                 << resp << "\n";
-        }
-        else
+    // 연결별 통계
+    auto stats = pool.stats();
+    if (stats.size() > 1)
+    {
+        for (const auto &s : stats)
         {
-            cout << "[RESPONSE]\n"
-                 << resp_json.dump(2) << "\n";
+            cerr << "[Pool] " << s.endpoint << (s.connected ? "" : " (down)")
+                 << " requests=" << s.requests << " errors=" << s.errors
+                 << " reconnects=" << s.reconnects
+                 << " p50=" << s.latency.p50_ns / 1000 << "us p99=" << s.latency.p99_ns / 1000 << "us\n";
         }
     }
 
-    close(sock);
+    pool.stop();
     cout << "Disconnected\n";
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace msgnet
+{
+
+// recv_queue_ 앞의 입장 제어 설정 (CoDel 방식)
+struct AdmissionConfig
+{
+    int target_ms = 0;     // 큐 대기(sojourn)가 이보다 길게 유지되면 과부하로 본다 (0: 끔)
+    int interval_ms = 100; // target을 넘는 상태가 이만큼 이어져야 거절을 시작한다
+
+    bool enabled() const
+    {
+        return target_ms > 0;
+    }
+};
+
+// 큐 대기 시간 기반 과부하 판단 (CoDel: 구간 안의 최소 대기 시간이 target을 넘으면 "나쁜 큐")
+// - 처리 스레드가 꺼낼 때마다 observe(대기 시간)를 부른다. target 아래 값이 하나라도 나오면 과부하가 아니다
+//   (구간의 최소값이 target 아래라는 뜻). target 위 값만 interval 동안 이어지면 shedding 상태가 된다
+// - recv 스레드는 shedding()을 보고 낮은 우선순위 요청을 큐에 넣지 않고 바로 "overloaded"로 답한다
+// - 처리 스레드의 관측이 interval 동안 끊기면 recv 스레드가 큐 맨 앞 요청의 대기 시간을 대신 관측한다
+//   거절로 큐가 비었으면(0) shedding을 풀고, 처리 스레드가 모두 막혀 맨 앞이 오래 기다리면 계속(또는 새로) 거절한다
+// - 여러 스레드가 락 없이 갱신한다. 경합으로 판단이 한 번 늦거나 빨라지는 정도는 허용
+class AdmissionController
+{
+public:
+    void configure(const AdmissionConfig &config)
+    {
+        target_ns_ = static_cast<int64_t>(config.target_ms) * 1000000;
+        interval_ns_ = static_cast<int64_t>(config.interval_ms) * 1000000;
+    }
+
+    bool enabled() const
+    {
+        return target_ns_ > 0;
+    }
+
+    void observe(int64_t sojourn_ns, int64_t now_ns)
+    {
+        last_observe_ns_.store(now_ns, std::memory_order_relaxed);
+        if (sojourn_ns < target_ns_)
+        {
+            if (first_above_ns_.load(std::memory_order_relaxed) != 0)
+                first_above_ns_.store(0, std::memory_order_relaxed);
+            if (shedding_.load(std::memory_order_relaxed))
+                shedding_.store(false, std::memory_order_relaxed);
+            return;
+        }
+
+        int64_t first_above = first_above_ns_.load(std::memory_order_relaxed);
+        if (first_above == 0)
+            first_above_ns_.compare_exchange_strong(first_above, now_ns, std::memory_order_relaxed);
+        else if (now_ns - first_above >= interval_ns_ && !shedding_.load(std::memory_order_relaxed))
+            shedding_.store(true, std::memory_order_relaxed);
+    }
+
+    // 지금 낮은 우선순위 요청을 거절해야 하는지 (recv 스레드)
+    // head_sojourn(): 큐 맨 앞 요청의 대기 시간 (비었으면 0). 관측이 끊겼을 때만 부른다 (큐 락을 요청마다 잡지 않게)
+    template <typename HeadSojourn>
+    bool shedding(int64_t now_ns, HeadSojourn &&head_sojourn)
+    {
+        if (now_ns - last_observe_ns_.load(std::memory_order_relaxed) >= interval_ns_)
+            observe(head_sojourn(), now_ns);
+        return shedding_.load(std::memory_order_relaxed);
+    }
+
+    bool sheddingNow() const
+    {
+        return shedding_.load(std::memory_order_relaxed);
+    }
+
+private:
+    int64_t target_ns_ = 0;
+    int64_t interval_ns_ = 0;
+    std::atomic<int64_t> first_above_ns_{0}; // target을 처음 넘은 시각 (0: target 아래)
+    std::atomic<int64_t> last_observe_ns_{0};
+    std::atomic<bool> shedding_{false};
+};
+
+} // namespace msgnet
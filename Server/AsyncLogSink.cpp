@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "AsyncLogSink.h"
+
+namespace msgnet
+{
+
+namespace
+{
+
+std::atomic<uint64_t> g_sink_generation{1};
+
+// 스레드별 링 보관소. 스레드가 끝나면 링을 retire 표시해서 writer가 정리하게 한다.
+struct LocalRingSlot
+{
+    uint64_t generation = 0;
+    std::shared_ptr<LogRing> ring;
+
+    ~LocalRingSlot()
+    {
+        if (ring)
+            ring->retire();
+    }
+};
+
+thread_local LocalRingSlot t_ring_slot;
+
+const char *levelName(uint8_t level)
+{
+    static const char *names[] = {"DEBUG", "INFO ", "WARN ", "ERROR"};
+    return level < 4 ? names[level] : "UNKNOWN";
+}
+
+size_t roundUpPow2(size_t v)
+{
+    size_t p = 1;
+    while (p < v)
+        p <<= 1;
+    return p;
+}
+
+} // namespace
+
+LogRing::LogRing(size_t capacity)
+    : capacity_(roundUpPow2(std::max<size_t>(capacity, 2))),
+      mask_(capacity_ - 1),
+      slots_(new LogRecord[capacity_])
+{
+}
+
+AsyncLogSink::AsyncLogSink(AsyncLogConfig config)
+    : config_(std::move(config)),
+      generation_(g_sink_generation.fetch_add(1, std::memory_order_relaxed))
+{
+    if (config_.path.empty())
+    {
+        fd_ = STDOUT_FILENO;
+    }
+    else
+    {
+        fd_ = ::open(config_.path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd_ < 0)
+        {
+            perror("open log file");
+            accepting_ = false;
+            return;
+        }
+        owns_fd_ = true;
+    }
+
+    out_.reserve(256 * 1024);
+    writer_ = std::thread(&AsyncLogSink::writerLoop, this);
+}
+
+AsyncLogSink::~AsyncLogSink()
+{
+    shutdown();
+    if (owns_fd_)
+        ::close(fd_);
+}
+
+LogRing &AsyncLogSink::localRing()
+{
+    if (t_ring_slot.generation != generation_)
+    {
+        if (t_ring_slot.ring)
+            t_ring_slot.ring->retire();
+
+        t_ring_slot.ring = std::make_shared<LogRing>(config_.ring_capacity);
+        t_ring_slot.generation = generation_;
+
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.push_back(t_ring_slot.ring);
+    }
+    return *t_ring_slot.ring;
+}
+
+void AsyncLogSink::shutdown()
+{
+    accepting_.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stop_ = true;
+    }
+    wake_cv_.notify_all();
+
+    if (writer_.joinable())
+        writer_.join();
+}
+
+uint64_t AsyncLogSink::droppedCount() const
+{
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    uint64_t total = retired_dropped_;
+    for (auto &ring : rings_)
+        total += ring->dropped();
+    return total;
+}
+
+void AsyncLogSink::writerLoop()
+{
+    while (!stop_.load(std::memory_order_acquire))
+    {
+        if (drainOnce() > 0)
+            continue;
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        wake_cv_.wait_for(lock, std::chrono::milliseconds(config_.flush_interval_ms),
+                          [&]
+                          { return stop_.load(); });
+    }
+
+    // 종료 전 남은 레코드 모두 기록
+    while (drainOnce() > 0)
+    {
+    }
+}
+
+size_t AsyncLogSink::drainOnce()
+{
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        snapshot_ = rings_;
+    }
+
+    // 1) 모든 링에서 게시된 레코드를 모아 시간순 정렬
+    batch_.clear();
+    counts_.assign(snapshot_.size(), 0);
+    for (size_t i = 0; i < snapshot_.size(); ++i)
+    {
+        uint64_t first = 0;
+        size_t n = snapshot_[i]->peek(first);
+        counts_[i] = n;
+        for (size_t k = 0; k < n; ++k)
+            batch_.push_back(&snapshot_[i]->at(first + k));
+    }
+
+    std::stable_sort(batch_.begin(), batch_.end(),
+                     [](const LogRecord *a, const LogRecord *b)
+                     { return a->ts_ns < b->ts_ns; });
+
+    // 2) 한 버퍼로 포맷
+    for (const LogRecord *rec : batch_)
+    {
+        appendTimestamp(rec->ts_ns);
+        out_ += " [";
+        out_ += levelName(rec->level);
+        out_ += "] ";
+        out_.append(rec->text, rec->len);
+        if (rec->truncated)
+            out_ += "...";
+        out_ += '\n';
+    }
+
+    for (size_t i = 0; i < snapshot_.size(); ++i)
+    {
+        if (counts_[i] > 0)
+            snapshot_[i]->release(counts_[i]);
+    }
+
+    // 3) 드롭 발생 시 한 줄로 보고
+    uint64_t dropped = droppedCount();
+    if (dropped > reported_dropped_)
+    {
+        auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                       .count();
+        appendTimestamp(now);
+        out_ += " [WARN ] [Logger] dropped ";
+        out_ += std::to_string(dropped - reported_dropped_);
+        out_ += " log records (total ";
+        out_ += std::to_string(dropped);
+        out_ += ")\n";
+        reported_dropped_ = dropped;
+    }
+
+    flushBuffer();
+
+    // 4) 종료된 스레드의 빈 링 정리
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        for (auto it = rings_.begin(); it != rings_.end();)
+        {
+            uint64_t first = 0;
+            if ((*it)->retired() && (*it)->peek(first) == 0)
+            {
+                retired_dropped_ += (*it)->dropped();
+                it = rings_.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    return batch_.size();
+}
+
+void AsyncLogSink::appendTimestamp(int64_t ts_ns)
+{
+    const int64_t sec = ts_ns / 1000000000;
+    if (sec != cached_sec_)
+    {
+        std::time_t t = static_cast<std::time_t>(sec);
+        std::tm tm{};
+        localtime_r(&t, &tm);
+        std::strftime(cached_prefix_, sizeof(cached_prefix_), "%Y-%m-%d %H:%M:%S", &tm);
+        cached_sec_ = sec;
+    }
+
+    char ms[8];
+    std::snprintf(ms, sizeof(ms), ".%03d", static_cast<int>((ts_ns / 1000000) % 1000));
+    out_ += cached_prefix_;
+    out_ += ms;
+}
+
+void AsyncLogSink::flushBuffer()
+{
+    const char *p = out_.data();
+    size_t left = out_.size();
+    while (left > 0)
+    {
+        ssize_t w = ::write(fd_, p, left);
+        if (w < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break; // 기록 실패 시 버린다 (로깅 때문에 서버를 멈추지 않음)
+        }
+        p += w;
+        left -= static_cast<size_t>(w);
+    }
+    out_.clear();
+}
+
+} // namespace msgnet
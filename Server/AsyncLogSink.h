@@ -0,0 +1,185 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace msgnet
+{
+
+// 링 버퍼가 가득 찼을 때의 동작
+enum class LogOverflowPolicy
+{
+    DROP,  // 새 레코드를 버리고 드롭 카운터 증가 (기본, 핫 패스를 절대 막지 않음)
+    BLOCK, // 공간이 생길 때까지 양보하며 대기 (디버깅용). 싱크가 멈추면 동기 출력으로 넘어간다
+};
+
+struct AsyncLogConfig
+{
+    std::string path;                 // 로그 파일 경로 (비어 있으면 stdout)
+    size_t ring_capacity = 8192;      // 스레드별 레코드 수 (2의 거듭제곱으로 올림)
+    int flush_interval_ms = 5;        // writer 스레드가 쉬는 최대 시간
+    LogOverflowPolicy overflow = LogOverflowPolicy::DROP;
+};
+
+// 고정 크기 레코드 (256 bytes). 포맷이 끝난 텍스트를 담고, 넘치는 부분은 잘린다.
+struct LogRecord
+{
+    static constexpr size_t kTextSize = 240;
+
+    int64_t ts_ns;   // system_clock 기준 epoch 나노초
+    uint16_t len;
+    uint8_t level;
+    bool truncated;
+    char text[kTextSize];
+};
+
+// 단일 생산자(로그를 남기는 스레드) / 단일 소비자(writer 스레드) 링 버퍼
+class LogRing
+{
+public:
+    explicit LogRing(size_t capacity);
+
+    // 생산자: 쓸 슬롯을 얻는다. 가득 차 있으면 nullptr
+    LogRecord *tryAcquire()
+    {
+        const uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_cache_ >= capacity_)
+        {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head - tail_cache_ >= capacity_)
+                return nullptr;
+        }
+        return &slots_[head & mask_];
+    }
+
+    // 생산자: tryAcquire로 얻은 슬롯을 게시
+    void commit()
+    {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // 소비자: 게시된 레코드들을 [first, first + count) 범위로 본다
+    size_t peek(uint64_t &first) const
+    {
+        first = tail_.load(std::memory_order_relaxed);
+        return static_cast<size_t>(head_.load(std::memory_order_acquire) - first);
+    }
+
+    const LogRecord &at(uint64_t index) const { return slots_[index & mask_]; }
+
+    // 소비자: count개를 소비 완료 처리
+    void release(size_t count)
+    {
+        tail_.store(tail_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    void addDropped() { dropped_.fetch_add(1, std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    void retire() { retired_.store(true, std::memory_order_release); }
+    bool retired() const { return retired_.load(std::memory_order_acquire); }
+
+private:
+    alignas(64) std::atomic<uint64_t> head_{0};
+    uint64_t tail_cache_ = 0; // 생산자 전용
+    alignas(64) std::atomic<uint64_t> tail_{0};
+    alignas(64) std::atomic<uint64_t> dropped_{0};
+    std::atomic<bool> retired_{false};
+
+    size_t capacity_;
+    size_t mask_;
+    std::unique_ptr<LogRecord[]> slots_;
+};
+
+// LogRecord::text 위에 직접 포맷하는 streambuf (넘치면 잘라냄)
+class LogRecordBuf : public std::streambuf
+{
+public:
+    void reset(LogRecord &rec)
+    {
+        rec_ = &rec;
+        rec.truncated = false;
+        setp(rec.text, rec.text + LogRecord::kTextSize);
+    }
+
+    size_t length() const { return static_cast<size_t>(pptr() - pbase()); }
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        if (rec_ && !traits_type::eq_int_type(ch, traits_type::eof()))
+            rec_->truncated = true;
+        return traits_type::eof();
+    }
+
+private:
+    LogRecord *rec_ = nullptr;
+};
+
+// 비동기 로그 백엔드
+// - 로그를 남기는 스레드는 자기 링에 포맷된 레코드만 넣고 바로 돌아간다 (락/시스템콜 없음)
+// - 백그라운드 writer 스레드가 모든 링을 모아 시간순으로 정렬한 뒤 한 번의 write()로 내보낸다
+// - 타임스탬프 문자열은 초 단위로 캐시해서 localtime_r 호출을 초당 1회로 줄인다
+class AsyncLogSink
+{
+public:
+    explicit AsyncLogSink(AsyncLogConfig config);
+    ~AsyncLogSink();
+
+    AsyncLogSink(const AsyncLogSink &) = delete;
+    AsyncLogSink &operator=(const AsyncLogSink &) = delete;
+
+    bool isOpen() const { return fd_ >= 0; }
+
+    // 호출 스레드 전용 링 (최초 호출 시 등록)
+    LogRing &localRing();
+
+    LogOverflowPolicy overflowPolicy() const { return config_.overflow; }
+
+    // writer 스레드를 멈추고 남은 레코드를 모두 기록
+    void shutdown();
+
+    bool accepting() const { return accepting_.load(std::memory_order_acquire); }
+
+    // 링이 가득 차서 버려진 레코드 수 (전체 스레드 합계)
+    uint64_t droppedCount() const;
+
+private:
+    void writerLoop();
+    size_t drainOnce();
+    void appendTimestamp(int64_t ts_ns);
+    void flushBuffer();
+
+    AsyncLogConfig config_;
+    int fd_ = -1;
+    bool owns_fd_ = false;
+    uint64_t generation_;
+
+    mutable std::mutex rings_mutex_;
+    std::vector<std::shared_ptr<LogRing>> rings_;
+    uint64_t retired_dropped_ = 0; // 제거된 링의 드롭 수 누적 (rings_mutex_ 보호)
+
+    std::atomic<bool> accepting_{true};
+    std::atomic<bool> stop_{false};
+    std::mutex wake_mutex_;
+    std::condition_variable wake_cv_;
+    std::thread writer_;
+
+    // writer 스레드 전용 상태 (매 배치마다 재사용)
+    std::vector<std::shared_ptr<LogRing>> snapshot_;
+    std::vector<const LogRecord *> batch_;
+    std::vector<size_t> counts_;
+    std::string out_;
+    int64_t cached_sec_ = -1;
+    char cached_prefix_[32] = {};
+    uint64_t reported_dropped_ = 0;
+};
+
+} // namespace msgnet
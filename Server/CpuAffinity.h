@@ -0,0 +1,90 @@
+#pragma once
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace msgnet
+{
+
+// 스레드 역할별 CPU 목록 (비어 있으면 그 역할은 고정하지 않는다)
+// 역할의 i번째 스레드는 cpus[i % cpus.size()] 한 코어에 고정된다
+struct CpuAffinity
+{
+    std::vector<int> accept;
+    std::vector<int> recv;
+    std::vector<int> process;
+    std::vector<int> send;
+    // 새 연결을 SO_INCOMING_CPU(그 연결의 패킷을 처리한 코어)에 고정된 recv 스레드로 보낸다
+    // 그 코어에 recv 스레드가 없으면 같은 NUMA 노드의 recv 스레드, 그것도 없으면 라운드 로빈
+    bool steer_incoming_cpu = false;
+
+    bool enabled() const
+    {
+        return !accept.empty() || !recv.empty() || !process.empty() || !send.empty();
+    }
+};
+
+// "0-3,8,10-11" 형식. 형식이 틀리면 false
+inline bool parseCpuList(const std::string &spec, std::vector<int> &out)
+{
+    out.clear();
+    size_t pos = 0;
+    while (pos < spec.size())
+    {
+        size_t comma = spec.find(',', pos);
+        if (comma == std::string::npos)
+            comma = spec.size();
+        const std::string item = spec.substr(pos, comma - pos);
+        pos = comma + 1;
+        if (item.empty())
+            continue;
+
+        char *end = nullptr;
+        const long first = std::strtol(item.c_str(), &end, 10);
+        long last = first;
+        if (*end == '-')
+            last = std::strtol(end + 1, &end, 10);
+        if (*end != '\0' || first < 0 || last < first || last >= CPU_SETSIZE)
+            return false;
+        for (long cpu = first; cpu <= last; ++cpu)
+            out.push_back(static_cast<int>(cpu));
+    }
+    return !out.empty();
+}
+
+// 호출한 스레드를 cpus[index % size] 한 코어에 고정한다. 목록이 비어 있으면 아무것도 하지 않고 -1,
+// 실패하면 -1 (고정하지 않은 채로 계속 돈다). 성공하면 그 코어 번호
+// 스레드 전용 버퍼는 고정한 뒤에 만들어야 첫 접근(first-touch) 정책으로 그 코어의 NUMA 노드 메모리에 잡힌다
+inline int pinCurrentThread(const std::vector<int> &cpus, int index)
+{
+    if (cpus.empty())
+        return -1;
+    const int cpu = cpus[static_cast<size_t>(index) % cpus.size()];
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) != 0)
+        return -1;
+    return cpu;
+}
+
+// 코어가 속한 NUMA 노드 (sysfs의 cpuN/nodeM 링크). 알 수 없으면 -1
+inline int cpuNumaNode(int cpu)
+{
+    std::error_code ec;
+    const std::filesystem::path dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    for (const auto &entry : std::filesystem::directory_iterator(dir, ec))
+    {
+        const std::string name = entry.path().filename().string();
+        if (name.size() > 4 && name.compare(0, 4, "node") == 0)
+            return std::atoi(name.c_str() + 4);
+    }
+    return -1;
+}
+
+} // namespace msgnet
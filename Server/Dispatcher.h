@@ -1,6 +1,8 @@
+#pragma once
 #include <unordered_map>
 #include <functional>
 #include <utility>
+#include <vector>
 
 #include "json.hpp"
 #include "Message.h"
@@ -9,6 +11,46 @@
 namespace msgnet
 {
 
+// 에러 응답의 reason 분류 (메트릭 라벨로 사용)
+enum class ErrorReason
+{
+    NONE = 0,
+    INVALID_JSON,            // 수신 경로: JSON 파싱 실패
+    MISSING_OR_INVALID_TYPE, // type 필드 없음/문자열 아님
+    UNKNOWN_TYPE,            // 등록되지 않은 type
+    HANDLER_EXCEPTION,       // 핸들러가 예외를 던짐
+    SHM_UNAVAILABLE,         // 공유 메모리 전송 요청을 받을 수 없음 (TCP 연결, memfd 생성 실패)
+    DEADLINE_EXCEEDED,       // 처리 차례가 오기 전에 요청 기한이 지남 (핸들러를 부르지 않음)
+    OVERLOADED,              // 입장 제어가 과부하로 판단해 큐에 넣지 않고 거절
+    RATE_LIMITED,            // 연결/메시지 type별 요청 수 제한을 넘음
+    COUNT
+};
+
+inline const char *errorReasonName(ErrorReason reason)
+{
+    switch (reason)
+    {
+    case ErrorReason::INVALID_JSON:
+        return "invalid_json";
+    case ErrorReason::MISSING_OR_INVALID_TYPE:
+        return "missing_or_invalid_type";
+    case ErrorReason::UNKNOWN_TYPE:
+        return "unknown_type";
+    case ErrorReason::HANDLER_EXCEPTION:
+        return "handler_exception";
+    case ErrorReason::SHM_UNAVAILABLE:
+        return "shm_unavailable";
+    case ErrorReason::DEADLINE_EXCEEDED:
+        return "deadline_exceeded";
+    case ErrorReason::OVERLOADED:
+        return "overloaded";
+    case ErrorReason::RATE_LIMITED:
+        return "rate_limited";
+    default:
+        return "none";
+    }
+}
+
 class Dispatcher
 {
 public:
@@ -19,16 +61,32 @@ public:
         handlers_[type] = std::move(fn);
     }
 
-    nlohmann::json dispatch(const Message &msg) const
+    bool hasMessageHandler(const std::string &type) const
+    {
+        return handlers_.count(type) > 0;
+    }
+
+    // 등록된 메시지 타입 목록 (통계/메트릭 슬롯 구성용)
+    std::vector<std::string> messageTypes() const
+    {
+        std::vector<std::string> types;
+        types.reserve(handlers_.size());
+        for (auto &[type, fn] : handlers_)
+            types.push_back(type);
+        return types;
+    }
+
+    // error가 주어지면 에러 응답을 만든 경우 그 분류를 기록한다
+    nlohmann::json dispatch(const Message &msg, ErrorReason *error = nullptr) const
     {
         // 통신에 필요한 항목만 체크한다.
 
         const nlohmann::json &req = msg.json;
-        const int client_id = msg.client_id;
 
         // type 체크
         if (!req.contains("type") || !req["type"].is_string())
         {
+            setError(error, ErrorReason::MISSING_OR_INVALID_TYPE);
             return makeError(req, "missing_or_invalid_type");
         }
 
@@ -36,22 +94,22 @@ public:
         auto it = handlers_.find(type);
         if (it == handlers_.end())
         {
+            setError(error, ErrorReason::UNKNOWN_TYPE);
             return makeError(req, "unknown_type: " + type);
         }
 
         try
         {
+            setError(error, ErrorReason::NONE);
             return it->second(msg);
         }
         catch (const std::exception &e)
         {
+            setError(error, ErrorReason::HANDLER_EXCEPTION);
             return makeError(req, std::string("handler_exception: ") + e.what());
         }
     }
 
-private:
-    std::unordered_map<std::string, MessageHandler> handlers_;
-
     static nlohmann::json makeError(const nlohmann::json &req, const std::string &reason)
     {
         nlohmann::json res;
@@ -62,6 +120,15 @@ private:
             res["req_id"] = req["req_id"];
         return res;
     }
+
+private:
+    std::unordered_map<std::string, MessageHandler> handlers_;
+
+    static void setError(ErrorReason *out, ErrorReason reason)
+    {
+        if (out)
+            *out = reason;
+    }
 };
 
 } // namespace msgnet
\ No newline at end of file
@@ -34,7 +34,8 @@ json ExampleMessageHandler::handlePing(const Message &msg)
     res["req_id"] = req["req_id"];
 
     res["payload"] = {
-        {"server_ts", static_cast<int64_t>(time(nullptr))}};
+        {"server_ts", static_cast<int64_t>(time(nullptr))},
+        {"port", msg.local_port}};
 
     return res;
 }
@@ -0,0 +1,71 @@
+#pragma once
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "json.hpp"
+
+namespace msgnet
+{
+
+// 길이 프리픽스 프레임: [uint32 big-endian length][payload (JSON)]
+constexpr size_t kFrameHeaderSize = sizeof(uint32_t);
+constexpr uint32_t kMaxFrameSize = 4 * 1024 * 1024; // 방어(4MB 제한)
+
+// 연결 유지 확인용 프레임 type. 서버가 보내면 클라이언트가 같은 프레임으로 답하고, 양쪽 모두 디스패치하지 않는다
+constexpr const char *kHeartbeatType = "heartbeat";
+
+// 서버가 종료(drain)에 들어갔다는 푸시. 클라이언트는 이 연결로 새 요청을 보내지 말고 남은 응답만 받은 뒤 다시 연결한다
+constexpr const char *kGoawayType = "goaway";
+
+inline bool isValidFrameLength(uint32_t len)
+{
+    return len != 0 && len <= kMaxFrameSize;
+}
+
+// payload 앞에 길이를 붙여 out 뒤에 이어 쓴다 (헤더와 본문을 send 한 번으로 보낼 수 있게)
+inline void appendFrame(std::string &out, std::string_view payload)
+{
+    const uint32_t len_net = htonl(static_cast<uint32_t>(payload.size()));
+    out.append(reinterpret_cast<const char *>(&len_net), sizeof(len_net));
+    out.append(payload.data(), payload.size());
+}
+
+// JSON 하나를 직렬화해서 완성된 프레임으로 만든다
+inline std::string encodeFrame(const nlohmann::json &j)
+{
+    const std::string body = j.dump();
+    std::string frame;
+    frame.reserve(kFrameHeaderSize + body.size());
+    appendFrame(frame, body);
+    return frame;
+}
+
+enum class FrameStatus
+{
+    COMPLETE,       // payload에 프레임 하나가 채워짐
+    INCOMPLETE,     // 데이터가 더 필요함
+    INVALID_LENGTH, // 길이가 0이거나 kMaxFrameSize 초과
+};
+
+// data[0, size) 맨 앞의 프레임을 해석한다. COMPLETE면 소비한 바이트 수는 kFrameHeaderSize + payload.size()
+inline FrameStatus decodeFrame(const char *data, size_t size, std::string_view &payload)
+{
+    if (size < kFrameHeaderSize)
+        return FrameStatus::INCOMPLETE;
+
+    uint32_t len_net;
+    std::memcpy(&len_net, data, sizeof(len_net));
+    const uint32_t len = ntohl(len_net);
+    if (!isValidFrameLength(len))
+        return FrameStatus::INVALID_LENGTH;
+    if (size - kFrameHeaderSize < len)
+        return FrameStatus::INCOMPLETE;
+
+    payload = std::string_view(data + kFrameHeaderSize, len);
+    return FrameStatus::COMPLETE;
+}
+
+} // namespace msgnet
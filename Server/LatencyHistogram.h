@@ -0,0 +1,194 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace msgnet
+{
+
+// 단계별 지연 측정에 쓰는 단조 시계 (ns)
+inline int64_t monotonicNowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// 지연 시간 요약 (ns 단위)
+struct LatencySummary
+{
+    uint64_t count = 0;
+    uint64_t min_ns = 0;
+    uint64_t max_ns = 0;
+    double mean_ns = 0.0;
+    uint64_t p50_ns = 0;
+    uint64_t p90_ns = 0;
+    uint64_t p99_ns = 0;
+    uint64_t p999_ns = 0;
+};
+
+// HDR 스타일 로그-선형 히스토그램 (ns 단위, 상대 오차 ~3%, 최대 약 73분)
+// - 한 스레드만 record()하고, 다른 스레드는 언제든 merge/summary로 읽는다
+// - 기록은 relaxed load/store라서 락과 RMW 명령이 없다
+class LatencyHistogram
+{
+public:
+    static constexpr int kSubBits = 5;                        // 옥타브당 32개 구간
+    static constexpr int kHalf = 1 << (kSubBits - 1);         // 16
+    static constexpr int kMaxMsb = 41;                        // 2^42 ns ≈ 73분
+    static constexpr int kBuckets = (kMaxMsb - kSubBits + 2) * kHalf + kHalf;
+    static constexpr uint64_t kMaxValue = (1ull << (kMaxMsb + 1)) - 1;
+
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    static int bucketIndex(uint64_t v)
+    {
+        if (v > kMaxValue)
+            v = kMaxValue;
+        if (v < (1u << kSubBits))
+            return static_cast<int>(v);
+        const int msb = 63 - __builtin_clzll(v);
+        const int shift = msb - (kSubBits - 1);
+        return shift * kHalf + static_cast<int>(v >> shift);
+    }
+
+    // 구간의 대표 값 (구간 중앙)
+    static uint64_t bucketValue(int index)
+    {
+        if (index < (1 << kSubBits))
+            return static_cast<uint64_t>(index);
+        const int shift = index / kHalf - 1;
+        const uint64_t sub = static_cast<uint64_t>(index - shift * kHalf);
+        const uint64_t low = sub << shift;
+        return low + ((1ull << shift) >> 1);
+    }
+
+    // 단일 기록자 전용
+    void record(uint64_t ns)
+    {
+        bump(counts_[bucketIndex(ns)], 1);
+        bump(total_count_, 1);
+        bump(total_sum_, ns);
+        if (ns < min_.load(std::memory_order_relaxed))
+            min_.store(ns, std::memory_order_relaxed);
+        if (ns > max_.load(std::memory_order_relaxed))
+            max_.store(ns, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const { return total_count_.load(std::memory_order_relaxed); }
+
+    // 읽기 측: 여러 스레드의 히스토그램을 하나로 합칠 때 사용
+    template <typename Fn>
+    void forEachBucket(Fn &&fn) const
+    {
+        for (int i = 0; i < kBuckets; ++i)
+        {
+            uint64_t c = counts_[i].load(std::memory_order_relaxed);
+            if (c)
+                fn(i, c);
+        }
+    }
+
+    uint64_t sum() const { return total_sum_.load(std::memory_order_relaxed); }
+    uint64_t min() const { return min_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+private:
+    static void bump(std::atomic<uint64_t> &a, uint64_t v)
+    {
+        a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, kBuckets> counts_{};
+    std::atomic<uint64_t> total_count_{0};
+    std::atomic<uint64_t> total_sum_{0};
+    std::atomic<uint64_t> min_{UINT64_MAX};
+    std::atomic<uint64_t> max_{0};
+};
+
+// 읽기 전용 합산 결과 (스레드별 히스토그램을 merge해서 백분위 계산)
+class HistogramSnapshot
+{
+public:
+    void merge(const LatencyHistogram &h)
+    {
+        if (h.count() == 0)
+            return;
+        h.forEachBucket([&](int i, uint64_t c)
+                        { counts_[i] += c; });
+        count_ += h.count();
+        sum_ += h.sum();
+        min_ = std::min(min_, h.min());
+        max_ = std::max(max_, h.max());
+    }
+
+    void merge(const HistogramSnapshot &other)
+    {
+        for (int i = 0; i < LatencyHistogram::kBuckets; ++i)
+            counts_[i] += other.counts_[i];
+        count_ += other.count_;
+        sum_ += other.sum_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t sum() const { return sum_; }
+
+    // q: 0.0 ~ 1.0
+    uint64_t percentile(double q) const
+    {
+        if (count_ == 0)
+            return 0;
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count_));
+        if (rank >= count_)
+            rank = count_ - 1;
+        uint64_t seen = 0;
+        for (int i = 0; i < LatencyHistogram::kBuckets; ++i)
+        {
+            seen += counts_[i];
+            if (seen > rank)
+                return std::clamp(LatencyHistogram::bucketValue(i), min_, max_);
+        }
+        return max_;
+    }
+
+    // 누적 분포 (Prometheus 등에서 사용): value 이하인 샘플 수
+    uint64_t countAtOrBelow(uint64_t value) const
+    {
+        const int last = LatencyHistogram::bucketIndex(value);
+        uint64_t c = 0;
+        for (int i = 0; i <= last; ++i)
+            c += counts_[i];
+        return c;
+    }
+
+    LatencySummary summary() const
+    {
+        LatencySummary s;
+        s.count = count_;
+        if (count_ == 0)
+            return s;
+        s.min_ns = min_;
+        s.max_ns = max_;
+        s.mean_ns = static_cast<double>(sum_) / static_cast<double>(count_);
+        s.p50_ns = percentile(0.50);
+        s.p90_ns = percentile(0.90);
+        s.p99_ns = percentile(0.99);
+        s.p999_ns = percentile(0.999);
+        return s;
+    }
+
+private:
+    std::array<uint64_t, LatencyHistogram::kBuckets> counts_{};
+    uint64_t count_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t min_ = UINT64_MAX;
+    uint64_t max_ = 0;
+};
+
+} // namespace msgnet
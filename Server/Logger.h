@@ -1,10 +1,23 @@
 #pragma once
+#include <atomic>
 #include <iostream>
 #include <sstream>
 #include <mutex>
 #include <chrono>
 #include <iomanip>
 #include <ctime>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "AsyncLogSink.h"
+#include "TraceLog.h"
+
+// 컴파일 타임 최소 로그 레벨 (0=DEBUG .. 4=NONE). CMake의 LOG_MIN_LEVEL로 지정한다.
+// 이보다 낮은 레벨의 LOG_* 매크로는 인자 평가를 포함해 코드가 생성되지 않는다.
+#ifndef MSGNET_LOG_MIN_LEVEL
+#define MSGNET_LOG_MIN_LEVEL 0
+#endif
 
 namespace msgnet
 {
@@ -29,13 +42,76 @@ public:
 
     void setLevel(LogLevel level)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        level_ = level;
+        level_.store(level, std::memory_order_relaxed);
     }
 
     LogLevel getLevel() const
     {
-        return level_;
+        return level_.load(std::memory_order_relaxed);
+    }
+
+    // 런타임 레벨 검사 (relaxed load 한 번). LOG_* 매크로가 인자 평가 전에 호출한다.
+    bool isEnabled(LogLevel level) const
+    {
+        return level >= level_.load(std::memory_order_relaxed);
+    }
+
+    // 비동기 백엔드 시작: 이후 로그는 스레드별 링에 쌓이고 writer 스레드가 파일로 배치 기록한다
+    bool startAsync(const AsyncLogConfig &config)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (async_.load(std::memory_order_acquire))
+            return true;
+
+        auto sink = std::make_unique<AsyncLogSink>(config);
+        if (!sink->isOpen())
+            return false;
+
+        async_.store(sink.get(), std::memory_order_release);
+        sinks_.push_back(std::move(sink));
+        return true;
+    }
+
+    // 비동기 백엔드 종료 (남은 레코드는 모두 기록). 이후 로그는 다시 동기 출력된다.
+    // sink 객체는 Logger 소멸 시까지 유지해서, 동시에 로그를 남기던 스레드가 댕글링 포인터를 보지 않게 한다.
+    void stopAsync()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        AsyncLogSink *sink = async_.exchange(nullptr, std::memory_order_acq_rel);
+        if (sink)
+            sink->shutdown();
+    }
+
+    // 링이 가득 차서 버려진 레코드 수
+    uint64_t droppedCount() const
+    {
+        AsyncLogSink *sink = async_.load(std::memory_order_acquire);
+        return sink ? sink->droppedCount() : 0;
+    }
+
+    // 바이너리 트레이스 모드: 메시지 단위 이벤트를 mmap 링 파일에 기록 (디코드는 trace_decode)
+    // stopTrace()는 트레이스를 남기는 스레드가 모두 멈춘 뒤(TcpServer::stop()/drain()이 돌아온 뒤) 호출해야 한다.
+    // 링을 munmap하므로 그 전에 부르면 enabled()를 통과한 record()가 해제된 메모리에 쓴다.
+    bool startTrace(const TraceLogConfig &config)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return trace_.open(config);
+    }
+
+    void stopTrace()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        trace_.close();
+    }
+
+    bool traceEnabled() const
+    {
+        return trace_.enabled();
+    }
+
+    void trace(TraceEvent event, int client_id, uint64_t req_hash, uint64_t arg = 0)
+    {
+        trace_.record(event, client_id, req_hash, arg);
     }
 
     template <typename... Args>
@@ -65,10 +141,21 @@ public:
 private:
     Logger() : level_(LogLevel::INFO) {}
 
+    ~Logger()
+    {
+        stopAsync();
+        stopTrace();
+    }
+
     template <typename... Args>
     void log(LogLevel level, Args &&...args)
     {
-        if (level < level_)
+        if (!isEnabled(level))
+            return;
+
+        AsyncLogSink *sink = async_.load(std::memory_order_acquire);
+        // BLOCK 대기 중에 싱크가 멈추면 false가 돌아오고 아래 동기 경로로 쓴다
+        if (sink && sink->accepting() && logAsync(*sink, level, args...))
             return;
 
         std::lock_guard<std::mutex> lock(mutex_);
@@ -103,6 +190,42 @@ private:
         }
     }
 
+    // 비동기 경로: 자기 링의 슬롯 위에 바로 포맷 (락, 할당, 시스템콜 없음)
+    // BLOCK 정책에서 기다리는 사이 싱크가 멈추면(writer가 더는 비우지 않음) 쓰지 않고 false
+    template <typename... Args>
+    bool logAsync(AsyncLogSink &sink, LogLevel level, const Args &...args)
+    {
+        LogRing &ring = sink.localRing();
+        LogRecord *rec = ring.tryAcquire();
+        while (!rec)
+        {
+            if (sink.overflowPolicy() == LogOverflowPolicy::DROP)
+            {
+                ring.addDropped();
+                return true;
+            }
+            if (!sink.accepting())
+                return false;
+            std::this_thread::yield();
+            rec = ring.tryAcquire();
+        }
+
+        rec->ts_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+        rec->level = static_cast<uint8_t>(level);
+
+        thread_local LogRecordBuf buf;
+        thread_local std::ostream os(&buf);
+        buf.reset(*rec);
+        os.clear();
+        (os << ... << args);
+        rec->len = static_cast<uint16_t>(buf.length());
+
+        ring.commit();
+        return true;
+    }
+
     const char *levelToString(LogLevel level) const
     {
         switch (level)
@@ -120,14 +243,40 @@ private:
         }
     }
 
-    LogLevel level_;
+    std::atomic<LogLevel> level_;
     std::mutex mutex_;
+
+    std::atomic<AsyncLogSink *> async_{nullptr};
+    std::vector<std::unique_ptr<AsyncLogSink>> sinks_;
+
+    TraceLog trace_;
 };
 
 // 편의 매크로
-#define LOG_DEBUG(...) Logger::instance().debug(__VA_ARGS__)
-#define LOG_INFO(...) Logger::instance().info(__VA_ARGS__)
-#define LOG_WARN(...) Logger::instance().warn(__VA_ARGS__)
-#define LOG_ERROR(...) Logger::instance().error(__VA_ARGS__)
+// - 컴파일 타임 최소 레벨 미만이면 if constexpr로 버려져 코드가 남지 않는다 (인자 타입 검사는 유지)
+// - 런타임 레벨 검사가 인자 평가보다 먼저 수행된다
+#define MSGNET_LOG_AT(level, method, ...)                                     \
+    do                                                                        \
+    {                                                                         \
+        if constexpr (static_cast<int>(level) >= MSGNET_LOG_MIN_LEVEL)        \
+        {                                                                     \
+            if (::msgnet::Logger::instance().isEnabled(level))                \
+                ::msgnet::Logger::instance().method(__VA_ARGS__);             \
+        }                                                                     \
+    } while (0)
+
+#define LOG_DEBUG(...) MSGNET_LOG_AT(::msgnet::LogLevel::DEBUG, debug, __VA_ARGS__)
+#define LOG_INFO(...) MSGNET_LOG_AT(::msgnet::LogLevel::INFO, info, __VA_ARGS__)
+#define LOG_WARN(...) MSGNET_LOG_AT(::msgnet::LogLevel::WARN, warn, __VA_ARGS__)
+#define LOG_ERROR(...) MSGNET_LOG_AT(::msgnet::LogLevel::ERROR, error, __VA_ARGS__)
+
+// 바이너리 트레이스 이벤트 (트레이스가 꺼져 있으면 acquire load 한 번. x86에서는 일반 load와 같다)
+#define LOG_TRACE_EVENT(event, client_id, req_hash, ...)                                       \
+    do                                                                                         \
+    {                                                                                          \
+        if (::msgnet::Logger::instance().traceEnabled())                                       \
+            ::msgnet::Logger::instance().trace(::msgnet::TraceEvent::event, (client_id),       \
+                                               (req_hash)__VA_OPT__(, ) __VA_ARGS__);           \
+    } while (0)
 
 } // namespace msgnet
\ No newline at end of file
@@ -1,14 +1,49 @@
+#include <atomic>
+#include <memory>
+#include <string>
+
 #include "json.hpp"
+#include "LatencyHistogram.h"
 
 #pragma once
 
 namespace msgnet
 {
 
+// 요청 취소 확인용. 오래 걸리는 핸들러는 중간에 cancelled()를 보고 일찍 끝낼 수 있다
+// - 클라이언트가 준 기한(deadline_ms / timeout_ms)이 지났거나 연결이 정리되면 취소된 것으로 본다
+struct CancelToken
+{
+    int64_t deadline_ns = 0;                                   // monotonicNowNs 기준 절대 시각, 0이면 기한 없음
+    std::shared_ptr<const std::atomic<bool>> closed = nullptr; // 연결이 정리되면 true
+
+    bool expired(int64_t now_ns) const
+    {
+        return deadline_ns != 0 && now_ns >= deadline_ns;
+    }
+
+    bool disconnected() const
+    {
+        return closed && closed->load(std::memory_order_relaxed);
+    }
+
+    bool cancelled() const
+    {
+        return disconnected() || expired(monotonicNowNs());
+    }
+};
+
 struct Message
 {
     int client_id;
     nlohmann::json json;
+    uint64_t req_hash = 0; // req_id 해시 (바이너리 트레이스가 켜져 있을 때만 채움)
+    int64_t recv_ns = 0;    // 요청 프레임 수신 시작 시각 (monotonicNowNs)
+    int64_t enqueue_ns = 0; // 현재 큐에 들어간 시각 (큐 대기 시간 측정용)
+    int local_port = 0;     // 요청을 받은 리스너 포트 (서버가 여러 포트를 열 때 핸들러가 구분용으로 사용)
+    std::shared_ptr<const std::string> frame = nullptr; // 이미 인코딩된 프레임 (브로드캐스트/발행: 구독자 전원이 같은 버퍼를 공유)
+    std::shared_ptr<const std::string> key = nullptr; // 송신 대기열에서 같은 key끼리 합칠 수 있음 (COALESCE 정책, 발행 topic)
+    CancelToken cancel = {}; // 요청 기한/연결 종료 (처리 스레드가 디스패치 직전에 기한을 채운다)
 };
 
 } // namespace msgnet
\ No newline at end of file
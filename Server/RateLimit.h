@@ -0,0 +1,128 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace msgnet
+{
+
+// 버킷이 비었을 때의 처리
+enum class RateLimitAction
+{
+    REJECT,     // 큐에 넣지 않고 {"ok":false,"reason":"rate_limited"}로 답한다
+    DELAY,      // 요청은 받되 빚진 만큼 그 연결에서 읽기를 멈춘다 (TCP 윈도가 차서 송신자가 느려진다)
+    DISCONNECT, // 연결을 끊는다
+};
+
+inline bool parseRateLimitAction(const std::string &name, RateLimitAction &out)
+{
+    if (name == "reject")
+        out = RateLimitAction::REJECT;
+    else if (name == "delay")
+        out = RateLimitAction::DELAY;
+    else if (name == "disconnect")
+        out = RateLimitAction::DISCONNECT;
+    else
+        return false;
+    return true;
+}
+
+inline const char *rateLimitActionName(RateLimitAction action)
+{
+    switch (action)
+    {
+    case RateLimitAction::DELAY:
+        return "delay";
+    case RateLimitAction::DISCONNECT:
+        return "disconnect";
+    default:
+        return "reject";
+    }
+}
+
+// 초당 rate개, 한 번에 최대 burst개 (burst가 0이면 rate와 같게: 1초치)
+struct RateLimit
+{
+    double rate = 0; // 0이면 제한 없음
+    double burst = 0;
+
+    bool enabled() const
+    {
+        return rate > 0;
+    }
+};
+
+// 연결별 요청 수 제한 (start() 전에 설정). 배치 프레임은 요소 수만큼 쓴다
+struct RateLimits
+{
+    RateLimit per_connection;
+    std::map<std::string, RateLimit> per_type; // 메시지 type별 (연결마다 따로 센다)
+    RateLimitAction action = RateLimitAction::REJECT;
+
+    bool enabled() const
+    {
+        if (per_connection.enabled())
+            return true;
+        return std::any_of(per_type.begin(), per_type.end(), [](const auto &kv)
+                           { return kv.second.enabled(); });
+    }
+};
+
+// GCRA(가상 스케줄링) 방식 토큰 버킷의 설정 부분. 상태는 "이론상 다음 도착 시각"(tat) 하나뿐이라
+// 연결마다 atomic<int64_t> 하나로 락 없이 갱신한다 (토큰 수와 마지막 충전 시각을 따로 둘 필요가 없다)
+class TokenBucket
+{
+public:
+    TokenBucket() = default;
+
+    explicit TokenBucket(const RateLimit &limit)
+    {
+        if (!limit.enabled())
+            return;
+        interval_ns_ = std::max<int64_t>(1, static_cast<int64_t>(1e9 / limit.rate));
+        const double burst = limit.burst > 0 ? limit.burst : limit.rate;
+        capacity_ns_ = static_cast<int64_t>(std::max(1.0, burst) * static_cast<double>(interval_ns_));
+    }
+
+    bool enabled() const
+    {
+        return interval_ns_ > 0;
+    }
+
+    // cost개를 쓴다. 지금 쓸 수 있으면 0, 아니면 쓸 수 있게 될 때까지 남은 ns
+    // force면 모자라도 쓰고(빚) 그 빚을 갚을 때까지의 시간을 돌려준다 (DELAY)
+    int64_t take(std::atomic<int64_t> &tat, int64_t now_ns, uint32_t cost, bool force) const
+    {
+        int64_t cur = tat.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            const int64_t next = std::max(cur, now_ns) + static_cast<int64_t>(cost) * interval_ns_;
+            const int64_t wait = next - now_ns - capacity_ns_;
+            if (wait > 0 && !force)
+                return wait;
+            if (tat.compare_exchange_weak(cur, next, std::memory_order_relaxed))
+                return std::max<int64_t>(0, wait);
+        }
+    }
+
+private:
+    int64_t interval_ns_ = 0; // 토큰 하나가 차는 시간
+    int64_t capacity_ns_ = 0; // burst개가 차는 시간
+};
+
+// 연결 하나의 버킷 상태 (ClientConn에 두고 recv/shm 스레드가 락 없이 갱신)
+struct RateState
+{
+    explicit RateState(size_t type_slots) : type_tat(new std::atomic<int64_t>[type_slots]())
+    {
+    }
+
+    std::atomic<int64_t> conn_tat{0};
+    std::unique_ptr<std::atomic<int64_t>[]> type_tat; // 메시지 type 슬롯별
+    std::atomic<int64_t> resume_ns{0};                // DELAY: 이 시각까지 이 연결에서 읽지 않는다
+};
+
+} // namespace msgnet
@@ -0,0 +1,216 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Dispatcher.h"
+
+namespace msgnet
+{
+
+// 서버 카운터 (스레드별 샤드로 나눠서 경합 없이 증가, 읽을 때 합산)
+// - 스레드는 처음 기록할 때 샤드 하나를 배정받고 계속 그 샤드만 쓴다
+// - 읽기(collect)는 락 없이 relaxed load로 합산하므로 스크레이프가 데이터 경로를 막지 않는다
+class ServerMetrics
+{
+public:
+    static constexpr size_t kShards = 16;
+
+    struct Totals
+    {
+        uint64_t connections_accepted = 0;
+        uint64_t connections_closed = 0;
+        uint64_t bytes_in = 0;
+        uint64_t bytes_out = 0;
+        uint64_t frames_in = 0;
+        uint64_t frames_out = 0;
+        uint64_t batch_frames = 0;   // JSON 배열로 받은 프레임
+        uint64_t batch_messages = 0; // 그 안에 들어 있던 요청 수
+        uint64_t published = 0;      // broadcast/publish 호출 (직렬화 횟수)
+        uint64_t fanout = 0;         // 그로 인해 송신 큐에 넣은 구독자별 전송
+        uint64_t outbound_dropped = 0;   // 느린 수신자: 대기열에서 버린 프레임 (DROP_OLDEST)
+        uint64_t outbound_coalesced = 0; // 느린 수신자: 같은 key의 최신 값으로 바꾼 프레임 (COALESCE)
+        uint64_t slow_disconnects = 0;   // 느린 수신자라서 끊은 연결
+        uint64_t slow_pauses = 0;        // 느린 수신자라서 수신/생산자를 멈춘 횟수 (PAUSE)
+        uint64_t idle_timeouts = 0;      // 유휴 시간 초과로 끊은 연결
+        uint64_t write_stalls = 0;       // 송신 정체로 끊은 연결
+        uint64_t heartbeats = 0;         // 보낸 하트비트
+        uint64_t abandoned = 0;          // 처리 전에 연결이 끊겨 버린 요청
+        uint64_t rate_delays = 0;        // 요청 수 제한으로 읽기를 멈춘 횟수 (DELAY)
+        uint64_t rate_disconnects = 0;   // 요청 수 제한으로 끊은 연결 (DISCONNECT)
+        std::vector<uint64_t> messages; // 타입 슬롯별 (TcpServer::handler_types_ 순서 + "_unknown")
+        std::array<uint64_t, static_cast<size_t>(ErrorReason::COUNT)> errors{};
+    };
+
+    // 스레드 시작 전에 호출 (타입 슬롯 수 확정)
+    void reset(size_t type_slots)
+    {
+        type_slots_ = type_slots;
+        for (auto &shard : shards_)
+        {
+            shard.connections_accepted = 0;
+            shard.connections_closed = 0;
+            shard.bytes_in = 0;
+            shard.bytes_out = 0;
+            shard.frames_in = 0;
+            shard.frames_out = 0;
+            shard.batch_frames = 0;
+            shard.batch_messages = 0;
+            shard.published = 0;
+            shard.fanout = 0;
+            shard.outbound_dropped = 0;
+            shard.outbound_coalesced = 0;
+            shard.slow_disconnects = 0;
+            shard.slow_pauses = 0;
+            shard.idle_timeouts = 0;
+            shard.write_stalls = 0;
+            shard.heartbeats = 0;
+            shard.abandoned = 0;
+            shard.rate_delays = 0;
+            shard.rate_disconnects = 0;
+            for (auto &e : shard.errors)
+                e = 0;
+            shard.messages.reset(new std::atomic<uint64_t>[type_slots]);
+            for (size_t i = 0; i < type_slots; ++i)
+                shard.messages[i] = 0;
+        }
+    }
+
+    void connectionAccepted() { add(local().connections_accepted, 1); }
+    void connectionClosed() { add(local().connections_closed, 1); }
+
+    void frameIn(size_t bytes)
+    {
+        Shard &s = local();
+        add(s.frames_in, 1);
+        add(s.bytes_in, bytes);
+    }
+
+    void frameOut(size_t bytes)
+    {
+        Shard &s = local();
+        add(s.frames_out, 1);
+        add(s.bytes_out, bytes);
+    }
+
+    void batch(size_t messages)
+    {
+        Shard &s = local();
+        add(s.batch_frames, 1);
+        add(s.batch_messages, messages);
+    }
+
+    void publish(size_t subscribers)
+    {
+        Shard &s = local();
+        add(s.published, 1);
+        add(s.fanout, subscribers);
+    }
+
+    void outboundDropped() { add(local().outbound_dropped, 1); }
+    void outboundCoalesced() { add(local().outbound_coalesced, 1); }
+    void slowConsumerDisconnect() { add(local().slow_disconnects, 1); }
+    void slowConsumerPause() { add(local().slow_pauses, 1); }
+    void idleTimeout() { add(local().idle_timeouts, 1); }
+    void writeStall() { add(local().write_stalls, 1); }
+    void heartbeat() { add(local().heartbeats, 1); }
+    void abandoned(size_t requests) { add(local().abandoned, requests); }
+    void rateLimitDelay() { add(local().rate_delays, 1); }
+    void rateLimitDisconnect() { add(local().rate_disconnects, 1); }
+
+    void message(size_t type_slot)
+    {
+        if (type_slot < type_slots_)
+            add(local().messages[type_slot], 1);
+    }
+
+    void error(ErrorReason reason)
+    {
+        if (reason != ErrorReason::NONE && reason < ErrorReason::COUNT)
+            add(local().errors[static_cast<size_t>(reason)], 1);
+    }
+
+    Totals collect() const
+    {
+        Totals t;
+        t.messages.assign(type_slots_, 0);
+        for (auto &s : shards_)
+        {
+            t.connections_accepted += s.connections_accepted.load(std::memory_order_relaxed);
+            t.connections_closed += s.connections_closed.load(std::memory_order_relaxed);
+            t.bytes_in += s.bytes_in.load(std::memory_order_relaxed);
+            t.bytes_out += s.bytes_out.load(std::memory_order_relaxed);
+            t.frames_in += s.frames_in.load(std::memory_order_relaxed);
+            t.frames_out += s.frames_out.load(std::memory_order_relaxed);
+            t.batch_frames += s.batch_frames.load(std::memory_order_relaxed);
+            t.batch_messages += s.batch_messages.load(std::memory_order_relaxed);
+            t.published += s.published.load(std::memory_order_relaxed);
+            t.fanout += s.fanout.load(std::memory_order_relaxed);
+            t.outbound_dropped += s.outbound_dropped.load(std::memory_order_relaxed);
+            t.outbound_coalesced += s.outbound_coalesced.load(std::memory_order_relaxed);
+            t.slow_disconnects += s.slow_disconnects.load(std::memory_order_relaxed);
+            t.slow_pauses += s.slow_pauses.load(std::memory_order_relaxed);
+            t.idle_timeouts += s.idle_timeouts.load(std::memory_order_relaxed);
+            t.write_stalls += s.write_stalls.load(std::memory_order_relaxed);
+            t.heartbeats += s.heartbeats.load(std::memory_order_relaxed);
+            t.abandoned += s.abandoned.load(std::memory_order_relaxed);
+            t.rate_delays += s.rate_delays.load(std::memory_order_relaxed);
+            t.rate_disconnects += s.rate_disconnects.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < t.errors.size(); ++i)
+                t.errors[i] += s.errors[i].load(std::memory_order_relaxed);
+            if (s.messages)
+            {
+                for (size_t i = 0; i < type_slots_; ++i)
+                    t.messages[i] += s.messages[i].load(std::memory_order_relaxed);
+            }
+        }
+        return t;
+    }
+
+private:
+    struct alignas(64) Shard
+    {
+        std::atomic<uint64_t> connections_accepted{0};
+        std::atomic<uint64_t> connections_closed{0};
+        std::atomic<uint64_t> bytes_in{0};
+        std::atomic<uint64_t> bytes_out{0};
+        std::atomic<uint64_t> frames_in{0};
+        std::atomic<uint64_t> frames_out{0};
+        std::atomic<uint64_t> batch_frames{0};
+        std::atomic<uint64_t> batch_messages{0};
+        std::atomic<uint64_t> published{0};
+        std::atomic<uint64_t> fanout{0};
+        std::atomic<uint64_t> outbound_dropped{0};
+        std::atomic<uint64_t> outbound_coalesced{0};
+        std::atomic<uint64_t> slow_disconnects{0};
+        std::atomic<uint64_t> slow_pauses{0};
+        std::atomic<uint64_t> idle_timeouts{0};
+        std::atomic<uint64_t> write_stalls{0};
+        std::atomic<uint64_t> heartbeats{0};
+        std::atomic<uint64_t> abandoned{0};
+        std::atomic<uint64_t> rate_delays{0};
+        std::atomic<uint64_t> rate_disconnects{0};
+        std::array<std::atomic<uint64_t>, static_cast<size_t>(ErrorReason::COUNT)> errors{};
+        std::unique_ptr<std::atomic<uint64_t>[]> messages;
+    };
+
+    static void add(std::atomic<uint64_t> &a, uint64_t v)
+    {
+        a.fetch_add(v, std::memory_order_relaxed);
+    }
+
+    Shard &local()
+    {
+        static std::atomic<size_t> next_shard{0};
+        thread_local size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % kShards;
+        return shards_[shard];
+    }
+
+    std::array<Shard, kShards> shards_;
+    size_t type_slots_ = 0;
+};
+
+} // namespace msgnet
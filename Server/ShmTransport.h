@@ -0,0 +1,493 @@
+#pragma once
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "json.hpp"
+#include "Frame.h"
+
+namespace msgnet
+{
+
+// 같은 호스트 클라이언트용 공유 메모리 전송
+// - AF_UNIX 연결에서 {"type":"_shm_attach"} 프레임을 보내면 서버가 memfd(링 2개)와 eventfd 2개를
+//   SCM_RIGHTS로 넘겨준다. 이후 프레임은 링으로만 오가고, 유닉스 소켓은 상대 종료 감지에만 쓴다
+// - 링에 들어가는 바이트는 소켓과 같은 길이 프리픽스 프레임 그대로
+// - 링은 단일 생산자/단일 소비자. 소비자는 잠들기 직전에만 플래그를 세우고,
+//   생산자는 그 플래그를 봤을 때만 eventfd를 쓴다 (바쁜 동안에는 시스템 콜 없음)
+// - 링이 차면 생산자도 같은 방식으로 플래그를 세우고, 소비자가 자리를 비운 뒤 그 플래그를 보면 상대 eventfd를 쓴다
+// - 링보다 큰 프레임은 보낼 수 없다 (그 연결은 끊긴다). 최대 프레임(4MB)을 쓰려면 링을 8MB로
+
+constexpr size_t kShmRingBytes = 1024 * 1024;   // 방향별 기본 링 크기 (연결마다 2배가 상주)
+constexpr size_t kMinShmRingBytes = 64 * 1024;  // 링 크기는 2의 거듭제곱, 이 이상
+constexpr const char *kShmAttachType = "_shm_attach";
+constexpr const char *kShmAttachRespType = "_shm_attach_resp";
+
+// 링 맨 앞의 제어 영역 (생산자/소비자 필드가 같은 캐시 라인을 쓰지 않게 나눈다)
+struct ShmRingHeader
+{
+    alignas(64) std::atomic<uint64_t> head{0}; // 생산자가 쓴 누적 바이트
+    alignas(64) std::atomic<uint64_t> tail{0}; // 소비자가 읽은 누적 바이트
+    alignas(64) std::atomic<uint32_t> consumer_sleeping{0};
+    alignas(64) std::atomic<uint32_t> producer_waiting{0}; // 생산자가 자리를 기다림 (소비자가 비운 뒤 깨운다)
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory ring needs lock-free 64-bit atomics");
+
+// 바쁜 대기 루프용 (하이퍼스레드 상대에게 파이프라인을 양보)
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// 공유 메모리 위의 SPSC 바이트 링 (영역은 ShmChannel이 소유)
+class ShmRing
+{
+public:
+    ShmRing() = default;
+    ShmRing(void *region, size_t capacity)
+        : header_(static_cast<ShmRingHeader *>(region)),
+          data_(static_cast<char *>(region) + sizeof(ShmRingHeader)),
+          capacity_(capacity)
+    {
+    }
+
+    static constexpr size_t regionBytes(size_t capacity)
+    {
+        return sizeof(ShmRingHeader) + capacity;
+    }
+
+    bool fits(size_t bytes) const
+    {
+        return bytes <= capacity_;
+    }
+
+    // 생산자: 완성된 프레임(헤더 포함)을 통째로 넣는다. 자리가 없으면 아무것도 쓰지 않고 false
+    // 인덱스는 상대도 쓸 수 있는 메모리에 있으므로 말이 안 되면 쓰지 않고 corrupt()를 세운다 (그 연결은 끊는다)
+    bool tryWrite(std::string_view frame)
+    {
+        const uint64_t head = header_->head.load(std::memory_order_relaxed);
+        const uint64_t tail = header_->tail.load(std::memory_order_acquire);
+        if (corrupt_ || !sane(head, tail))
+        {
+            corrupt_ = true;
+            return false;
+        }
+        if (frame.size() > capacity_ || capacity_ - (head - tail) < frame.size())
+            return false;
+        copyIn(head, frame.data(), frame.size());
+        // seq_cst: 뒤이은 consumerSleeping() 읽기보다 먼저 보이게 한다 (prepareSleep()과 짝)
+        header_->head.store(head + frame.size(), std::memory_order_seq_cst);
+        return true;
+    }
+
+    bool consumerSleeping() const
+    {
+        return header_->consumer_sleeping.load(std::memory_order_seq_cst) != 0;
+    }
+
+    // 소비자: 맨 앞 프레임. 링 끝에서 잘려 있으면 scratch에 이어 붙여 돌려준다
+    // COMPLETE면 처리 후 consume(kFrameHeaderSize + payload.size())
+    FrameStatus peekFrame(std::string_view &payload, std::string &scratch) const
+    {
+        // head/tail은 상대가 쓸 수 있으므로 링 크기를 넘는 값은 복사 전에 거른다
+        const uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+        const uint64_t head = header_->head.load(std::memory_order_acquire);
+        if (!sane(head, tail))
+            return FrameStatus::INVALID_LENGTH;
+        const uint64_t avail = head - tail;
+        if (avail < kFrameHeaderSize)
+            return FrameStatus::INCOMPLETE;
+
+        uint32_t len_net;
+        copyOut(tail, &len_net, sizeof(len_net));
+        const uint32_t len = ntohl(len_net);
+        if (!isValidFrameLength(len) || len > capacity_ - kFrameHeaderSize)
+            return FrameStatus::INVALID_LENGTH;
+        if (avail - kFrameHeaderSize < len)
+            return FrameStatus::INCOMPLETE;
+
+        const size_t off = static_cast<size_t>((tail + kFrameHeaderSize) & (capacity_ - 1));
+        if (off + len <= capacity_)
+        {
+            payload = std::string_view(data_ + off, len);
+        }
+        else
+        {
+            scratch.resize(len);
+            copyOut(tail + kFrameHeaderSize, scratch.data(), len);
+            payload = scratch;
+        }
+        return FrameStatus::COMPLETE;
+    }
+
+    void consume(size_t bytes)
+    {
+        const uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+        header_->tail.store(tail + bytes, std::memory_order_release);
+    }
+
+    bool empty() const
+    {
+        return header_->head.load(std::memory_order_acquire) == header_->tail.load(std::memory_order_relaxed);
+    }
+
+    // 소비자가 잠들기 직전: 플래그를 세운 뒤 다시 확인한다. 그 사이 데이터가 들어왔으면 플래그를 내리고 false
+    bool prepareSleep()
+    {
+        header_->consumer_sleeping.store(1, std::memory_order_seq_cst);
+        if (header_->head.load(std::memory_order_seq_cst) != header_->tail.load(std::memory_order_relaxed))
+        {
+            header_->consumer_sleeping.store(0, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    void endSleep()
+    {
+        header_->consumer_sleeping.store(0, std::memory_order_relaxed);
+    }
+
+    // 생산자: bytes만큼 자리가 없어서 기다리려 할 때. 플래그를 세운 뒤 다시 확인해서
+    // 그 사이 자리가 났으면 플래그를 내리고 false (바로 다시 쓰면 된다)
+    bool prepareWait(size_t bytes)
+    {
+        header_->producer_waiting.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const uint64_t head = header_->head.load(std::memory_order_relaxed);
+        const uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+        if (!sane(head, tail))
+        {
+            corrupt_ = true;
+            header_->producer_waiting.store(0, std::memory_order_relaxed);
+            return false;
+        }
+        if (capacity_ - (head - tail) >= bytes)
+        {
+            header_->producer_waiting.store(0, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    // 생산자: prepareWait() 뒤로 소비자가 아직 자리를 알리지 않았다
+    bool producerWaiting() const
+    {
+        return header_->producer_waiting.load(std::memory_order_relaxed) != 0;
+    }
+
+    // 소비자: consume()을 몇 번 한 뒤 호출. 생산자가 자리를 기다리고 있으면 깨운다 (prepareWait()과 짝)
+    bool releaseProducer()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (header_->producer_waiting.load(std::memory_order_relaxed) == 0)
+            return false;
+        header_->producer_waiting.store(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    // tryWrite()/prepareWait()이 망가진 인덱스를 본 적이 있다 (이후로는 계속 false)
+    bool corrupt() const
+    {
+        return corrupt_;
+    }
+
+private:
+    bool sane(uint64_t head, uint64_t tail) const
+    {
+        return tail <= head && head - tail <= capacity_;
+    }
+
+    void copyIn(uint64_t pos, const char *src, size_t n)
+    {
+        const size_t off = static_cast<size_t>(pos & (capacity_ - 1));
+        const size_t first = std::min(n, capacity_ - off);
+        std::memcpy(data_ + off, src, first);
+        std::memcpy(data_, src + first, n - first);
+    }
+
+    void copyOut(uint64_t pos, void *dst, size_t n) const
+    {
+        const size_t off = static_cast<size_t>(pos & (capacity_ - 1));
+        const size_t first = std::min(n, capacity_ - off);
+        std::memcpy(dst, data_ + off, first);
+        std::memcpy(static_cast<char *>(dst) + first, data_, n - first);
+    }
+
+    ShmRingHeader *header_ = nullptr;
+    char *data_ = nullptr;
+    size_t capacity_ = 0;
+    bool corrupt_ = false;
+};
+
+// 연결 하나의 링 한 쌍과 깨우기용 eventfd
+// - c2s: 클라이언트 -> 서버, s2c: 서버 -> 클라이언트
+// - to_server: 서버(c2s 소비자)를 깨우는 eventfd, to_client: 클라이언트(s2c 소비자)를 깨우는 eventfd
+class ShmChannel
+{
+public:
+    ShmChannel() = default;
+    ~ShmChannel()
+    {
+        reset();
+    }
+
+    ShmChannel(const ShmChannel &) = delete;
+    ShmChannel &operator=(const ShmChannel &) = delete;
+
+    // 서버: memfd를 만들고 두 링을 초기화한다
+    bool create(size_t ring_bytes = kShmRingBytes)
+    {
+        reset();
+        mem_fd_ = ::memfd_create("msgnet-shm", MFD_CLOEXEC);
+        to_server_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        to_client_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (mem_fd_ < 0 || to_server_fd_ < 0 || to_client_fd_ < 0 ||
+            ::ftruncate(mem_fd_, static_cast<off_t>(2 * ShmRing::regionBytes(ring_bytes))) < 0 || !map(ring_bytes))
+        {
+            reset();
+            return false;
+        }
+        new (base_) ShmRingHeader();
+        new (static_cast<char *>(base_) + ShmRing::regionBytes(ring_bytes)) ShmRingHeader();
+        return true;
+    }
+
+    // 클라이언트: 서버가 넘겨준 fd로 같은 영역을 매핑한다 (실패해도 fd 소유권은 가져감)
+    bool attach(int mem_fd, int to_server_fd, int to_client_fd, size_t ring_bytes)
+    {
+        reset();
+        mem_fd_ = mem_fd;
+        to_server_fd_ = to_server_fd;
+        to_client_fd_ = to_client_fd;
+        if (mem_fd_ < 0 || to_server_fd_ < 0 || to_client_fd_ < 0 || !map(ring_bytes))
+        {
+            reset();
+            return false;
+        }
+        return true;
+    }
+
+    void reset()
+    {
+        if (base_)
+            ::munmap(base_, map_bytes_);
+        base_ = nullptr;
+        map_bytes_ = 0;
+        for (int *fd : {&mem_fd_, &to_server_fd_, &to_client_fd_})
+        {
+            if (*fd >= 0)
+                ::close(*fd);
+            *fd = -1;
+        }
+    }
+
+    ShmRing &c2s() { return c2s_; }
+    ShmRing &s2c() { return s2c_; }
+    int toServerFd() const { return to_server_fd_; }
+    int toClientFd() const { return to_client_fd_; }
+    size_t ringBytes() const { return ring_bytes_; }
+
+    // 생산자 쪽 쓰기: 자리가 날 때까지 최대 timeout_ms 기다리고, 소비자가 잠들어 있으면 깨운다
+    // 링보다 큰 프레임이거나 시간이 지나면 false (소켓의 send 실패와 같은 취급)
+    // 기다리는 동안 호출 스레드를 재우므로 다른 연결을 함께 처리하는 스레드에서는 쓰지 않는다 (서버는 tryWrite + 대기열)
+    static bool writeFrame(ShmRing &ring, int wake_fd, std::string_view frame, int timeout_ms)
+    {
+        if (!ring.fits(frame.size()))
+            return false;
+        if (!ring.tryWrite(frame))
+        {
+            // 링이 찬 것은 상대가 밀린 드문 경우라 짧게 쉬어 가며 다시 본다
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+            while (!ring.tryWrite(frame))
+            {
+                if (ring.corrupt() || std::chrono::steady_clock::now() >= deadline)
+                    return false;
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+        if (ring.consumerSleeping())
+            notify(wake_fd);
+        return true;
+    }
+
+    static void notify(int efd)
+    {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(efd, &one, sizeof(one));
+        (void)ignored;
+    }
+
+    static void drain(int efd)
+    {
+        uint64_t v;
+        ssize_t ignored = ::read(efd, &v, sizeof(v));
+        (void)ignored;
+    }
+
+    // 서버: 핸드셰이크 응답 프레임과 fd 3개를 한 번의 sendmsg로 보낸다
+    bool sendAttachReply(int sock) const
+    {
+        nlohmann::json resp = {{"type", kShmAttachRespType}, {"ok", true}, {"ring_bytes", ring_bytes_}};
+        const std::string frame = encodeFrame(resp);
+        const int fds[3] = {mem_fd_, to_server_fd_, to_client_fd_};
+        return sendWithFds(sock, frame, fds, 3);
+    }
+
+    // 클라이언트: 블로킹 유닉스 소켓에서 attach 요청을 보내고 응답과 fd를 받아 매핑한다
+    static bool clientAttach(int sock, ShmChannel &out)
+    {
+        std::string req;
+        appendFrame(req, nlohmann::json{{"type", kShmAttachType}}.dump());
+        for (size_t sent = 0; sent < req.size();)
+        {
+            ssize_t s = ::send(sock, req.data() + sent, req.size() - sent, MSG_NOSIGNAL);
+            if (s < 0 && errno == EINTR)
+                continue;
+            if (s <= 0)
+                return false;
+            sent += static_cast<size_t>(s);
+        }
+
+        // 응답 프레임을 다 받을 때까지 읽는다 (fd는 첫 바이트와 함께 도착)
+        std::string in;
+        int fds[3] = {-1, -1, -1};
+        int nfds = 0;
+        std::string_view payload;
+        FrameStatus st;
+        while ((st = decodeFrame(in.data(), in.size(), payload)) == FrameStatus::INCOMPLETE)
+        {
+            char buf[4096];
+            if (!recvWithFds(sock, buf, sizeof(buf), in, fds, nfds))
+            {
+                closeFds(fds, nfds);
+                return false;
+            }
+        }
+
+        nlohmann::json resp = st == FrameStatus::COMPLETE
+                                  ? nlohmann::json::parse(payload, nullptr, false)
+                                  : nlohmann::json();
+        const bool ok = resp.is_object() && resp.value("type", "") == kShmAttachRespType &&
+                        resp.value("ok", false) && resp.contains("ring_bytes");
+        if (!ok || nfds != 3)
+        {
+            closeFds(fds, nfds);
+            return false;
+        }
+        return out.attach(fds[0], fds[1], fds[2], resp["ring_bytes"].get<size_t>());
+    }
+
+private:
+    bool map(size_t ring_bytes)
+    {
+        if ((ring_bytes & (ring_bytes - 1)) != 0 || ring_bytes < kMinShmRingBytes)
+            return false;
+        const size_t region = ShmRing::regionBytes(ring_bytes);
+        // MAP_POPULATE: 링을 처음 한 바퀴 도는 동안 페이지 폴트가 지연 꼬리로 나오지 않게 미리 채운다
+        // (대신 연결마다 2 * ring_bytes가 바로 상주한다)
+        void *p = ::mmap(nullptr, 2 * region, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mem_fd_, 0);
+        if (p == MAP_FAILED)
+            return false;
+        base_ = p;
+        map_bytes_ = 2 * region;
+        ring_bytes_ = ring_bytes;
+        c2s_ = ShmRing(base_, ring_bytes);
+        s2c_ = ShmRing(static_cast<char *>(base_) + region, ring_bytes);
+        return true;
+    }
+
+    static bool sendWithFds(int sock, const std::string &data, const int *fds, int nfds)
+    {
+        iovec iov{const_cast<char *>(data.data()), data.size()};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * 3)]{};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * nfds);
+        cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * nfds);
+        std::memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * nfds);
+
+        ssize_t s;
+        do
+        {
+            s = ::sendmsg(sock, &msg, MSG_NOSIGNAL);
+        } while (s < 0 && errno == EINTR);
+        return s == static_cast<ssize_t>(data.size());
+    }
+
+    static bool recvWithFds(int sock, char *buf, size_t cap, std::string &in, int *fds, int &nfds)
+    {
+        iovec iov{buf, cap};
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * 3)]{};
+        msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        ssize_t r;
+        do
+        {
+            r = ::recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+        } while (r < 0 && errno == EINTR);
+        if (r <= 0)
+            return false;
+
+        for (cmsghdr *c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c))
+        {
+            if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS)
+                continue;
+            const int n = static_cast<int>((c->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+            for (int i = 0; i < n; ++i)
+            {
+                int fd;
+                std::memcpy(&fd, CMSG_DATA(c) + i * sizeof(int), sizeof(int));
+                if (nfds < 3)
+                    fds[nfds++] = fd;
+                else
+                    ::close(fd);
+            }
+        }
+        in.append(buf, static_cast<size_t>(r));
+        return true;
+    }
+
+    static void closeFds(int *fds, int nfds)
+    {
+        for (int i = 0; i < nfds; ++i)
+            ::close(fds[i]);
+    }
+
+    int mem_fd_ = -1;
+    int to_server_fd_ = -1;
+    int to_client_fd_ = -1;
+    void *base_ = nullptr;
+    size_t map_bytes_ = 0;
+    size_t ring_bytes_ = 0;
+    ShmRing c2s_;
+    ShmRing s2c_;
+};
+
+} // namespace msgnet
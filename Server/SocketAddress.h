@@ -0,0 +1,82 @@
+#pragma once
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace msgnet
+{
+
+// 서버 리스너와 클라이언트 연결이 공유하는 소켓 주소 (AF_INET 또는 AF_UNIX)
+// - unix 경로가 '@'로 시작하면 abstract namespace (파일이 생기지 않고, 마지막 참조가 닫히면 사라짐)
+struct SocketAddress
+{
+    sockaddr_storage storage{};
+    socklen_t length = 0;
+
+    int family() const { return storage.ss_family; }
+    const sockaddr *get() const { return reinterpret_cast<const sockaddr *>(&storage); }
+    sockaddr *get() { return reinterpret_cast<sockaddr *>(&storage); }
+
+    // host가 비어 있거나 "0.0.0.0"이면 INADDR_ANY. IPv4 문자열이 아니면 이름 해석
+    static bool fromTcp(const std::string &host, int port, SocketAddress &out)
+    {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        if (host.empty() || host == "0.0.0.0")
+        {
+            addr.sin_addr.s_addr = INADDR_ANY;
+        }
+        else if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1)
+        {
+            addrinfo hints{};
+            hints.ai_family = AF_INET;
+            hints.ai_socktype = SOCK_STREAM;
+            addrinfo *res = nullptr;
+            if (getaddrinfo(host.c_str(), nullptr, &hints, &res) != 0 || !res)
+                return false;
+            addr.sin_addr = reinterpret_cast<sockaddr_in *>(res->ai_addr)->sin_addr;
+            freeaddrinfo(res);
+        }
+        out = SocketAddress{};
+        std::memcpy(&out.storage, &addr, sizeof(addr));
+        out.length = sizeof(addr);
+        return true;
+    }
+
+    static bool fromUnixPath(const std::string &path, SocketAddress &out)
+    {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (path.empty() || path.size() >= sizeof(addr.sun_path))
+            return false;
+
+        out = SocketAddress{};
+        if (isAbstract(path))
+        {
+            // sun_path[0] = '\0' 다음에 이름 (널 종료 없음, 길이로 구분)
+            std::memcpy(addr.sun_path + 1, path.data() + 1, path.size() - 1);
+            out.length = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size());
+        }
+        else
+        {
+            std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+            out.length = static_cast<socklen_t>(sizeof(addr));
+        }
+        std::memcpy(&out.storage, &addr, sizeof(addr));
+        return true;
+    }
+
+    static bool isAbstract(const std::string &path)
+    {
+        return !path.empty() && path[0] == '@';
+    }
+};
+
+} // namespace msgnet
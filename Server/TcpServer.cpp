@@ -1,14 +1,84 @@
+#include <algorithm>
 #include <iostream>
 #include <arpa/inet.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
 
 #include "TcpServer.h"
 #include "Logger.h"
+#include "Frame.h"
 
 using namespace std;
 
 namespace msgnet
 {
 
+namespace
+{
+
+// 응답의 "ok" 값 (없거나 bool이 아니면 false)
+bool responseOk(const nlohmann::json &res)
+{
+    if (!res.is_object())
+        return false;
+    auto it = res.find("ok");
+    return it != res.end() && it->is_boolean() && it->get<bool>();
+}
+
+// 요청의 deadline_ms(또는 timeout_ms): 서버가 프레임을 받은 시각부터 잰 상대 기한 (시계가 다른 호스트끼리도 맞다)
+// 없거나 0 이하이면 0 (기한 없음). 하루를 넘는 값은 기한 없음과 같게 본다
+int64_t requestDeadlineNs(const nlohmann::json &req, int64_t recv_ns)
+{
+    if (!req.is_object())
+        return 0;
+    auto it = req.find("deadline_ms");
+    if (it == req.end())
+        it = req.find("timeout_ms");
+    if (it == req.end() || !it->is_number())
+        return 0;
+    const double ms = it->get<double>();
+    if (!(ms > 0) || ms > 86400000.0)
+        return 0;
+    return recv_ns + static_cast<int64_t>(ms * 1000000.0);
+}
+
+// "priority":"high"인 요청은 과부하 때도 거절하지 않는다 (배치는 모든 요소가 high일 때만)
+bool highPriority(const nlohmann::json &req)
+{
+    if (req.is_array())
+    {
+        for (const nlohmann::json &item : req)
+        {
+            if (!highPriority(item))
+                return false;
+        }
+        return !req.empty();
+    }
+    if (!req.is_object())
+        return false;
+    auto it = req.find("priority");
+    return it != req.end() && it->is_string() && it->get_ref<const std::string &>() == "high";
+}
+
+// 처리 스레드(메시지 핸들러를 부르는 스레드)면 true. 여기서는 PAUSE로 기다리지 않는다
+thread_local bool t_process_thread = false;
+
+// 스레드 루프 맨 앞에서 호출 (이후 만드는 스레드 전용 버퍼가 그 코어의 NUMA 노드에 잡히게)
+void pinThread(const char *role, const std::vector<int> &cpus, int index)
+{
+    if (cpus.empty())
+        return;
+    const int cpu = pinCurrentThread(cpus, index);
+    if (cpu < 0)
+        LOG_WARN("[TcpServer] Failed to pin ", role, " thread ", index, ", running unpinned");
+    else
+        LOG_INFO("[TcpServer] Pinned ", role, " thread ", index, " to cpu ", cpu);
+}
+
+} // namespace
+
 bool TcpServer::recvAll(int fd, void *buf, size_t len)
 {
     char *p = static_cast<char *>(buf);
@@ -35,7 +105,7 @@ bool TcpServer::sendAll(int fd, const void *buf, size_t len)
     size_t sent = 0;
     while (sent < len)
     {
-        ssize_t s = ::send(fd, p + sent, len - sent, 0);
+        ssize_t s = ::send(fd, p + sent, len - sent, MSG_NOSIGNAL);
         if (s <= 0)
         {
             if (s < 0 && errno == EINTR)
@@ -47,10 +117,25 @@ bool TcpServer::sendAll(int fd, const void *buf, size_t len)
     return true;
 }
 
-// TcpServer::TcpServer(int port) : port_(port) {}
+bool TcpServer::sendSome(int fd, const char *data, size_t len, size_t &sent)
+{
+    while (sent < len)
+    {
+        ssize_t s = ::send(fd, data + sent, len - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (s < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        sent += static_cast<size_t>(s);
+    }
+    return true;
+}
 
-TcpServer::TcpServer(int port) : port_(port)
+TcpServer::TcpServer(int port)
 {
+    addListenAddress("0.0.0.0", port);
 }
 
 TcpServer::~TcpServer()
@@ -58,89 +143,355 @@ TcpServer::~TcpServer()
     stop();
 }
 
-void TcpServer::start()
+bool TcpServer::openListeners()
+{
+    for (const ListenAddress &la : listen_addresses_)
+    {
+        const std::string where = la.isUnix() ? la.unix_path : la.host + ":" + std::to_string(la.port);
+
+        SocketAddress addr;
+        const bool resolved = la.isUnix() ? SocketAddress::fromUnixPath(la.unix_path, addr)
+                                          : SocketAddress::fromTcp(la.host, la.port, addr);
+        if (!resolved)
+        {
+            LOG_ERROR("[TcpServer] Invalid listen address ", where);
+            closeListeners();
+            return false;
+        }
+
+        int fd = -1;
+        auto inherited = inherited_fds_.find(listenerKey(la));
+        if (inherited != inherited_fds_.end())
+        {
+            // 이전 프로세스의 리스너를 그대로 쓴다 (bind/listen 없이 커널 accept 큐까지 이어받는다)
+            fd = inherited->second;
+            inherited_fds_.erase(inherited);
+            LOG_INFO("[TcpServer] Inherited listener ", where);
+        }
+        else
+        {
+            // accept 스레드가 리스너 여러 개를 epoll로 기다리므로 non-blocking
+            fd = ::socket(addr.family(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd < 0)
+            {
+                perror("socket");
+                exception_probe_(-1, fd, ExceptionType::SOCKET_CREATION_FAILED);
+                closeListeners();
+                return false;
+            }
+
+            if (la.isUnix())
+            {
+                // 이전 실행이 남긴 소켓 파일 제거 (abstract는 파일이 없음)
+                if (!SocketAddress::isAbstract(la.unix_path))
+                    ::unlink(la.unix_path.c_str());
+            }
+            else
+            {
+                int opt = 1;
+                ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+            }
+
+            if (::bind(fd, addr.get(), addr.length) < 0)
+            {
+                perror("bind");
+                LOG_ERROR("[TcpServer] bind failed on ", where);
+                exception_probe_(-1, fd, ExceptionType::BIND_FAILED);
+                ::close(fd);
+                closeListeners();
+                return false;
+            }
+            if (::listen(fd, SOMAXCONN) < 0)
+            {
+                perror("listen");
+                exception_probe_(-1, fd, ExceptionType::LISTEN_FAILED);
+                ::close(fd);
+                closeListeners();
+                return false;
+            }
+        }
+
+        // port 0이면 커널이 고른 포트를 기록
+        Listener listener{fd, la};
+        if (!la.isUnix())
+        {
+            sockaddr_in bound{};
+            socklen_t addr_len = sizeof(bound);
+            if (::getsockname(fd, (sockaddr *)&bound, &addr_len) == 0)
+                listener.address.port = ntohs(bound.sin_port);
+        }
+        listeners_.push_back(std::move(listener));
+    }
+
+    // 이전 프로세스가 넘겨줬지만 이번 설정에 없는 리스너
+    for (auto &[key, fd] : inherited_fds_)
+        ::close(fd);
+    inherited_fds_.clear();
+    return !listeners_.empty();
+}
+
+void TcpServer::closeListeners()
+{
+    // 새 프로세스에 넘긴 소켓 파일은 그쪽이 계속 쓰므로 지우지 않는다
+    const bool handed_off = handed_off_.load(std::memory_order_acquire);
+    for (Listener &l : listeners_)
+    {
+        ::close(l.fd);
+        if (!handed_off && l.address.isUnix() && !SocketAddress::isAbstract(l.address.unix_path))
+            ::unlink(l.address.unix_path.c_str());
+    }
+    listeners_.clear();
+}
+
+void TcpServer::stopAccepting()
+{
+    accepting_ = false;
+    if (accept_stop_fd_ >= 0)
+        ShmChannel::notify(accept_stop_fd_);
+    for (auto &t : accept_threads_)
+    {
+        if (t.joinable())
+            t.join();
+    }
+    accept_threads_.clear();
+    if (handoff_thread_.joinable())
+        handoff_thread_.join();
+    if (accept_stop_fd_ >= 0)
+    {
+        ::close(accept_stop_fd_);
+        accept_stop_fd_ = -1;
+    }
+    if (handoff_fd_ >= 0)
+    {
+        ::close(handoff_fd_);
+        handoff_fd_ = -1;
+        if (!SocketAddress::isAbstract(handoff_path_))
+            ::unlink(handoff_path_.c_str());
+    }
+    closeListeners();
+}
+
+bool TcpServer::start()
 {
     std::cout.setf(std::ios::unitbuf);
 
-    server_fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
-    if (server_fd_ < 0)
+    // set default exception probe to no-op if not set
+    if (!exception_probe_)
+    {
+        exception_probe_ = [](const int, const int, ExceptionType) {};
+    }
+
+    if (!inherit_from_.empty() && !receiveListeners())
+        LOG_WARN("[TcpServer] No listeners inherited from ", inherit_from_, ", binding fresh sockets");
+    if (!openListeners())
+        return false;
+
+    accept_stop_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    stop_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    drain_wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (accept_stop_fd_ < 0 || stop_fd_ < 0 || drain_wake_fd_ < 0)
     {
-        perror("socket");
-        return;
+        perror("eventfd");
+        for (int *fd : {&accept_stop_fd_, &stop_fd_, &drain_wake_fd_})
+        {
+            if (*fd >= 0)
+                ::close(*fd);
+            *fd = -1;
+        }
+        closeListeners();
+        return false;
     }
 
-    int opt = 1;
-    ::setsockopt(server_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    registerPubSubHandlers();
 
-    sockaddr_in addr{};
-    addr.sin_family = AF_INET;
-    addr.sin_addr.s_addr = INADDR_ANY;
-    addr.sin_port = htons(port_);
+    // 스레드별 통계 슬롯 (크기는 스레드 시작 전에 정하고 이후 바꾸지 않는다)
+    handler_types_ = dispatcher_.messageTypes();
+    handler_type_index_.clear();
+    for (size_t i = 0; i < handler_types_.size(); ++i)
+        handler_type_index_[handler_types_[i]] = i;
 
-    if (::bind(server_fd_, (sockaddr *)&addr, sizeof(addr)) < 0)
+    conn_bucket_ = TokenBucket(rate_limits_.per_connection);
+    type_buckets_.assign(handler_types_.size() + 1, TokenBucket());
+    for (auto &[type, limit] : rate_limits_.per_type)
     {
-        perror("bind");
-        ::close(server_fd_);
-        return;
+        auto it = handler_type_index_.find(type);
+        if (it != handler_type_index_.end())
+            type_buckets_[it->second] = TokenBucket(limit);
+        else
+            LOG_WARN("[TcpServer] Rate limit for unregistered type '", type, "' ignored");
     }
-    if (::listen(server_fd_, 10) < 0)
+
+    // CPU를 고정하는 역할은 슬롯을 비워 두고 각 스레드가 고정한 뒤 만든다 (threadStats)
+    ptrdiff_t thread_made_stats = 0;
+    recv_stats_.clear();
+    recv_stats_.resize(recv_thread_count_);
+    if (affinity_.recv.empty())
     {
-        perror("listen");
-        ::close(server_fd_);
-        return;
+        for (auto &rs : recv_stats_)
+            rs = std::make_unique<RecvThreadStats>();
+    }
+    else
+    {
+        thread_made_stats += recv_thread_count_;
+    }
+    // 처리 스레드는 최대 수만큼 슬롯을 둔다. 처음부터 돌지 않는 슬롯의 통계는 여기서 만든다
+    pool_min_ = std::max(1, pool_limits_.min_threads > 0 ? pool_limits_.min_threads : process_thread_count_);
+    pool_max_ = std::max(pool_min_, pool_limits_.max_threads);
+    process_stats_.clear();
+    process_stats_.resize(pool_max_);
+    for (int i = 0; i < pool_max_; ++i)
+    {
+        if (affinity_.process.empty() || i >= pool_min_)
+            process_stats_[i] = newProcessStats();
+        else
+            ++thread_made_stats;
     }
+    send_stats_.clear();
+    send_stats_.resize(send_thread_count_);
+    if (affinity_.send.empty())
+    {
+        for (auto &ss : send_stats_)
+            ss = std::make_unique<SendThreadStats>();
+    }
+    else
+    {
+        thread_made_stats += send_thread_count_;
+    }
+    stats_ready_ = std::make_unique<std::latch>(thread_made_stats);
+    shm_stats_ = std::make_unique<RecvThreadStats>();
+    metrics_.reset(handler_types_.size() + 1);
 
     running_ = true;
+    in_flight_ = 0;
+    draining_ = false;
+
+    flush_epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    flush_wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (flush_epoll_fd_ >= 0 && flush_wake_fd_ >= 0)
+    {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = kFlushWakeId;
+        ::epoll_ctl(flush_epoll_fd_, EPOLL_CTL_ADD, flush_wake_fd_, &ev);
+        flush_thread_ = std::thread(&TcpServer::flushLoop, this);
+    }
+
+    // SO_INCOMING_CPU 배정표: 그 코어에 고정된 recv 스레드, 없으면 같은 NUMA 노드의 recv 스레드
+    recv_thread_by_cpu_.clear();
+    if (affinity_.steer_incoming_cpu && !affinity_.recv.empty())
+    {
+        const int ncpu = std::max(1, static_cast<int>(::sysconf(_SC_NPROCESSORS_CONF)));
+        recv_thread_by_cpu_.assign(ncpu, -1);
+        std::vector<int> recv_cpu(recv_thread_count_);
+        for (int i = 0; i < recv_thread_count_; ++i)
+            recv_cpu[i] = affinity_.recv[static_cast<size_t>(i) % affinity_.recv.size()];
+        for (int cpu = 0; cpu < ncpu; ++cpu)
+        {
+            auto exact = std::find(recv_cpu.begin(), recv_cpu.end(), cpu);
+            if (exact != recv_cpu.end())
+            {
+                recv_thread_by_cpu_[cpu] = static_cast<int>(exact - recv_cpu.begin());
+                continue;
+            }
+            const int node = cpuNumaNode(cpu);
+            for (int i = 0; node >= 0 && i < recv_thread_count_; ++i)
+            {
+                if (cpuNumaNode(recv_cpu[i]) == node)
+                {
+                    recv_thread_by_cpu_[cpu] = i;
+                    break;
+                }
+            }
+        }
+    }
+
+    recv_wake_fds_.assign(recv_thread_count_, -1);
+    for (int &fd : recv_wake_fds_)
+        fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC); // 실패하면 -1: 그 스레드는 100ms마다 요청함을 본다
+    recv_inboxes_.clear();
+    for (int i = 0; i < recv_thread_count_; ++i)
+        recv_inboxes_.push_back(std::make_unique<RecvInbox>());
 
+    accepting_ = true;
     for (int i = 0; i < accept_thread_count_; ++i)
-        accept_threads_.emplace_back(&TcpServer::acceptLoop, this);
+        accept_threads_.emplace_back(&TcpServer::acceptLoop, this, i);
     for (int i = 0; i < recv_thread_count_; ++i)
         recv_threads_.emplace_back(&TcpServer::recvLoop, this, i);
-    for (int i = 0; i < process_thread_count_; ++i)
-        process_threads_.emplace_back(&TcpServer::processLoop, this);
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        pool_closed_ = false;
+        pool_slot_running_.assign(pool_max_, true);
+        std::fill(pool_slot_running_.begin() + pool_min_, pool_slot_running_.end(), false);
+        process_active_ = pool_min_;
+        next_pool_check_ns_ = 0;
+        process_threads_.clear();
+        process_threads_.resize(pool_max_);
+        for (int i = 0; i < pool_min_; ++i)
+            process_threads_[i] = std::thread(&TcpServer::processLoop, this, i);
+    }
     for (int i = 0; i < send_thread_count_; ++i)
-        send_threads_.emplace_back(&TcpServer::sendLoop, this);
-    
-    // set default exception probe to no-op if not set
-    if (!exception_probe_)
+        send_threads_.emplace_back(&TcpServer::sendLoop, this, i);
+    const bool has_unix_listener = std::any_of(listeners_.begin(), listeners_.end(), [](const Listener &l)
+                                               { return l.address.isUnix(); });
+    if (has_unix_listener)
     {
-        exception_probe_ = [](const int, const int, ExceptionType) {};
+        shm_wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (shm_wake_fd_ >= 0)
+            shm_thread_ = std::thread(&TcpServer::shmLoop, this);
     }
+    stats_ready_->wait(); // 이후 stats()가 모든 슬롯을 읽을 수 있다
+    if (openAdminListener())
+        admin_thread_ = std::thread(&TcpServer::adminLoop, this);
+    if (!handoff_path_.empty() && openHandoffListener())
+        handoff_thread_ = std::thread(&TcpServer::handoffLoop, this);
 
     if (start_probe_)
     {
         start_probe_(TcpServerConfig{
-            .port = port_,
+            .server_fd = listeners_.front().fd,
+            .port = port(),
             .accept_thread_count = accept_thread_count_,
             .recv_thread_count = recv_thread_count_,
-            .process_thread_count = process_thread_count_,
+            .process_thread_count = pool_min_,
             .send_thread_count = send_thread_count_,
-            .log_level = Logger::instance().getLevel()
+            .log_level = Logger::instance().getLevel(),
+            .listen_ports = listenPorts()
         });
     }
+    return true;
 }
 
 void TcpServer::stop()
 {
     running_ = false;
-
-    close(server_fd_);
+    if (stop_fd_ >= 0)
+        ShmChannel::notify(stop_fd_);
 
     // 큐 종료 신호 전송
     recv_queue_.shutdown();
     send_queue_.shutdown();
 
-    for (auto &t : accept_threads_)
+    stopAccepting();
+
+    for (int i = 0; i < static_cast<int>(recv_wake_fds_.size()); ++i)
+        wakeRecvThread(i);
+    for (auto &t : recv_threads_)
     {
         if (t.joinable())
             t.join();
     }
 
-    for (auto &t : recv_threads_)
+    if (shm_thread_.joinable())
     {
-        if (t.joinable())
-            t.join();
+        ShmChannel::notify(shm_wake_fd_);
+        shm_thread_.join();
+    }
+    if (shm_wake_fd_ >= 0)
+    {
+        ::close(shm_wake_fd_);
+        shm_wake_fd_ = -1;
     }
+    shm_pending_.clear();
 
     for (auto &t : send_threads_)
     {
@@ -148,277 +499,1712 @@ void TcpServer::stop()
             t.join();
     }
 
+    // PAUSE로 기다리는 생산자와 flush 스레드를 깨운다
+    {
+        std::lock_guard<std::mutex> lock(client_mutex_);
+        outbound_cv_.notify_all();
+    }
+    if (flush_thread_.joinable())
+    {
+        ShmChannel::notify(flush_wake_fd_);
+        flush_thread_.join();
+    }
+    for (int *fd : {&flush_epoll_fd_, &flush_wake_fd_})
+    {
+        if (*fd >= 0)
+        {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+
+    {
+        // 닫은 뒤에는 process_threads_를 바꾸는 스레드가 없으므로 락 밖에서 join한다
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        pool_closed_ = true;
+    }
     for (auto &t : process_threads_)
     {
         if (t.joinable())
             t.join();
     }
-}
 
-void TcpServer::acceptLoop()
-{
-    while (running_)
+    if (admin_thread_.joinable())
+        admin_thread_.join();
+    closeAdminListener();
+    // 다른 스레드가 연결을 닫으며 recv 스레드를 깨울 수 있으므로 모든 스레드를 멈춘 뒤에 닫는다
+    for (int &fd : recv_wake_fds_)
     {
-        // select로 accept 가능 여부 확인 (timeout 포함)
-        fd_set rfds;
-        FD_ZERO(&rfds);
-        FD_SET(server_fd_, &rfds);
-
-        timeval tv{};
-        tv.tv_sec = 0;
-        tv.tv_usec = 500 * 1000; // 500ms timeout
-
-        int ready = ::select(server_fd_ + 1, &rfds, nullptr, nullptr, &tv);
-        if (ready < 0)
+        if (fd >= 0)
+            ::close(fd);
+        fd = -1;
+    }
+    for (int *fd : {&stop_fd_, &drain_wake_fd_})
+    {
+        if (*fd >= 0)
         {
-            exception_probe_(-1, server_fd_, ExceptionType::SOCKET_CREATION_FAILED);
-            if (errno == EINTR)
-            {
-                continue;
-            }
-            break; // 에러 발생
+            ::close(*fd);
+            *fd = -1;
         }
-        if (ready == 0)
-            continue; // timeout, running_ 재확인
+    }
+
+    // 남아 있는 클라이언트 연결 정리 (같은 프로세스에서 서버를 다시 만들 때 fd가 새지 않게)
+    std::lock_guard<std::mutex> lock1(client_mutex_);
+    for (auto &[cid, conn] : clients_)
+    {
+        ::close(conn.fd);
+        metrics_.connectionClosed();
+    }
+    // shm 세션은 ClientConn이 마지막 참조라 clear()에서 링 매핑과 fd가 정리된다
+    if (!clients_.empty())
+        LOG_INFO("[TcpServer] Closed ", clients_.size(), " remaining client connections");
+    clients_.clear();
+    outbound_bytes_.store(0, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock3(topics_mutex_);
+    topics_ = std::make_shared<const TopicMap>();
+    topics_version_.store(nextTopicsVersion(), std::memory_order_release);
+    client_topics_.clear();
+    retired_subscribers_.clear();
+    retired_count_.store(0, std::memory_order_relaxed);
+}
 
-        // accept 가능
-        sockaddr_in client_addr{};
-        socklen_t len = sizeof(client_addr);
+bool TcpServer::drain(int timeout_ms)
+{
+    if (!running_)
+        return true;
+    const int64_t deadline_ns = monotonicNowNs() + static_cast<int64_t>(timeout_ms) * 1000000;
+    drain_arrivals_.store(0, std::memory_order_relaxed);
+    draining_.store(true);
+
+    // 1) 새 접속을 멈추고 (넘겨준 리스너는 새 프로세스가 계속 받는다) 클라이언트에게 알린다
+    stopAccepting();
+    const size_t notified = broadcast({{"type", kGoawayType}});
+    LOG_INFO("[TcpServer] Draining ", notified, " connections (timeout ", timeout_ms, "ms)");
 
-        int client_fd = accept(server_fd_, (sockaddr *)&client_addr, &len);
+    // until_ns까지 drain_wake_fd_를 기다린다. 이미 지났으면 false
+    const auto waitWake = [this](int64_t until_ns)
+    {
+        const int64_t left_ns = until_ns - monotonicNowNs();
+        if (left_ns <= 0)
+            return false;
+        pollfd pfd{drain_wake_fd_, POLLIN, 0};
+        if (::poll(&pfd, 1, static_cast<int>((left_ns + 999999) / 1000000)) > 0)
+            ShmChannel::drain(drain_wake_fd_);
+        return true;
+    };
+    const auto openClients = [this]
+    {
+        std::lock_guard<std::mutex> lock(client_mutex_);
+        return clients_.size();
+    };
 
-        if (client_fd < 0)
+    // 2) 받은 요청을 다 처리해 응답까지 내보낼 때까지. goaway를 받은 클라이언트가 연결을 닫거나,
+    //    연결이 남아 있어도 한동안 새 프레임이 없으면 끝난 것으로 본다
+    constexpr int64_t kQuietNs = 200 * 1000000LL;
+    bool drained = false;
+    while (true)
+    {
+        // 처리/송신 스레드가 마지막 요청을 끝내는 순간 깨운다
+        if (!drainIdle())
         {
-            if (errno == EINTR || errno == EWOULDBLOCK || errno == EAGAIN)
-            {
-                exception_probe_(-1, server_fd_, ExceptionType::SOCKET_CREATION_FAILED);
-                continue;
-            }
-            if (!running_)
-                break; // 종료 중
+            if (!waitWake(deadline_ns))
+                break;
             continue;
         }
-
-        LOG_INFO("[TcpServer] New client connected: fd=", client_fd);
-
-        int client_id;
+        if (openClients() == 0)
         {
-            std::lock_guard<std::mutex> lock(client_mutex_);
-            client_id = next_client_id_++;
-            clients_[client_id] = client_fd;
+            drained = true;
+            break;
         }
-
-        // 라운드 로빈으로 스레드에 할당
+        // 조용한 구간 한 번 (마지막 연결이 닫히면 일찍 끝난다). 그 사이 프레임이 왔으면 처음부터
+        const uint64_t arrivals = drain_arrivals_.load(std::memory_order_relaxed);
+        const int64_t quiet_end = std::min(monotonicNowNs() + kQuietNs, deadline_ns);
+        while (openClients() > 0 && waitWake(quiet_end))
         {
-            std::lock_guard<std::mutex> lock(socket_assignment_mutex_);
-            socket_assignments_[client_fd] = client_id % recv_thread_count_;
         }
+        if (drain_arrivals_.load(std::memory_order_relaxed) != arrivals || !drainIdle())
+            continue;
+        if (openClients() == 0 || quiet_end < deadline_ns)
+            drained = true;
+        break;
     }
+
+    if (!drained)
+        LOG_WARN("[TcpServer] Drain timed out with ", in_flight_.load(), " requests in flight");
+    stop();
+    return drained;
 }
 
-void TcpServer::recvLoop(int thread_index)
+bool TcpServer::drainIdle() const
 {
-    while (running_)
-    {
-        // 1) 이 스레드에 할당된 클라이언트만 가져오기
-        std::vector<std::pair<int, int>> snapshot;
-        snapshot.reserve(64);
-
-        {
-            std::lock_guard<std::mutex> lock1(client_mutex_);
-            std::lock_guard<std::mutex> lock2(socket_assignment_mutex_);
-            for (auto &[cid, fd] : clients_)
-            {
-                auto it = socket_assignments_.find(fd);
-                if (it != socket_assignments_.end() && it->second == thread_index)
-                {
-                    snapshot.push_back({cid, fd});
-                }
-            }
-        }
+    return in_flight_.load() == 0 && recv_queue_.empty() && send_queue_.empty() && outbound_bytes_.load() == 0;
+}
 
-        if (snapshot.empty())
-        {
-            // 연결된 클라이언트 없으면 살짝 쉬기
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
-            continue;
-        }
+void TcpServer::notifyDrain()
+{
+    if (draining_.load())
+        ShmChannel::notify(drain_wake_fd_);
+}
 
-        // 2) select 준비
-        fd_set rfds;
-        FD_ZERO(&rfds);
-        int maxfd = -1;
-        for (auto &[cid, fd] : snapshot)
-        {
-            FD_SET(fd, &rfds);
-            if (fd > maxfd)
-                maxfd = fd;
-        }
+void TcpServer::releaseOutbound(int64_t bytes)
+{
+    if (bytes != 0 && outbound_bytes_.fetch_sub(bytes) == bytes)
+        notifyDrain();
+}
 
-        timeval tv{};
-        tv.tv_sec = 0;
-        tv.tv_usec = 100 * 1000; // 100ms
+void TcpServer::acceptLoop(int thread_index)
+{
+    pinThread("accept", affinity_.accept, thread_index);
 
-        int ready = ::select(maxfd + 1, &rfds, nullptr, nullptr, &tv);
-        if (ready <= 0)
-            continue; // timeout or error
+    // 모든 리스너를 epoll 하나로 기다린다 (리스너가 수천 개여도 FD_SETSIZE 제한 없음)
+    // EPOLLEXCLUSIVE: accept 스레드가 여러 개일 때 연결 하나에 한 스레드만 깨운다
+    int epfd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0)
+    {
+        perror("epoll_create1");
+        return;
+    }
+    for (size_t i = 0; i < listeners_.size(); ++i)
+    {
+        epoll_event ev{};
+        ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+        ev.data.u32 = static_cast<uint32_t>(i);
+        ::epoll_ctl(epfd, EPOLL_CTL_ADD, listeners_[i].fd, &ev);
+    }
+    // 종료 신호는 EXCLUSIVE 없이: 모든 accept 스레드가 깨어나야 한다
+    constexpr uint32_t kStopId = UINT32_MAX;
+    epoll_event stop_ev{};
+    stop_ev.events = EPOLLIN;
+    stop_ev.data.u32 = kStopId;
+    ::epoll_ctl(epfd, EPOLL_CTL_ADD, accept_stop_fd_, &stop_ev);
 
-        // 3) 읽을 수 있는 fd만 처리
-        for (auto &[client_id, fd] : snapshot)
+    std::vector<epoll_event> events(std::min<size_t>(listeners_.size(), 64) + 1);
+    std::vector<bool> woken(recv_thread_count_);
+    while (accepting_)
+    {
+        int ready = ::epoll_wait(epfd, events.data(), static_cast<int>(events.size()), -1);
+        if (ready < 0)
         {
-            if (!FD_ISSET(fd, &rfds))
+            if (errno == EINTR)
                 continue;
+            exception_probe_(-1, epfd, ExceptionType::SOCKET_CREATION_FAILED);
+            break; // 에러 발생
+        }
 
-            LOG_DEBUG("[TcpServer] Data available from client_id=", client_id, " fd=", fd);
+        std::fill(woken.begin(), woken.end(), false);
+        for (int e = 0; e < ready; ++e)
+        {
+            if (events[e].data.u32 == kStopId)
+                continue; // accepting_이 false라 루프를 빠져나간다
+            const Listener &listener = listeners_[events[e].data.u32];
 
-            uint32_t len_net = 0;
-            if (!recvAll(fd, &len_net, sizeof(len_net)))
+            // 대기 중인 연결을 모두 받는다
+            while (accepting_)
             {
-                LOG_INFO("[TcpServer] Client disconnected (len) client_id=", client_id);
-                int fd_to_close;
-                {
-                    std::lock_guard<std::mutex> lock(client_mutex_);
-                    auto it = clients_.find(client_id);
-                    if (it != clients_.end())
-                    {
-                        fd_to_close = it->second;
-                        ::close(it->second);
-                        clients_.erase(it);
-                    }
-                }
+                int client_fd = ::accept4(listener.fd, nullptr, nullptr, SOCK_CLOEXEC);
+                if (client_fd < 0)
                 {
-                    std::lock_guard<std::mutex> lock(socket_assignment_mutex_);
-                    socket_assignments_.erase(fd_to_close);
-                }
-                
-                exception_probe_(client_id, fd, ExceptionType::DISCONNECT);
-                continue;
-            }
-
-            uint32_t len = ntohl(len_net);
-            if (len == 0 || len > 4 * 1024 * 1024)
-            { // 방어(4MB 제한 예시)
-                LOG_WARN("[TcpServer] Invalid length=", len, " client_id=", client_id);
-                int fd_to_close;
-                {
-                    std::lock_guard<std::mutex> lock(client_mutex_);
-                    auto it = clients_.find(client_id);
-                    if (it != clients_.end())
-                    {
-                        fd_to_close = it->second;
-                        ::close(it->second);
-                        clients_.erase(it);
-                    }
-                }
-                {
-                    std::lock_guard<std::mutex> lock(socket_assignment_mutex_);
-                    socket_assignments_.erase(fd_to_close);
+                    if (errno == EINTR)
+                        continue;
+                    if (errno != EAGAIN && errno != EWOULDBLOCK)
+                        exception_probe_(-1, listener.fd, ExceptionType::SOCKET_CREATION_FAILED);
+                    break;
                 }
 
-                exception_probe_(client_id, fd, ExceptionType::INVALID_LENGTH);
-                continue;
-            }
+                if (listener.address.isUnix())
+                    LOG_INFO("[TcpServer] New client connected: fd=", client_fd, " unix=", listener.address.unix_path);
+                else
+                    LOG_INFO("[TcpServer] New client connected: fd=", client_fd, " port=", listener.address.port);
 
-            std::string payload(len, '\0');
-            if (!recvAll(fd, payload.data(), len))
-            {
-                LOG_INFO("[TcpServer] Client disconnected (payload) client_id=", client_id);
-                int fd_to_close;
+                int client_id;
+                int recv_thread;
                 {
                     std::lock_guard<std::mutex> lock(client_mutex_);
-                    auto it = clients_.find(client_id);
-                    if (it != clients_.end())
-                    {
-                        fd_to_close = it->second;
-                        ::close(it->second);
-                        clients_.erase(it);
-                    }
+                    client_id = next_client_id_++;
+                    ClientConn &conn = clients_[client_id];
+                    conn.fd = client_fd;
+                    conn.local_port = listener.address.port;
+                    conn.is_unix = listener.address.isUnix();
+                    conn.last_send_ns = monotonicNowNs();
+                    if (rate_limits_.enabled())
+                        conn.rate = std::make_shared<RateState>(type_buckets_.size());
+                    conn.recv_thread = pickRecvThread(client_id, client_fd);
+                    recv_thread = conn.recv_thread;
+
+                    // client_mutex_ 안에서 넣어야 이 연결의 제거 요청이 등록 요청보다 앞설 수 없다
+                    RecvInbox &inbox = *recv_inboxes_[recv_thread];
+                    std::lock_guard<std::mutex> inbox_lock(inbox.mutex);
+                    inbox.changes.push_back(
+                        {RecvConn{client_id, client_fd, conn.local_port, conn.closed, conn.read_paused, conn.rate}});
                 }
+                metrics_.connectionAccepted();
+                LOG_TRACE_EVENT(CONNECT, client_id, 0, listener.address.port);
+
+                // 첫 연결은 바로 깨우고, 같은 깨어남에 몰려 온 연결은 스레드마다 한 번만 깨운다
+                // (recv 스레드는 깨어날 때 요청함을 통째로 비우므로 그 사이 넣은 연결도 함께 등록한다)
+                if (!woken[recv_thread])
                 {
-                    std::lock_guard<std::mutex> lock(socket_assignment_mutex_);
-                    socket_assignments_.erase(fd_to_close);
+                    woken[recv_thread] = true;
+                    wakeRecvThread(recv_thread);
                 }
-
-                exception_probe_(client_id, fd, ExceptionType::DISCONNECT);
-                continue;
             }
-
-            // 예외 없이 파싱
-            auto j = nlohmann::json::parse(payload, nullptr, false);
-            if (j.is_discarded())
-            {
-                LOG_WARN("[TcpServer] Invalid JSON from client_id=", client_id);
-                // 에러 응답 보내도 되고, 무시해도 됨
-                nlohmann::json err =
-                    {
-                        {"type", "error"},
-                        {"ok", false},
-                        {"reason", "invalid_json"}};
-                send_queue_.push({client_id, err});
-
-                exception_probe_(client_id, fd, ExceptionType::INVALID_LENGTH);
-                
-                continue;
-            }
-            LOG_DEBUG("[TcpServer] Received message from client ", client_id);
-            recv_queue_.push({client_id, j});
         }
     }
+
+    ::close(epfd);
 }
 
-void TcpServer::sendLoop()
+std::unique_ptr<TcpServer::ProcessThreadStats> TcpServer::newProcessStats() const
 {
-    while (running_)
+    auto ps = std::make_unique<ProcessThreadStats>();
+    for (size_t t = 0; t <= handler_types_.size(); ++t)
+        ps->handler.push_back(std::make_unique<LatencyHistogram>());
+    return ps;
+}
+
+void TcpServer::maybeGrowProcessPool(int64_t now_ns, int64_t wait_ns)
+{
+    // 넣고 꺼낼 때마다 부르므로 빠른 경로는 atomic load 둘. 1ms에 한 스레드만 판단한다
+    constexpr int64_t kCheckNs = 1000000;
+    if (process_active_.load(std::memory_order_relaxed) >= pool_max_)
+        return;
+    int64_t next = next_pool_check_ns_.load(std::memory_order_relaxed);
+    if (now_ns < next ||
+        !next_pool_check_ns_.compare_exchange_strong(next, now_ns + kCheckNs, std::memory_order_relaxed))
+        return;
+
+    // 꺼낸 요청의 대기 시간과 지금 맨 앞 요청의 대기 시간 중 긴 쪽 (처리 스레드가 모두 막히면 꺼내는 요청이 없다)
+    wait_ns = std::max(wait_ns, recv_queue_.peek_front(int64_t{0}, [now_ns](const Message &head)
+                                                       { return now_ns - head.enqueue_ns; }));
+    const bool backlog = wait_ns >= static_cast<int64_t>(pool_limits_.grow_wait_ms) * 1000000 ||
+                         (pool_limits_.grow_depth > 0 && recv_queue_.size() >= pool_limits_.grow_depth);
+    if (!backlog)
+        return;
+    next_pool_check_ns_.store(now_ns + static_cast<int64_t>(pool_limits_.grow_interval_ms) * 1000000,
+                              std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    if (pool_closed_ || !running_ || process_active_.load(std::memory_order_relaxed) >= pool_max_)
+        return;
+    auto free_slot = std::find(pool_slot_running_.begin(), pool_slot_running_.end(), false);
+    if (free_slot == pool_slot_running_.end())
+        return;
+    const int slot = static_cast<int>(free_slot - pool_slot_running_.begin());
+    std::thread &t = process_threads_[slot];
+    if (t.joinable())
+        t.join(); // 전에 줄어든 스레드 (retireProcessThread에서 락을 놓은 뒤 바로 끝난다)
+    pool_slot_running_[slot] = true;
+    const int active = process_active_.fetch_add(1, std::memory_order_relaxed) + 1;
+    t = std::thread(&TcpServer::processLoop, this, slot);
+    LOG_INFO("[TcpServer] Process pool grew to ", active, " threads (queue wait ", wait_ns / 1000, "us)");
+}
+
+bool TcpServer::retireProcessThread(int thread_index)
+{
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    const int active = process_active_.load(std::memory_order_relaxed);
+    if (active <= pool_min_)
+        return false; // 다른 스레드가 먼저 줄었다
+    process_active_.store(active - 1, std::memory_order_relaxed);
+    pool_slot_running_[thread_index] = false;
+    LOG_INFO("[TcpServer] Process pool shrank to ", active - 1, " threads");
+    return true;
+}
+
+int TcpServer::pickRecvThread(int client_id, int fd) const
+{
+    // 연결의 패킷을 처리한 코어(NIC 큐의 인터럽트 코어)에 있는 recv 스레드로 보내 캐시/노드를 넘나들지 않게 한다
+    if (!recv_thread_by_cpu_.empty())
+    {
+        int cpu = -1;
+        socklen_t len = sizeof(cpu);
+        if (::getsockopt(fd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) == 0 && cpu >= 0 &&
+            cpu < static_cast<int>(recv_thread_by_cpu_.size()) && recv_thread_by_cpu_[cpu] >= 0)
+            return recv_thread_by_cpu_[cpu];
+    }
+    return client_id % recv_thread_count_; // 라운드 로빈
+}
+
+void TcpServer::closeClient(int client_id, int fd, ExceptionType reason)
+{
+    {
+        std::lock_guard<std::mutex> lock(client_mutex_);
+        auto it = clients_.find(client_id);
+        if (it != clients_.end())
+            dropClientLocked(it);
+    }
+    LOG_TRACE_EVENT(DISCONNECT, client_id, 0, static_cast<uint64_t>(reason));
+    exception_probe_(client_id, fd, reason);
+}
+
+void TcpServer::dropClientLocked(std::map<int, ClientConn>::iterator it)
+{
+    const int client_id = it->first;
+    ClientConn &conn = it->second;
+    if (conn.shm)
+        releaseShm(*conn.shm);
+    conn.closed->store(true, std::memory_order_release);
+    ::close(conn.fd); // flush/recv epoll 등록도 fd와 함께 사라진다
+    // recv 스레드의 연결 목록에서 뺀다 (공유 메모리로 넘긴 연결은 넘길 때 이미 뺐다)
+    if (!conn.shm)
+        removeFromRecvThread(client_id, conn);
+    releaseOutbound(static_cast<int64_t>(conn.out_bytes));
+    if (conn.paused)
+    {
+        paused_clients_.erase(client_id);
+        paused_count_.store(paused_clients_.size(), std::memory_order_relaxed);
+    }
+    const bool subscribed = conn.subscribed;
+    clients_.erase(it);
+    if (subscribed)
+        retireSubscriber(client_id); // 목록 정리는 recv/shm 스레드가 다음 차례에 모아서 한다
+    metrics_.connectionClosed();
+    outbound_cv_.notify_all();
+    notifyDrain();
+}
+
+void TcpServer::removeFromRecvThread(int client_id, const ClientConn &conn)
+{
+    RecvInbox::Change change;
+    change.conn.client_id = client_id;
+    change.remove = true;
+    RecvInbox &inbox = *recv_inboxes_[conn.recv_thread];
+    {
+        std::lock_guard<std::mutex> lock(inbox.mutex);
+        inbox.changes.push_back(std::move(change));
+    }
+    wakeRecvThread(conn.recv_thread);
+}
+
+void TcpServer::wakeRecvThread(int thread_index)
+{
+    if (recv_wake_fds_[thread_index] >= 0)
+        ShmChannel::notify(recv_wake_fds_[thread_index]);
+}
+
+void TcpServer::recvLoop(int thread_index)
+{
+    pinThread("recv", affinity_.recv, thread_index);
+    RecvThreadStats &stats = threadStats(recv_stats_[thread_index], []
+                                         { return std::make_unique<RecvThreadStats>(); });
+    RecvInbox &inbox = *recv_inboxes_[thread_index];
+    const int wake_fd = recv_wake_fds_[thread_index];
+    int epfd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0)
+    {
+        perror("epoll_create1");
+        return;
+    }
+    if (wake_fd >= 0)
+    {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u64 = kRecvWakeId;
+        ::epoll_ctl(epfd, EPOLL_CTL_ADD, wake_fd, &ev);
+    }
+
+    // 이 스레드가 읽는 연결. epoll 등록은 연결이 붙고 떨어질 때만 바꾼다
+    std::unordered_map<int, RecvConn> conns;
+    std::vector<int> parked; // PAUSE/DELAY로 관심을 끈 연결 (풀리면 다시 켠다)
+    std::vector<RecvInbox::Change> changes;
+    std::vector<epoll_event> events(256);
+    IoTimers timers(this, monotonicNowNs());
+    const bool conn_timers = timeouts_.enabled();
+
+    const auto setInterest = [epfd](const RecvConn &c, uint32_t mask)
+    {
+        epoll_event ev{};
+        ev.events = mask;
+        ev.data.u64 = static_cast<uint64_t>(c.client_id);
+        ::epoll_ctl(epfd, EPOLL_CTL_MOD, c.fd, &ev);
+    };
+    const auto forget = [&](int client_id)
+    {
+        conns.erase(client_id);
+        timers.last_recv_ns.erase(client_id);
+    };
+
+    while (running_)
+    {
+        timers.wheel.advance(monotonicNowNs());
+        if (retired_count_.load(std::memory_order_relaxed) > 0)
+            purgeSubscribers();
+
+        // 1) 요청함 반영 (새 연결 등록, 닫혔거나 공유 메모리로 넘어간 연결 제거). 들어온 순서대로
+        {
+            std::lock_guard<std::mutex> lock(inbox.mutex);
+            changes.swap(inbox.changes);
+        }
+        for (RecvInbox::Change &change : changes)
+        {
+            const int client_id = change.conn.client_id;
+            if (change.remove)
+            {
+                auto it = conns.find(client_id);
+                if (it == conns.end())
+                    continue; // 이 스레드가 직접 닫았다
+                ::epoll_ctl(epfd, EPOLL_CTL_DEL, it->second.fd, nullptr); // 이미 닫힌 fd면 epoll에서도 빠져 있다
+                forget(client_id);
+                continue;
+            }
+            epoll_event ev{};
+            ev.events = EPOLLIN;
+            ev.data.u64 = static_cast<uint64_t>(client_id);
+            if (::epoll_ctl(epfd, EPOLL_CTL_ADD, change.conn.fd, &ev) < 0)
+                continue;
+            // 등록하는 사이 닫혔으면 fd 번호가 다른 연결에 다시 쓰였을 수 있으므로 바로 뺀다 (제거 요청은 뒤따라온다)
+            if (change.conn.closed->load(std::memory_order_acquire))
+            {
+                ::epoll_ctl(epfd, EPOLL_CTL_DEL, change.conn.fd, nullptr);
+                continue;
+            }
+            // 점검 타이머는 이후 스스로 다음 기한에 다시 건다
+            if (conn_timers)
+            {
+                const int64_t now = monotonicNowNs();
+                if (timers.last_recv_ns.try_emplace(client_id, now).second)
+                    scheduleConnectionCheck(timers, client_id, now);
+            }
+            conns.emplace(client_id, std::move(change.conn));
+        }
+        changes.clear();
+
+        // 2) 쉬던 연결 중 풀린 것을 다시 읽는다 (PAUSE는 flush/shm 쪽이 풀면서 깨운다)
+        int64_t resume_ns = INT64_MAX; // 요청 수 제한(DELAY)으로 쉬는 연결 중 가장 먼저 다시 읽을 시각
+        if (!parked.empty())
+        {
+            const int64_t now = monotonicNowNs();
+            std::erase_if(parked, [&](int client_id)
+                          {
+                              auto it = conns.find(client_id);
+                              if (it == conns.end())
+                                  return true;
+                              RecvConn &c = it->second;
+                              if (c.paused->load(std::memory_order_acquire))
+                                  return false;
+                              if (c.rate)
+                              {
+                                  const int64_t resume = c.rate->resume_ns.load(std::memory_order_relaxed);
+                                  if (resume > now)
+                                  {
+                                      resume_ns = std::min(resume_ns, resume);
+                                      return false;
+                                  }
+                              }
+                              c.parked = false;
+                              setInterest(c, EPOLLIN);
+                              return true; });
+        }
+
+        // 다음 타이머 기한, 쉬던 연결을 다시 읽을 시각 중 이른 때까지. 둘 다 없으면 wake eventfd가 올 때까지
+        // (wake eventfd가 없으면 요청함을 보려고 100ms마다 깨어난다)
+        int64_t timeout_ms = wake_fd >= 0 ? -1 : 100;
+        const auto wakeBy = [&](int64_t ms)
+        {
+            ms = std::max<int64_t>(0, ms);
+            if (timeout_ms < 0 || ms < timeout_ms)
+                timeout_ms = ms;
+        };
+        const int64_t poll_now = monotonicNowNs();
+        const int64_t next_timer_ns = timers.wheel.nextTimeoutNs(poll_now);
+        if (next_timer_ns >= 0)
+            wakeBy((next_timer_ns + 999999) / 1000000);
+        if (resume_ns != INT64_MAX)
+            wakeBy((resume_ns - poll_now + 999999) / 1000000);
+
+        int ready = ::epoll_wait(epfd, events.data(), static_cast<int>(events.size()), static_cast<int>(timeout_ms));
+        if (ready <= 0)
+            continue; // timeout or error
+
+        // 3) 읽을 수 있는 연결만 처리
+        for (int e = 0; e < ready; ++e)
+        {
+            if (events[e].data.u64 == kRecvWakeId)
+            {
+                ShmChannel::drain(wake_fd); // 요청함/쉬던 연결은 다음 차례 맨 앞에서 본다
+                continue;
+            }
+            const int client_id = static_cast<int>(events[e].data.u64);
+            auto it = conns.find(client_id);
+            if (it == conns.end())
+                continue;
+            RecvConn &c = it->second;
+            if (c.closed->load(std::memory_order_acquire))
+                continue; // 다른 스레드가 닫았다 (제거 요청이 곧 온다)
+            const int fd = c.fd;
+
+            const int64_t recv_ns = monotonicNowNs();
+            if (c.parked)
+            {
+                // 관심을 꺼도 HUP/ERR는 온다. 상대가 완전히 끊었으면 더 기다릴 이유가 없다
+                LOG_INFO("[TcpServer] Client disconnected (hup) client_id=", client_id);
+                closeClient(client_id, fd, ExceptionType::DISCONNECT);
+                forget(client_id);
+                continue;
+            }
+            // PAUSE: 송신 대기열이 빠질 때까지, DELAY: 빚을 갚을 때까지 읽지 않는다
+            // (레벨 트리거라 그냥 두면 계속 깨어나므로 관심을 끈다. 소켓 버퍼가 차면 클라이언트 쪽 write가 막힌다)
+            if (c.paused->load(std::memory_order_acquire) ||
+                (c.rate && c.rate->resume_ns.load(std::memory_order_relaxed) > recv_ns))
+            {
+                c.parked = true;
+                setInterest(c, 0);
+                parked.push_back(client_id);
+                continue;
+            }
+
+            LOG_DEBUG("[TcpServer] Data available from client_id=", client_id, " fd=", fd);
+
+            uint32_t len_net = 0;
+            if (!recvAll(fd, &len_net, sizeof(len_net)))
+            {
+                LOG_INFO("[TcpServer] Client disconnected (len) client_id=", client_id);
+                closeClient(client_id, fd, ExceptionType::DISCONNECT);
+                forget(client_id);
+                continue;
+            }
+
+            uint32_t len = ntohl(len_net);
+            if (!isValidFrameLength(len))
+            {
+                LOG_WARN("[TcpServer] Invalid length=", len, " client_id=", client_id);
+                closeClient(client_id, fd, ExceptionType::INVALID_LENGTH);
+                forget(client_id);
+                continue;
+            }
+
+            std::string payload(len, '\0');
+            if (!recvAll(fd, payload.data(), len))
+            {
+                LOG_INFO("[TcpServer] Client disconnected (payload) client_id=", client_id);
+                closeClient(client_id, fd, ExceptionType::DISCONNECT);
+                forget(client_id);
+                continue;
+            }
+
+            if (conn_timers)
+                timers.last_recv_ns[client_id] = recv_ns;
+            if (!enqueueFrame(client_id, fd, c.local_port, payload, recv_ns, stats, c.closed, c.rate.get(), false))
+                forget(client_id);
+        }
+    }
+
+    ::close(epfd);
+}
+
+void TcpServer::scheduleConnectionCheck(IoTimers &timers, int client_id, int64_t at_ns)
+{
+    // [&timers, client_id]만 잡아서 std::function 내부 버퍼에 들어간다 (타이머마다 할당 없음)
+    timers.wheel.schedule(at_ns, [&timers, client_id]
+                          { timers.server->checkConnection(timers, client_id); });
+}
+
+void TcpServer::checkConnection(IoTimers &timers, int client_id)
+{
+    auto st = timers.last_recv_ns.find(client_id);
+    if (st == timers.last_recv_ns.end())
+        return; // 이미 정리된 연결
+
+    const int64_t now = monotonicNowNs();
+    const auto ms = [](int v)
+    { return static_cast<int64_t>(v) * 1000000; };
+    int64_t next = INT64_MAX;
+    ExceptionType reason = ExceptionType::DISCONNECT;
+    bool expired = false;
+    bool heartbeat = false;
+    int fd = -1;
+    {
+        std::lock_guard<std::mutex> lock(client_mutex_);
+        auto it = clients_.find(client_id);
+        if (it == clients_.end() || static_cast<bool>(it->second.shm) != timers.shm)
+        {
+            // 끊겼거나 공유 메모리로 전환됨 (전환된 연결은 shm 스레드의 타이머가 이어서 점검한다)
+            timers.last_recv_ns.erase(st);
+            return;
+        }
+        ClientConn &conn = it->second;
+        fd = conn.fd;
+
+        // PAUSE 중에는 서버가 읽지 않는 것이므로 유휴로 보지 않는다
+        if (timeouts_.idle_timeout_ms > 0 && !conn.paused)
+        {
+            const int64_t deadline = st->second + ms(timeouts_.idle_timeout_ms);
+            if (now >= deadline)
+            {
+                expired = true;
+                reason = ExceptionType::IDLE_TIMEOUT;
+            }
+            next = std::min(next, deadline);
+        }
+        if (!expired && timeouts_.write_stall_timeout_ms > 0)
+        {
+            const int64_t period = ms(timeouts_.write_stall_timeout_ms);
+            if (!conn.outbox.empty() && now >= conn.out_progress_ns + period)
+            {
+                expired = true;
+                reason = ExceptionType::WRITE_STALL;
+            }
+            next = std::min(next, conn.outbox.empty() ? now + period : conn.out_progress_ns + period);
+        }
+        if (!expired && timeouts_.heartbeat_interval_ms > 0)
+        {
+            const int64_t period = ms(timeouts_.heartbeat_interval_ms);
+            heartbeat = now >= conn.last_send_ns + period;
+            next = std::min(next, heartbeat ? now + period : conn.last_send_ns + period);
+        }
+
+        if (expired)
+        {
+            if (reason == ExceptionType::IDLE_TIMEOUT)
+                metrics_.idleTimeout();
+            else
+                metrics_.writeStall();
+            dropClientLocked(it);
+        }
+    }
+
+    if (expired)
+    {
+        timers.last_recv_ns.erase(st);
+        LOG_INFO("[TcpServer] Closing client_id=", client_id,
+                 reason == ExceptionType::IDLE_TIMEOUT ? " (idle timeout)" : " (write stall)");
+        LOG_TRACE_EVENT(DISCONNECT, client_id, 0, static_cast<uint64_t>(reason));
+        exception_probe_(client_id, fd, reason);
+        return;
+    }
+
+    if (heartbeat)
+    {
+        // 하트비트 프레임은 한 번만 만들어 두고 공유한다 (PAUSE 대기 없이 바로 송신 큐로)
+        static const auto frame = std::make_shared<const std::string>(encodeFrame({{"type", kHeartbeatType}}));
+        Message msg{client_id, nullptr, 0, now, now};
+        msg.frame = frame;
+        send_queue_.push(std::move(msg));
+        metrics_.heartbeat();
+    }
+    if (next != INT64_MAX)
+        scheduleConnectionCheck(timers, client_id, next);
+}
+
+bool TcpServer::enqueueFrame(int client_id, int fd, int local_port, std::string_view payload, int64_t recv_ns,
+                             RecvThreadStats &stats, std::shared_ptr<const std::atomic<bool>> closed, RateState *rate,
+                             bool via_shm)
+{
+    const size_t len = payload.size();
+
+    // 예외 없이 파싱
+    auto j = nlohmann::json::parse(payload, nullptr, false);
+    if (j.is_discarded())
+    {
+        LOG_WARN("[TcpServer] Invalid JSON from client_id=", client_id);
+        // 에러 응답 보내도 되고, 무시해도 됨
+        nlohmann::json err =
+            {
+                {"type", "error"},
+                {"ok", false},
+                {"reason", errorReasonName(ErrorReason::INVALID_JSON)}};
+        send_queue_.push({client_id, std::move(err), 0, recv_ns, monotonicNowNs(), local_port});
+
+        metrics_.frameIn(kFrameHeaderSize + len);
+        metrics_.error(ErrorReason::INVALID_JSON);
+        LOG_TRACE_EVENT(PARSE_ERROR, client_id, 0, len);
+        exception_probe_(client_id, fd, ExceptionType::INVALID_LENGTH);
+        return true;
+    }
+    metrics_.frameIn(kFrameHeaderSize + len);
+
+    // 공유 메모리 전환 요청과 클라이언트 하트비트(수신 시각만 갱신)는 디스패처로 보내지 않는다
+    if (j.is_object())
+    {
+        auto t = j.find("type");
+        if (t != j.end() && t->is_string())
+        {
+            const std::string &type = t->get_ref<const std::string &>();
+            if (type == kHeartbeatType)
+                return true;
+            if (!via_shm && type == kShmAttachType)
+            {
+                attachShm(client_id, fd);
+                return true;
+            }
+        }
+    }
+
+    // 요청 수 제한: 거절할 때도 req_id를 돌려줘야 하므로 파싱 뒤, 큐에 넣기 전에 본다
+    if (rate && !chargeRate(*rate, j, recv_ns))
+    {
+        if (rate_limits_.action == RateLimitAction::DISCONNECT)
+        {
+            LOG_INFO("[TcpServer] Rate limit exceeded, disconnecting client_id=", client_id);
+            metrics_.rateLimitDisconnect();
+            closeClient(client_id, fd, ExceptionType::RATE_LIMITED);
+            return false;
+        }
+        rejectFrame(client_id, local_port, j, recv_ns, ErrorReason::RATE_LIMITED);
+        return true;
+    }
+
+    // 과부하: 큐에서 몇 초씩 기다리게 하느니 지금 바로 거절한다 (처리 스레드를 거치지 않음)
+    const auto head_sojourn = [&]
+    { return recv_queue_.peek_front(int64_t{0}, [&](const Message &head)
+                                    { return recv_ns - head.enqueue_ns; }); };
+    if (admission_.enabled() && admission_.shedding(recv_ns, head_sojourn) && !highPriority(j))
+    {
+        rejectFrame(client_id, local_port, j, recv_ns, ErrorReason::OVERLOADED);
+        return true;
+    }
+
+    LOG_DEBUG("[TcpServer] Received message from client ", client_id);
+    uint64_t req_hash = 0;
+    if (Logger::instance().traceEnabled())
+    {
+        req_hash = TraceLog::hashReqId(j);
+        Logger::instance().trace(TraceEvent::RECV, client_id, req_hash, len);
+    }
+    const int64_t enqueue_ns = monotonicNowNs();
+    Message msg{client_id, std::move(j), req_hash, recv_ns, enqueue_ns, local_port};
+    msg.cancel.closed = std::move(closed);
+    in_flight_.fetch_add(1, std::memory_order_relaxed);
+    if (draining_.load(std::memory_order_relaxed))
+        drain_arrivals_.fetch_add(1, std::memory_order_relaxed);
+    recv_queue_.push(std::move(msg));
+    stats.recv_to_enqueue.record(static_cast<uint64_t>(enqueue_ns - recv_ns));
+    // 처리 스레드가 모두 핸들러에 묶여 있으면 꺼내는 쪽에서는 늘릴 기회가 없으므로 넣는 쪽에서도 본다
+    if (pool_max_ > pool_min_)
+        maybeGrowProcessPool(enqueue_ns, 0);
+    return true;
+}
+
+bool TcpServer::chargeRate(RateState &rate, const nlohmann::json &req, int64_t now_ns)
+{
+    const bool force = rate_limits_.action == RateLimitAction::DELAY;
+    const bool batch = req.is_array();
+    int64_t wait = 0;
+
+    if (conn_bucket_.enabled())
+    {
+        const uint32_t cost = batch ? static_cast<uint32_t>(std::max<size_t>(1, req.size())) : 1;
+        wait = conn_bucket_.take(rate.conn_tat, now_ns, cost, force);
+        if (wait > 0 && !force)
+            return false;
+    }
+
+    // type별 버킷 (배치는 요소마다. 거절된 배치도 앞서 확인한 버킷에서 쓴 만큼은 남는다)
+    auto take_type = [&](const nlohmann::json &item)
+    {
+        const size_t slot = handlerTypeIndex(item);
+        if (!type_buckets_[slot].enabled())
+            return true;
+        const int64_t w = type_buckets_[slot].take(rate.type_tat[slot], now_ns, 1, force);
+        wait = std::max(wait, w);
+        return w == 0 || force;
+    };
+    if (batch)
+    {
+        for (const nlohmann::json &item : req)
+        {
+            if (!take_type(item))
+                return false;
+        }
+    }
+    else if (!take_type(req))
+    {
+        return false;
+    }
+
+    if (wait > 0)
+    {
+        // DELAY: 이번 요청은 받고, 빚을 갚을 때까지 이 연결을 읽지 않는다
+        int64_t resume = rate.resume_ns.load(std::memory_order_relaxed);
+        const int64_t until = now_ns + wait;
+        while (resume < until && !rate.resume_ns.compare_exchange_weak(resume, until, std::memory_order_relaxed))
+        {
+        }
+        metrics_.rateLimitDelay();
+    }
+    return true;
+}
+
+void TcpServer::rejectFrame(int client_id, int local_port, const nlohmann::json &req, int64_t recv_ns, ErrorReason reason)
+{
+    const std::string reason_name = errorReasonName(reason);
+    nlohmann::json err;
+    size_t rejected = 1;
+    if (req.is_array())
+    {
+        rejected = req.size();
+        err = nlohmann::json::array();
+        for (const nlohmann::json &item : req)
+            err.push_back(Dispatcher::makeError(item.is_object() ? item : nlohmann::json::object(), reason_name));
+    }
+    else
+    {
+        err = Dispatcher::makeError(req.is_object() ? req : nlohmann::json::object(), reason_name);
+    }
+    send_queue_.push({client_id, std::move(err), 0, recv_ns, monotonicNowNs(), local_port});
+    for (size_t i = 0; i < rejected; ++i)
+        metrics_.error(reason);
+}
+
+void TcpServer::attachShm(int client_id, int fd)
+{
+    auto session = std::make_shared<ShmSession>();
+    session->client_id = client_id;
+    session->fd = fd;
+
+    // memfd + mmap(MAP_POPULATE)은 링 크기만큼 페이지를 채우느라 오래 걸릴 수 있으므로 락 밖에서 만든다
+    bool attached = shm_thread_.joinable() && session->channel.create(shm_ring_bytes_);
+    if (attached)
+    {
+        std::lock_guard<std::mutex> lock(client_mutex_);
+        auto it = clients_.find(client_id);
+        if (it == clients_.end())
+            return;
+        // 소켓으로 보내다 만 프레임이 남아 있으면 전환하지 않는다 (클라이언트는 전환 뒤 소켓을 읽지 않는다)
+        ClientConn &conn = it->second;
+        attached = conn.is_unix && !conn.shm && conn.outbox.empty();
+        if (attached)
+        {
+            // 이후 응답은 링으로 간다. 그 전에 쓴 소켓 프레임 뒤에 아래 attach 응답이 붙고,
+            // 클라이언트는 attach 응답을 받은 뒤에 링을 읽으므로 순서가 유지된다
+            session->rate = conn.rate;
+            session->paused = conn.read_paused;
+            conn.shm = session;
+            // 이후 이 소켓으로는 프레임이 오지 않는다. recv 스레드 대신 shm 스레드가 링과 종료를 본다
+            removeFromRecvThread(client_id, conn);
+        }
+    }
+
+    if (!attached)
+    {
+        LOG_WARN("[TcpServer] Shared memory transport unavailable for client_id=", client_id);
+        nlohmann::json err = {{"type", "error"}, {"ok", false}, {"reason", errorReasonName(ErrorReason::SHM_UNAVAILABLE)}};
+        const int64_t now = monotonicNowNs();
+        send_queue_.push({client_id, std::move(err), 0, now, now});
+        metrics_.error(ErrorReason::SHM_UNAVAILABLE);
+        return;
+    }
+
+    // conn.shm을 세운 뒤로는 아무도 이 소켓에 쓰지 않으므로 락 없이 보낸다
+    if (!session->channel.sendAttachReply(fd))
+    {
+        LOG_WARN("[TcpServer] Failed to send shm attach reply to client_id=", client_id, ", closing");
+        closeClient(client_id, fd, ExceptionType::DISCONNECT);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(shm_mutex_);
+        shm_pending_.push_back(std::move(session));
+    }
+    shm_changed_.store(true, std::memory_order_release);
+    ShmChannel::notify(shm_wake_fd_);
+    LOG_INFO("[TcpServer] client_id=", client_id, " switched to shared memory transport");
+}
+
+// client_mutex_를 잡은 상태에서 호출 (연결 정리 시)
+void TcpServer::releaseShm(ShmSession &session)
+{
+    session.closed.store(true, std::memory_order_release);
+    shm_changed_.store(true, std::memory_order_release);
+    ShmChannel::notify(shm_wake_fd_);
+}
+
+bool TcpServer::flushShmOutbox(ShmSession &session)
+{
+    std::lock_guard<std::mutex> lock(client_mutex_);
+    auto it = clients_.find(session.client_id);
+    if (it == clients_.end() || it->second.shm.get() != &session)
+    {
+        session.out_pending.store(false, std::memory_order_relaxed);
+        return true;
+    }
+
+    ClientConn &conn = it->second;
+    ShmRing &ring = session.channel.s2c();
+    size_t moved = 0;
+    {
+        std::lock_guard<std::mutex> wlock(session.write_mutex);
+        while (!conn.outbox.empty())
+        {
+            const std::string &frame = *conn.outbox.front().frame;
+            if (!ring.tryWrite(frame))
+            {
+                // 클라이언트가 자리를 비우면 to_server eventfd로 이 스레드를 깨운다
+                if (ring.corrupt() || ring.prepareWait(frame.size()))
+                    break;
+                continue;
+            }
+            conn.out_bytes -= frame.size();
+            releaseOutbound(static_cast<int64_t>(frame.size()));
+            conn.outbox.pop_front();
+            ++moved;
+        }
+        if (ring.corrupt())
+            return false;
+    }
+    if (moved > 0)
+    {
+        conn.out_progress_ns = monotonicNowNs();
+        if (ring.consumerSleeping())
+            ShmChannel::notify(session.channel.toClientFd());
+    }
+    if (conn.outbox.empty())
+    {
+        session.out_pending.store(false, std::memory_order_relaxed);
+        conn.over_limit = false;
+    }
+    // 이 세션의 c2s 링은 이 스레드가 다음 차례에 다시 읽는다
+    if (resumeIfDrained(session.client_id, conn))
+        outbound_cv_.notify_all();
+    return true;
+}
+
+// 공유 메모리로 전환한 모든 연결의 c2s 링을 한 스레드가 돌며 recv_queue_로 옮긴다
+// - 링이 비어도 shm_spin_us_ 동안은 바쁜 대기 (이 구간의 요청은 시스템 콜 없이 들어온다)
+// - 그 뒤에는 링마다 잠듦 플래그를 세우고 eventfd + 유닉스 소켓(상대 종료)을 epoll로 기다린다
+void TcpServer::shmLoop()
+{
+    RecvThreadStats &stats = *shm_stats_;
+    int epfd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0)
+    {
+        perror("epoll_create1");
+        return;
+    }
+    epoll_event wake_ev{};
+    wake_ev.events = EPOLLIN;
+    wake_ev.data.ptr = nullptr;
+    ::epoll_ctl(epfd, EPOLL_CTL_ADD, shm_wake_fd_, &wake_ev);
+
+    std::vector<std::shared_ptr<ShmSession>> sessions;
+    std::vector<epoll_event> events(64);
+    std::string scratch;
+    // 코어가 하나뿐이면 바쁜 대기는 상대 스레드의 시간만 뺏으므로 바로 잠든다
+    const int64_t spin_ns = std::thread::hardware_concurrency() > 1 ? static_cast<int64_t>(shm_spin_us_) * 1000 : 0;
+    int64_t idle_since = monotonicNowNs();
+    IoTimers timers(this, monotonicNowNs());
+    timers.shm = true;
+    const bool conn_timers = timeouts_.enabled();
+
+    while (running_)
+    {
+        // 1) 새로 붙은 세션 등록, 정리된 세션 제거
+        if (shm_changed_.exchange(false, std::memory_order_acq_rel))
+        {
+            {
+                std::lock_guard<std::mutex> lock(shm_mutex_);
+                for (auto &session : shm_pending_)
+                {
+                    epoll_event ev{};
+                    ev.data.ptr = session.get();
+                    ev.events = EPOLLIN;
+                    ::epoll_ctl(epfd, EPOLL_CTL_ADD, session->channel.toServerFd(), &ev);
+                    ev.events = EPOLLRDHUP; // 소켓은 종료만 본다 (HUP/ERR는 항상 보고됨)
+                    ::epoll_ctl(epfd, EPOLL_CTL_ADD, session->fd, &ev);
+                    // 유휴/송신 정체/하트비트 점검은 recv 스레드에서 이 스레드로 넘어온다
+                    if (conn_timers)
+                    {
+                        const int64_t now = monotonicNowNs();
+                        if (timers.last_recv_ns.try_emplace(session->client_id, now).second)
+                            scheduleConnectionCheck(timers, session->client_id, now);
+                    }
+                    sessions.push_back(std::move(session));
+                }
+                shm_pending_.clear();
+            }
+            std::erase_if(sessions, [&](const std::shared_ptr<ShmSession> &session)
+                          {
+                              if (!session->closed.load(std::memory_order_acquire))
+                                  return false;
+                              // 소켓 fd는 이미 닫혀 epoll에서 빠졌다
+                              ::epoll_ctl(epfd, EPOLL_CTL_DEL, session->channel.toServerFd(), nullptr);
+                              return true; });
+            if (retired_count_.load(std::memory_order_relaxed) > 0)
+                purgeSubscribers();
+        }
+
+        // 2) 링마다 한 번에 최대 64개씩 (한 연결이 다른 연결을 굶기지 않게)
+        bool progressed = false;
+        int64_t resume_ns = INT64_MAX; // 요청 수 제한(DELAY)으로 쉬는 세션 중 가장 먼저 다시 읽을 시각
+        const int64_t round_ns = monotonicNowNs();
+        if (conn_timers)
+            timers.wheel.advance(round_ns);
+        for (auto &session : sessions)
+        {
+            if (session->closed.load(std::memory_order_acquire))
+                continue;
+            // 응답 링이 차서 밀린 프레임: 링에 자리가 났거나(클라이언트가 깨웠거나) 새로 밀렸으면 옮긴다
+            if (session->out_pending.load(std::memory_order_acquire) && !session->channel.s2c().producerWaiting() &&
+                !flushShmOutbox(*session))
+            {
+                LOG_WARN("[TcpServer] Corrupt shm ring client_id=", session->client_id);
+                closeClient(session->client_id, session->fd, ExceptionType::SHM_CORRUPT);
+                continue;
+            }
+            if (session->paused->load(std::memory_order_acquire))
+                continue; // PAUSE: 송신 대기열이 빠질 때까지 이 연결의 요청은 읽지 않는다
+            if (session->rate)
+            {
+                const int64_t resume = session->rate->resume_ns.load(std::memory_order_relaxed);
+                if (resume > round_ns)
+                {
+                    resume_ns = std::min(resume_ns, resume);
+                    continue;
+                }
+            }
+            ShmRing &ring = session->channel.c2s();
+            int64_t last_recv_ns = 0;
+            for (int n = 0; n < 64; ++n)
+            {
+                std::string_view payload;
+                FrameStatus st = ring.peekFrame(payload, scratch);
+                if (st == FrameStatus::INCOMPLETE)
+                    break;
+                if (st == FrameStatus::INVALID_LENGTH)
+                {
+                    LOG_WARN("[TcpServer] Invalid shm frame length client_id=", session->client_id);
+                    closeClient(session->client_id, session->fd, ExceptionType::INVALID_LENGTH);
+                    break;
+                }
+                const int64_t recv_ns = monotonicNowNs();
+                const bool open = enqueueFrame(session->client_id, session->fd, 0, payload, recv_ns, stats,
+                                               std::shared_ptr<const std::atomic<bool>>(session, &session->closed),
+                                               session->rate.get(), true);
+                if (!open)
+                    break;
+                ring.consume(kFrameHeaderSize + payload.size());
+                progressed = true;
+                last_recv_ns = recv_ns;
+                if (session->rate && session->rate->resume_ns.load(std::memory_order_relaxed) > recv_ns)
+                    break;
+            }
+            if (conn_timers && last_recv_ns > 0)
+            {
+                auto st = timers.last_recv_ns.find(session->client_id);
+                if (st != timers.last_recv_ns.end())
+                    st->second = last_recv_ns;
+            }
+        }
+
+        const int64_t now = monotonicNowNs();
+        if (progressed)
+        {
+            idle_since = now;
+            continue;
+        }
+        if (now - idle_since < spin_ns)
+        {
+            cpuRelax();
+            continue;
+        }
+
+        // 3) 잠들기: 플래그를 세운 뒤에도 모든 링이 비어 있을 때만 기다린다
+        // 쉬는 세션은 다시 읽을 시각까지만, 연결 점검 타이머는 다음 기한까지만 (멈춘 세션은 링 자리가 나면 깨운다)
+        // stop()과 새 세션은 shm_wake_fd_로 깨우므로 둘 다 없으면 제한 없이 기다린다
+        bool can_sleep = true;
+        int64_t sleep_ns = resume_ns != INT64_MAX ? resume_ns - now : -1;
+        const int64_t next_timer_ns = timers.wheel.nextTimeoutNs(now);
+        if (next_timer_ns >= 0 && (sleep_ns < 0 || next_timer_ns < sleep_ns))
+            sleep_ns = next_timer_ns;
+        const int sleep_ms =
+            sleep_ns < 0 ? -1 : static_cast<int>(std::clamp<int64_t>((sleep_ns + 999999) / 1000000, 0, INT32_MAX));
+        for (auto &session : sessions)
+        {
+            if (session->paused->load(std::memory_order_acquire))
+                continue;
+            if (session->rate && session->rate->resume_ns.load(std::memory_order_relaxed) > now)
+                continue;
+            if (!session->channel.c2s().prepareSleep())
+            {
+                can_sleep = false;
+                break;
+            }
+        }
+        if (can_sleep)
+        {
+            int ready = ::epoll_wait(epfd, events.data(), static_cast<int>(events.size()), sleep_ms);
+            for (int e = 0; e < ready; ++e)
+            {
+                auto *session = static_cast<ShmSession *>(events[e].data.ptr);
+                if (!session)
+                {
+                    ShmChannel::drain(shm_wake_fd_);
+                }
+                else if (events[e].events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+                {
+                    if (!session->closed.load(std::memory_order_acquire))
+                    {
+                        LOG_INFO("[TcpServer] Client disconnected (shm) client_id=", session->client_id);
+                        closeClient(session->client_id, session->fd, ExceptionType::DISCONNECT);
+                    }
+                }
+                else
+                {
+                    ShmChannel::drain(session->channel.toServerFd());
+                }
+            }
+        }
+        for (auto &session : sessions)
+            session->channel.c2s().endSleep();
+        idle_since = monotonicNowNs();
+    }
+
+    ::close(epfd);
+}
+
+void TcpServer::sendLoop(int thread_index)
+{
+    pinThread("send", affinity_.send, thread_index);
+    SendThreadStats &stats = threadStats(send_stats_[thread_index], []
+                                         { return std::make_unique<SendThreadStats>(); });
+    std::vector<std::pair<int, int>> slow; // 락 밖에서 SLOW_CONSUMER 프로브를 부를 (client_id, fd)
+
+    while (running_)
     {
         auto msg_opt = send_queue_.pop();
         if (!msg_opt.has_value())
             break; // shutdown
 
-        Message msg = msg_opt.value();
+        Message msg = std::move(*msg_opt);
+        const int64_t dequeue_ns = monotonicNowNs();
+        stats.queue_wait.record(static_cast<uint64_t>(dequeue_ns - msg.enqueue_ns));
+        notifyDrain(); // 송신 큐가 비었을 수 있다 (아래에서 못 보낸 바이트는 outbound_bytes_가 붙잡는다)
+
+        // 헤더+본문을 한 버퍼로 만들어 한 번에 전송 (작은 쓰기 두 번이 Nagle에 걸리지 않게)
+        // 직렬화는 락 밖에서, 브로드캐스트/발행은 이미 인코딩된 공유 프레임을 그대로 쓴다
+        std::string encoded;
+        if (!msg.frame)
+            encoded = encodeFrame(msg.json);
+        const std::string &frame = msg.frame ? *msg.frame : encoded;
+        const size_t frame_bytes = frame.size(); // 대기열로 옮기면 encoded는 비므로 크기를 먼저 잡아 둔다
+
+        // 공유 메모리 연결: 앞서 밀린 프레임이 없으면 client_mutex_ 밖에서 링에 바로 쓴다
+        // (링이 찼을 때만 아래에서 outbox에 넣고, 자리가 나면 shm 스레드가 옮긴다. 송신 스레드는 기다리지 않는다)
+        std::shared_ptr<ShmSession> shm;
+        {
+            std::lock_guard<std::mutex> lock(client_mutex_);
+            auto it = clients_.find(msg.client_id);
+            if (it == clients_.end())
+                continue;
+            if (it->second.shm && it->second.outbox.empty() && it->second.shm->channel.s2c().fits(frame.size()))
+                shm = it->second.shm;
+        }
+        bool done = false;
+        if (shm)
+        {
+            ShmRing &ring = shm->channel.s2c();
+            {
+                std::lock_guard<std::mutex> lock(shm->write_mutex);
+                done = ring.tryWrite(frame);
+            }
+            if (done)
+            {
+                if (ring.consumerSleeping())
+                    ShmChannel::notify(shm->channel.toClientFd());
+                metrics_.frameOut(frame_bytes);
+                LOG_TRACE_EVENT(SEND, msg.client_id, msg.req_hash, frame_bytes);
+            }
+        }
+
+        if (!done)
+        {
+            std::lock_guard<std::mutex> lock(client_mutex_);
+            auto it = clients_.find(msg.client_id);
+            if (it == clients_.end())
+                continue;
+
+            LOG_DEBUG("[TcpServer] Sending message to client ", msg.client_id);
+            ClientConn &conn = it->second;
+            bool sent = true;
+            bool slow_consumer = false;
+            size_t written = 0;
+            if (conn.shm)
+            {
+                // 링보다 큰 프레임은 보낼 수 없고, 클라이언트가 인덱스를 망가뜨린 링에는 더 쓰지 않는다
+                std::lock_guard<std::mutex> wlock(conn.shm->write_mutex);
+                const ShmRing &ring = conn.shm->channel.s2c();
+                sent = ring.fits(frame.size()) && !ring.corrupt();
+            }
+            else if (conn.outbox.empty())
+                sent = sendSome(conn.fd, frame.data(), frame.size(), written); // 바로 보내 보고 나머지만 대기열로
+            if (sent && written < frame.size())
+            {
+                OutboundFrame out{msg.frame ? std::move(msg.frame) : std::make_shared<const std::string>(std::move(encoded)),
+                                  std::move(msg.key)};
+                const OutboundResult result = queueOutbound(msg.client_id, conn, std::move(out), written);
+                if (result == OutboundResult::DISCONNECT)
+                {
+                    LOG_WARN("[TcpServer] Slow consumer client ", msg.client_id, ": ", conn.out_bytes,
+                             " bytes queued, closing");
+                    metrics_.slowConsumerDisconnect();
+                    slow.push_back({msg.client_id, conn.fd});
+                    sent = false;
+                    slow_consumer = true;
+                }
+                else
+                {
+                    if (result == OutboundResult::OVER_LIMIT)
+                        slow.push_back({msg.client_id, conn.fd});
+                    if (conn.shm)
+                    {
+                        if (!conn.shm->out_pending.exchange(true, std::memory_order_acq_rel))
+                            ShmChannel::notify(shm_wake_fd_);
+                    }
+                    else if (!conn.out_armed && !conn.outbox.empty())
+                    {
+                        armWritable(msg.client_id, conn);
+                    }
+                }
+            }
+            if (!sent)
+            {
+                if (!slow_consumer)
+                    LOG_WARN("[TcpServer] Failed to send to client ", msg.client_id, ", closing");
+                LOG_TRACE_EVENT(SEND_FAILED, msg.client_id, msg.req_hash, frame_bytes);
+                dropClientLocked(it);
+            }
+            else
+            {
+                it->second.last_send_ns = dequeue_ns;
+                metrics_.frameOut(frame_bytes);
+                LOG_TRACE_EVENT(SEND, msg.client_id, msg.req_hash, frame_bytes);
+            }
+        }
+
+        for (auto [client_id, fd] : slow)
+            exception_probe_(client_id, fd, ExceptionType::SLOW_CONSUMER);
+        slow.clear();
+        stats.send.record(static_cast<uint64_t>(monotonicNowNs() - dequeue_ns));
+    }
+}
+
+bool TcpServer::overOutboundLimit(const ClientConn &conn) const
+{
+    return conn.out_bytes > outbound_limits_.max_bytes || conn.outbox.size() > outbound_limits_.max_messages;
+}
+
+TcpServer::OutboundResult TcpServer::queueOutbound(int client_id, ClientConn &conn, OutboundFrame frame, size_t already_sent)
+{
+    const SlowConsumerPolicy policy = outbound_limits_.policy;
+
+    // 같은 key의 대기 프레임이 있으면 그 자리를 최신 값으로 바꾼다 (보내는 중인 맨 앞 프레임은 제외)
+    if (policy == SlowConsumerPolicy::COALESCE && frame.key && already_sent == 0)
+    {
+        for (size_t i = conn.out_off > 0 ? 1 : 0; i < conn.outbox.size(); ++i)
+        {
+            OutboundFrame &queued = conn.outbox[i];
+            if (queued.key != frame.key && (!queued.key || *queued.key != *frame.key))
+                continue;
+            const int64_t delta = static_cast<int64_t>(frame.frame->size()) - static_cast<int64_t>(queued.frame->size());
+            conn.out_bytes = static_cast<size_t>(static_cast<int64_t>(conn.out_bytes) + delta);
+            outbound_bytes_.fetch_add(delta, std::memory_order_relaxed);
+            queued.frame = std::move(frame.frame);
+            metrics_.outboundCoalesced();
+            return overOutboundLimit(conn) ? OutboundResult::DISCONNECT : OutboundResult::QUEUED;
+        }
+    }
+
+    const size_t remaining = frame.frame->size() - already_sent;
+    if (conn.outbox.empty())
+        conn.out_progress_ns = monotonicNowNs();
+    if (already_sent > 0)
+        conn.out_off = already_sent; // outbox가 비어 있을 때만 부분 전송이 생기므로 맨 앞 프레임
+    conn.outbox.push_back(std::move(frame));
+    conn.out_bytes += remaining;
+    outbound_bytes_.fetch_add(static_cast<int64_t>(remaining), std::memory_order_relaxed);
+
+    if (!overOutboundLimit(conn))
+        return OutboundResult::QUEUED;
+    const bool first = !conn.over_limit;
+    conn.over_limit = true;
+
+    switch (policy)
+    {
+    case SlowConsumerPolicy::DROP_OLDEST:
+        // 보내는 중인 맨 앞 프레임은 잘라낼 수 없으므로 그 다음부터 버린다
+        while (overOutboundLimit(conn))
+        {
+            const size_t victim = conn.out_off > 0 ? 1 : 0;
+            if (victim >= conn.outbox.size())
+                break;
+            const size_t bytes = conn.outbox[victim].frame->size() - (victim == 0 ? conn.out_off : 0);
+            conn.outbox.erase(conn.outbox.begin() + static_cast<std::ptrdiff_t>(victim));
+            conn.out_bytes -= bytes;
+            releaseOutbound(static_cast<int64_t>(bytes));
+            metrics_.outboundDropped();
+        }
+        break;
+    case SlowConsumerPolicy::PAUSE:
+        // 메모리는 생산자가 멈추는 것으로 묶는다. 이미 받은 요청의 응답은 한도를 넘어도 넣는다
+        if (!conn.paused)
+        {
+            conn.paused = true;
+            conn.read_paused->store(true, std::memory_order_release);
+            paused_clients_[client_id] = monotonicNowNs();
+            paused_count_.store(paused_clients_.size(), std::memory_order_relaxed);
+            metrics_.slowConsumerPause();
+        }
+        break;
+    case SlowConsumerPolicy::DISCONNECT:
+    case SlowConsumerPolicy::COALESCE:
+        return OutboundResult::DISCONNECT;
+    }
+    return first ? OutboundResult::OVER_LIMIT : OutboundResult::QUEUED;
+}
+
+bool TcpServer::flushOutbound(ClientConn &conn)
+{
+    // 대기 프레임을 writev 한 번에 최대 64개씩 보낸다
+    constexpr size_t kMaxIov = 64;
+    iovec iov[kMaxIov];
+    while (!conn.outbox.empty())
+    {
+        size_t n = 0;
+        for (auto it = conn.outbox.begin(); it != conn.outbox.end() && n < kMaxIov; ++it, ++n)
+        {
+            const size_t skip = n == 0 ? conn.out_off : 0;
+            iov[n].iov_base = const_cast<char *>(it->frame->data() + skip);
+            iov[n].iov_len = it->frame->size() - skip;
+        }
+        msghdr mh{};
+        mh.msg_iov = iov;
+        mh.msg_iovlen = n;
+        ssize_t s = ::sendmsg(conn.fd, &mh, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (s < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+
+        size_t left = static_cast<size_t>(s);
+        conn.out_bytes -= left;
+        if (left > 0)
+            conn.out_progress_ns = monotonicNowNs();
+        releaseOutbound(s);
+        while (left > 0)
+        {
+            const size_t front_left = conn.outbox.front().frame->size() - conn.out_off;
+            if (left < front_left)
+            {
+                conn.out_off += left;
+                break;
+            }
+            left -= front_left;
+            conn.outbox.pop_front();
+            conn.out_off = 0;
+        }
+    }
+    return true;
+}
+
+void TcpServer::armWritable(int client_id, ClientConn &conn)
+{
+    epoll_event ev{};
+    ev.events = EPOLLOUT | EPOLLONESHOT;
+    ev.data.u64 = static_cast<uint64_t>(client_id);
+    if (::epoll_ctl(flush_epoll_fd_, EPOLL_CTL_MOD, conn.fd, &ev) < 0 && errno == ENOENT)
+        ::epoll_ctl(flush_epoll_fd_, EPOLL_CTL_ADD, conn.fd, &ev);
+    conn.out_armed = true;
+}
+
+// PAUSE는 한도의 절반 아래로 빠지면 푼다 (경계에서 멈춤/재개가 반복되지 않게)
+// client_mutex_를 잡은 상태에서 호출. 풀었으면 true (호출자가 생산자와 읽기 스레드를 깨운다)
+bool TcpServer::resumeIfDrained(int client_id, ClientConn &conn)
+{
+    if (!conn.paused || conn.out_bytes > outbound_limits_.max_bytes / 2 ||
+        conn.outbox.size() > outbound_limits_.max_messages / 2)
+        return false;
+    conn.paused = false;
+    conn.read_paused->store(false, std::memory_order_release);
+    paused_clients_.erase(client_id);
+    paused_count_.store(paused_clients_.size(), std::memory_order_relaxed);
+    return true;
+}
+
+// 대기열이 남은 소켓이 쓰기 가능해지면 마저 보낸다 (EPOLLONESHOT, 남으면 다시 등록)
+void TcpServer::flushLoop()
+{
+    std::vector<epoll_event> events(256);
+    while (running_)
+    {
+        int ready = ::epoll_wait(flush_epoll_fd_, events.data(), static_cast<int>(events.size()), -1);
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
 
         std::lock_guard<std::mutex> lock(client_mutex_);
-        auto it = clients_.find(msg.client_id);
-        if (it == clients_.end())
-            continue;
+        bool resumed = false;
+        for (int e = 0; e < ready; ++e)
+        {
+            if (events[e].data.u64 == kFlushWakeId)
+            {
+                ShmChannel::drain(flush_wake_fd_);
+                continue;
+            }
+            const int client_id = static_cast<int>(events[e].data.u64);
+            auto it = clients_.find(client_id);
+            if (it == clients_.end())
+                continue;
+
+            ClientConn &conn = it->second;
+            conn.out_armed = false;
+            if (!flushOutbound(conn))
+            {
+                LOG_WARN("[TcpServer] Failed to send to client ", client_id, ", closing");
+                dropClientLocked(it);
+                continue;
+            }
+            if (!conn.outbox.empty())
+                armWritable(client_id, conn);
+            else
+                conn.over_limit = false;
+            resumed |= resumeIfDrained(client_id, conn);
+        }
+        if (resumed)
+        {
+            outbound_cv_.notify_all();
+            for (int i = 0; i < static_cast<int>(recv_wake_fds_.size()); ++i)
+                wakeRecvThread(i); // PAUSE가 풀린 연결을 다음 poll 제한 시간까지 기다리지 않고 다시 읽는다
+        }
+    }
+}
+
+std::vector<int> TcpServer::waitForOutboundRoom(const std::vector<int> &client_ids)
+{
+    std::vector<int> skipped;
+    if (outbound_limits_.policy != SlowConsumerPolicy::PAUSE || paused_count_.load(std::memory_order_relaxed) == 0)
+        return skipped;
 
-        LOG_DEBUG("[TcpServer] Sending message to client ", msg.client_id);
-        int fd = it->second;
-        std::string data = msg.json.dump();
+    std::vector<std::pair<int, int>> slow;
+    {
+        std::unique_lock<std::mutex> lock(client_mutex_);
+        // 멈춘 연결은 보통 몇 개뿐이므로 대상 전체가 아니라 멈춘 쪽을 돌며 대상인지 본다
+        auto pausedTargets = [&]
+        {
+            std::vector<int> targets;
+            for (const auto &[client_id, paused_ns] : paused_clients_)
+            {
+                if (std::binary_search(client_ids.begin(), client_ids.end(), client_id))
+                    targets.push_back(client_id);
+            }
+            return targets;
+        };
+        std::vector<int> targets = pausedTargets();
+        if (targets.empty())
+            return skipped;
 
-        uint32_t len = htonl(data.size());
-        if (!sendAll(fd, &len, sizeof(len)) || !sendAll(fd, data.data(), data.size()))
+        int64_t expired_before = monotonicNowNs() - static_cast<int64_t>(outbound_limits_.pause_timeout_ms) * 1000000;
+        if (!t_process_thread)
         {
-            LOG_WARN("[TcpServer] Failed to send to client ", msg.client_id, ", closing");
-            ::close(fd);
-            clients_.erase(it);
+            // 핸들러 밖의 생산자는 풀릴 때까지 기다린다
+            if (outbound_cv_.wait_for(lock, std::chrono::milliseconds(outbound_limits_.pause_timeout_ms),
+                                      [&]
+                                      { return !running_ || (targets = pausedTargets()).empty(); }))
+                return skipped;
+            expired_before = INT64_MAX;
+        }
+
+        // 시간 안에 풀리지 않은 연결은 끊는다 (다른 구독자까지 계속 묶어 두지 않게)
+        // 처리 스레드는 기다리지 않으므로 아직 시간이 남은 연결은 이번 프레임만 버린다
+        for (int client_id : targets)
+        {
+            auto paused = paused_clients_.find(client_id);
+            if (paused == paused_clients_.end())
+                continue;
+            if (paused->second > expired_before)
+            {
+                skipped.push_back(client_id);
+                metrics_.outboundDropped();
+                continue;
+            }
+            auto it = clients_.find(client_id);
+            if (it == clients_.end())
+                continue;
+            LOG_WARN("[TcpServer] Slow consumer client ", client_id, " stayed paused for ",
+                     outbound_limits_.pause_timeout_ms, "ms, closing");
+            slow.push_back({client_id, it->second.fd});
+            skipped.push_back(client_id);
+            metrics_.slowConsumerDisconnect();
+            dropClientLocked(it);
         }
     }
+    for (auto [client_id, fd] : slow)
+        exception_probe_(client_id, fd, ExceptionType::SLOW_CONSUMER);
+    std::sort(skipped.begin(), skipped.end());
+    return skipped;
 }
 
 void TcpServer::sendToClient(int client_id, const nlohmann::json &json)
 {
-    send_queue_.push({client_id, json});
+    if (!waitForOutboundRoom({client_id}).empty())
+        return; // 핸들러 안에서 멈춘 연결로 보냈거나 그래서 끊었다: 버린다
+    const int64_t now = monotonicNowNs();
+    send_queue_.push({client_id, json, 0, now, now});
+}
+
+size_t TcpServer::handlerTypeIndex(const nlohmann::json &req) const
+{
+    if (req.is_object())
+    {
+        auto t = req.find("type");
+        if (t != req.end() && t->is_string())
+        {
+            auto it = handler_type_index_.find(t->get_ref<const std::string &>());
+            if (it != handler_type_index_.end())
+                return it->second;
+        }
+    }
+    return handler_types_.size(); // "_unknown"
+}
+
+TcpServer::StageSnapshots TcpServer::collectStages() const
+{
+    StageSnapshots out;
+    out.handler.resize(handler_types_.size() + 1);
+
+    for (auto &rs : recv_stats_)
+        out.recv_to_enqueue.merge(rs->recv_to_enqueue);
+    if (shm_stats_)
+        out.recv_to_enqueue.merge(shm_stats_->recv_to_enqueue);
+    for (auto &ps : process_stats_)
+    {
+        out.recv_queue_wait.merge(ps->queue_wait);
+        for (size_t t = 0; t < ps->handler.size(); ++t)
+            out.handler[t].merge(*ps->handler[t]);
+    }
+    for (auto &ss : send_stats_)
+    {
+        out.send_queue_wait.merge(ss->queue_wait);
+        out.send.merge(ss->send);
+    }
+    return out;
+}
+
+std::string TcpServer::handlerTypeName(size_t slot) const
+{
+    return slot < handler_types_.size() ? handler_types_[slot] : std::string("_unknown");
+}
+
+TcpServerStats TcpServer::stats() const
+{
+    StageSnapshots stages = collectStages();
+
+    TcpServerStats out;
+    out.recv_to_enqueue = stages.recv_to_enqueue.summary();
+    out.recv_queue_wait = stages.recv_queue_wait.summary();
+    for (size_t t = 0; t < stages.handler.size(); ++t)
+    {
+        if (stages.handler[t].count() > 0)
+            out.handler[handlerTypeName(t)] = stages.handler[t].summary();
+    }
+    out.send_queue_wait = stages.send_queue_wait.summary();
+    out.send = stages.send.summary();
+    out.process_threads = process_active_.load(std::memory_order_relaxed);
+    return out;
 }
 
-void TcpServer::processLoop()
+nlohmann::json TcpServer::dispatchMessage(const Message &msg, ProcessThreadStats &stats)
 {
+    const int64_t begin_ns = monotonicNowNs();
+    if (msg.cancel.expired(begin_ns))
+    {
+        // 클라이언트가 이미 포기한 요청: 핸들러를 부르지 않고 바로 에러로 (과부하 때 일을 더 키우지 않는다)
+        metrics_.error(ErrorReason::DEADLINE_EXCEEDED);
+        return Dispatcher::makeError(msg.json, errorReasonName(ErrorReason::DEADLINE_EXCEEDED));
+    }
+    LOG_TRACE_EVENT(DISPATCH_BEGIN, msg.client_id, msg.req_hash);
+    ErrorReason error = ErrorReason::NONE;
+    nlohmann::json response = dispatcher_.dispatch(msg, &error);
+    const size_t type_slot = handlerTypeIndex(msg.json);
+    stats.handler[type_slot]->record(static_cast<uint64_t>(monotonicNowNs() - begin_ns));
+    metrics_.message(type_slot);
+    metrics_.error(error);
+    LOG_TRACE_EVENT(DISPATCH_END, msg.client_id, msg.req_hash, responseOk(response) ? 1 : 0);
+    return response;
+}
+
+void TcpServer::processLoop(int thread_index)
+{
+    pinThread("process", affinity_.process, thread_index);
+    t_process_thread = true;
+    ProcessThreadStats &stats = threadStats(process_stats_[thread_index], [this]
+                                            { return newProcessStats(); });
+    const bool elastic = pool_max_ > pool_min_;
+    const auto shrink_idle = std::chrono::milliseconds(pool_limits_.shrink_idle_ms);
+
     while (running_)
     {
-        auto msg_opt = recv_queue_.pop();
-        if (!msg_opt.has_value())
-            break; // shutdown
+        // 최소 수보다 많으면 유휴 제한 시간을 두고 기다렸다가, 그동안 일이 없으면 이 스레드를 줄인다
+        std::optional<Message> msg_opt;
+        if (elastic && process_active_.load(std::memory_order_relaxed) > pool_min_)
+        {
+            msg_opt = recv_queue_.pop_for(shrink_idle);
+            if (!msg_opt.has_value())
+            {
+                if (running_ && !retireProcessThread(thread_index))
+                    continue;
+                break; // 줄였거나 shutdown
+            }
+        }
+        else
+        {
+            msg_opt = recv_queue_.pop();
+            if (!msg_opt.has_value())
+                break; // shutdown
+        }
 
-        Message msg = msg_opt.value();
+        Message msg = std::move(*msg_opt);
+        const int64_t dequeue_ns = monotonicNowNs();
+        stats.queue_wait.record(static_cast<uint64_t>(dequeue_ns - msg.enqueue_ns));
+        if (elastic)
+            maybeGrowProcessPool(dequeue_ns, dequeue_ns - msg.enqueue_ns);
+        if (admission_.enabled())
+            admission_.observe(dequeue_ns - msg.enqueue_ns, dequeue_ns);
 
-        // 종료용
-        if (msg.json.contains("type") && msg.json["type"] == "_quit")
+        // 기다리는 동안 연결이 끊겼으면 응답을 받을 곳이 없다
+        if (msg.cancel.disconnected())
+        {
+            metrics_.abandoned(msg.json.is_array() ? msg.json.size() : 1);
+            if (in_flight_.fetch_sub(1) == 1)
+                notifyDrain();
             continue;
+        }
         LOG_DEBUG("[TcpServer] Processing message from client ", msg.client_id);
-        // 디스패치
-        nlohmann::json response = dispatcher_.dispatch(msg);
+        nlohmann::json response;
+        if (msg.json.is_array())
+        {
+            // 배치 프레임: 요소마다 디스패치하고 응답은 같은 순서의 배열 하나로 돌려준다 (프레임/큐 이동은 한 번)
+            // 기한은 요소마다 따로 본다
+            metrics_.batch(msg.json.size());
+            response = nlohmann::json::array();
+            response.get_ref<nlohmann::json::array_t &>().reserve(msg.json.size());
+            for (nlohmann::json &item : msg.json)
+            {
+                Message one{msg.client_id, std::move(item), 0, msg.recv_ns, msg.enqueue_ns, msg.local_port};
+                one.cancel.closed = msg.cancel.closed;
+                one.cancel.deadline_ns = requestDeadlineNs(one.json, msg.recv_ns);
+                if (Logger::instance().traceEnabled())
+                    one.req_hash = TraceLog::hashReqId(one.json);
+                response.push_back(dispatchMessage(one, stats));
+            }
+        }
+        else
+        {
+            msg.cancel.deadline_ns = requestDeadlineNs(msg.json, msg.recv_ns);
+            response = dispatchMessage(msg, stats);
+        }
+        const int64_t done_ns = monotonicNowNs();
 
         // 응답 송신 큐로
-        send_queue_.push({msg.client_id, response});
+        send_queue_.push({msg.client_id, std::move(response), msg.req_hash, msg.recv_ns, done_ns, msg.local_port});
+        if (in_flight_.fetch_sub(1) == 1)
+            notifyDrain();
     }
 }
 
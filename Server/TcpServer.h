@@ -1,7 +1,14 @@
 #pragma once
 #include <thread>
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <atomic>
+#include <latch>
 #include <netinet/in.h>
 #include <unistd.h>
 
@@ -11,6 +18,14 @@
 #include "Dispatcher.h"
 #include "ExampleMessageHandler.h"
 #include "Logger.h"
+#include "LatencyHistogram.h"
+#include "ServerMetrics.h"
+#include "ShmTransport.h"
+#include "SocketAddress.h"
+#include "TimerWheel.h"
+#include "AdmissionControl.h"
+#include "CpuAffinity.h"
+#include "RateLimit.h"
 
  namespace msgnet 
  { 
@@ -24,9 +39,33 @@ struct TcpServerConfig
     int process_thread_count;
     int send_thread_count;
     LogLevel log_level;
+    std::vector<int> listen_ports; // 리스너가 여러 개일 때 전체 포트 (port는 첫 번째)
 
 };
 
+// 리스닝 주소
+// - unix_path가 비어 있으면 IPv4 TCP (host가 비어 있거나 "0.0.0.0"이면 모든 인터페이스)
+// - unix_path가 있으면 AF_UNIX stream ("@name"은 abstract namespace). 프레임/핸들러는 TCP와 동일
+struct ListenAddress
+{
+    std::string host = "0.0.0.0";
+    int port = 0;
+    std::string unix_path;
+
+    bool isUnix() const { return !unix_path.empty(); }
+};
+
+// 파이프라인 단계별 지연 통계 (스레드별 히스토그램을 읽을 때 합산)
+struct TcpServerStats
+{
+    LatencySummary recv_to_enqueue;                // 읽기 가능 감지 ~ recv_queue_ 투입 (수신 + 파싱)
+    LatencySummary recv_queue_wait;                // recv_queue_ 대기
+    std::map<std::string, LatencySummary> handler; // 메시지 타입별 핸들러 실행 ("_unknown": 타입 없음/미등록)
+    LatencySummary send_queue_wait;                // send_queue_ 대기
+    LatencySummary send;                           // 직렬화 + 전송
+    int process_threads = 0;                       // 지금 도는 처리 스레드 수 (ProcessPoolLimits로 자동 조절하면 바뀐다)
+};
+
 enum class ExceptionType
     {
         SOCKET_CREATION_FAILED,
@@ -34,21 +73,198 @@ enum class ExceptionType
         LISTEN_FAILED,
         DISCONNECT,
         INVALID_LENGTH,
+        SLOW_CONSUMER, // 송신 대기열이 한도를 넘음 (넘어설 때 한 번, 그 때문에 끊을 때 한 번)
+        IDLE_TIMEOUT,  // idle_timeout_ms 동안 받은 프레임이 없어서 끊음
+        WRITE_STALL,   // 송신 대기열이 write_stall_timeout_ms 동안 줄지 않아서 끊음
+        RATE_LIMITED,  // 요청 수 제한을 넘어서 끊음 (RateLimitAction::DISCONNECT)
+        SHM_CORRUPT,   // 공유 메모리 링의 head/tail이 말이 안 됨 (클라이언트가 잘못 씀)
     };
 
+// 연결 타이머. recv 스레드마다 타이머 휠 하나를 두고, 연결마다 타이머 하나를 가장 가까운 기한에 다시 건다
+struct ConnectionTimeouts
+{
+    int idle_timeout_ms = 0;            // 이만큼 받은 프레임이 없으면 끊는다 (0: 끔). 죽은 half-open 연결 정리용
+    int heartbeat_interval_ms = 0;      // 이만큼 보낸 프레임이 없으면 {"type":"heartbeat"} 푸시 (0: 끔)
+    int write_stall_timeout_ms = 30000; // 송신 대기열이 이만큼 한 바이트도 줄지 않으면 끊는다 (0: 끔)
+
+    bool enabled() const
+    {
+        return idle_timeout_ms > 0 || heartbeat_interval_ms > 0 || write_stall_timeout_ms > 0;
+    }
+};
+
+// 송신 대기열이 한도를 넘은 연결(느린 수신자) 처리
+enum class SlowConsumerPolicy
+{
+    DISCONNECT,  // 연결을 끊는다
+    DROP_OLDEST, // 가장 오래된 대기 프레임부터 버린다
+    COALESCE,    // 같은 key(발행 topic)의 대기 프레임을 최신 값으로 바꾼다. 그래도 넘치면 끊는다
+    PAUSE,       // 그 연결에서 읽기를 멈추고 broadcast/publish/sendToClient 호출자를 기다리게 한다
+                 // (메시지 핸들러 안에서 부른 경우는 기다리지 않고 멈춘 연결 몫의 프레임을 버린다)
+};
+
+inline bool parseSlowConsumerPolicy(const std::string &name, SlowConsumerPolicy &out)
+{
+    if (name == "disconnect")
+        out = SlowConsumerPolicy::DISCONNECT;
+    else if (name == "drop_oldest")
+        out = SlowConsumerPolicy::DROP_OLDEST;
+    else if (name == "coalesce")
+        out = SlowConsumerPolicy::COALESCE;
+    else if (name == "pause")
+        out = SlowConsumerPolicy::PAUSE;
+    else
+        return false;
+    return true;
+}
+
+// 연결별 송신 대기열 한도 (소켓이 바로 받지 못한 프레임이 쌓이는 곳)
+struct OutboundLimits
+{
+    size_t max_bytes = 16 * 1024 * 1024;
+    size_t max_messages = 65536;
+    SlowConsumerPolicy policy = SlowConsumerPolicy::DISCONNECT;
+    int pause_timeout_ms = 5000; // PAUSE: 생산자가 이만큼 기다려도(핸들러 안이면 이만큼 멈춰 있어도) 자리가 안 나면 그 연결을 끊는다
+};
+
+// 처리 스레드 수 자동 조절 (max_threads가 min_threads보다 크면 켜진다)
+// - 늘리기: recv_queue_ 대기(꺼낸 요청 또는 맨 앞 요청)가 grow_wait_ms 이상이거나 큐 깊이가 grow_depth 이상이면
+//   하나씩 늘린다. 요청을 넣을 때도 보므로 처리 스레드가 모두 핸들러에 묶여 있어도 늘어난다
+//   새 스레드가 효과를 낼 시간을 주려고 grow_interval_ms 안에는 다시 늘리지 않는다
+// - 줄이기: min_threads보다 많을 때 shrink_idle_ms 동안 요청을 하나도 못 받은 스레드가 스스로 끝난다
+// 늘리는 기준(대기 수 ms)과 줄이는 기준(긴 완전 유휴)이 멀리 떨어져 있어 경계 부하에서 늘었다 줄었다 하지 않는다
+struct ProcessPoolLimits
+{
+    int min_threads = 0; // 0이면 setProcessThreadCount 값
+    int max_threads = 0; // min_threads 이하면 고정 크기
+    int grow_wait_ms = 10;
+    size_t grow_depth = 0; // 0: 깊이는 보지 않는다
+    int grow_interval_ms = 100;
+    int shrink_idle_ms = 30000;
+};
+
 class TcpServer
 {
 public:
     
     
-    explicit TcpServer(int port);
+    TcpServer() = default;          // 리스너 없이 생성 (addListenAddress로 추가)
+    explicit TcpServer(int port);   // 0.0.0.0:port 리스너 하나
     ~TcpServer();
 
-    void start();
+    // 추가 리스너 (start() 전에 호출). 모든 리스너가 accept/recv/process/send 스레드와 dispatcher를 공유한다
+    void addListenAddress(const std::string &host, int port)
+    {
+        listen_addresses_.push_back({host, port, ""});
+    }
+
+    // AF_UNIX 리스너 ("@name"이면 abstract namespace). 파일 경로는 start()에서 기존 파일을 지우고 stop()에서 정리한다
+    void addListenUnixPath(const std::string &path)
+    {
+        ListenAddress la;
+        la.host.clear();
+        la.unix_path = path;
+        listen_addresses_.push_back(std::move(la));
+    }
+
+    // [first_port, last_port] 범위를 한꺼번에 추가 (run_multi.sh가 프로세스마다 띄우던 포트들)
+    void addListenPortRange(int first_port, int last_port, const std::string &host = "0.0.0.0")
+    {
+        for (int p = first_port; p <= last_port; ++p)
+            listen_addresses_.push_back({host, p, ""});
+    }
+
+    // 소켓 생성/bind/listen에 실패하면 false (스레드는 시작하지 않음)
+    bool start();
+    // 바로 멈춘다. 큐에 남은 요청/응답은 버려진다
     void stop();
 
+    // 우아한 종료: 새 접속을 멈추고 모든 연결에 {"type":"goaway"}를 보낸 뒤, 이미 받은 요청을 처리해
+    // 응답까지 내보내고 stop()한다. 큐/처리 중/송신 대기열이 비고 연결이 모두 닫히거나 조용해지면 끝
+    // timeout_ms 안에 못 끝내면 그대로 stop()하고 false
+    bool drain(int timeout_ms);
+
+    // 무중단 재시작 (start() 전에 설정). path는 AF_UNIX 경로 ("@name"은 abstract namespace)
+    // - setHandoffPath: 새 프로세스가 이 경로로 접속하면 리스너 fd를 SCM_RIGHTS로 넘긴다 (이후 handedOff())
+    // - setInheritFrom: start()에서 이전 프로세스에게서 리스너를 받아, 같은 주소는 bind 대신 그 fd를 쓴다
+    // 같은 커널 accept 큐를 이어받으므로 재시작 중에도 접속이 거부되지 않는다
+    void setHandoffPath(const std::string &path)
+    {
+        handoff_path_ = path;
+    }
+
+    void setInheritFrom(const std::string &path)
+    {
+        inherit_from_ = path;
+    }
+
+    // 리스너를 새 프로세스에 넘겼다. 이 프로세스는 drain()으로 마무리하면 된다
+    bool handedOff() const
+    {
+        return handed_off_.load(std::memory_order_acquire);
+    }
+
+    // 리스너를 넘긴 직후 handoff 스레드에서 호출 (메인 스레드를 깨워 drain()으로 넘어가게 할 때)
+    void setHandoffProbe(std::function<void()> probe)
+    {
+        handoff_probe_ = std::move(probe);
+    }
+
+    // 실제 리스닝 포트 (port 0으로 만들면 start() 이후 커널이 고른 임시 포트). 리스너가 여러 개면 첫 번째
+    int port() const
+    {
+        if (!listeners_.empty())
+            return listeners_.front().address.port;
+        return listen_addresses_.empty() ? 0 : listen_addresses_.front().port;
+    }
+
+    // start() 이후 리스너별 실제 포트 (추가한 순서, AF_UNIX 리스너는 0)
+    std::vector<int> listenPorts() const
+    {
+        std::vector<int> ports;
+        for (const Listener &l : listeners_)
+            ports.push_back(l.address.port);
+        return ports;
+    }
+
     void sendToClient(int client_id, const nlohmann::json &json);
 
+    // 연결된 모든 클라이언트에게 보낸다. 반환값은 송신 큐에 넣은 연결 수
+    size_t broadcast(const nlohmann::json &json);
+
+    // topic 구독 (내장 메시지 "subscribe"/"unsubscribe"도 이 함수를 쓴다). 반환값은 변경 후 구독자 수
+    // 연결이 끊기면 그 연결의 구독은 모두 정리된다 (recv/shm 스레드가 끊긴 연결을 모아서 한 번에)
+    size_t subscribe(int client_id, const std::string &topic);
+    size_t unsubscribe(int client_id, const std::string &topic);
+
+    // topic 구독자에게 보낸다. 구독 목록은 바뀐 직후에만 락을 잡아 스레드별 스냅샷으로 읽고, json은 한 번만 직렬화해서
+    // 모든 구독자가 같은 프레임 버퍼를 공유한다. 반환값은 송신 큐에 넣은 연결 수
+    size_t publish(const std::string &topic, const nlohmann::json &json);
+
+    // 클라이언트가 보내는 내장 메시지 "publish"를 받을지 (start() 전에 설정, 기본 꺼짐)
+    // 켜면 어느 클라이언트든 아무 topic의 구독자에게 푸시할 수 있다. 서버 쪽 publish()는 이와 상관없다
+    void setClientPublishEnabled(bool enabled)
+    {
+        client_publish_ = enabled;
+    }
+
+    // 단계별 지연 백분위 (실행 중 언제든 호출 가능, 락 없이 스레드별 히스토그램을 합산)
+    TcpServerStats stats() const;
+
+    // 카운터/게이지/히스토그램을 Prometheus text format(0.0.4)으로 렌더링 (client_mutex_ 미사용)
+    std::string metricsText() const;
+
+    // 관리용 메트릭 리스너 (GET /metrics). start() 전에 설정, 둘 다 지정하면 둘 다 연다.
+    void setAdminPort(int port)
+    {
+        admin_port_ = port;
+    }
+
+    void setAdminUnixPath(const std::string &path)
+    {
+        admin_unix_path_ = path;
+    }
+
     void addMessageHandler(const std::string &type, Dispatcher::MessageHandler handler)
     {
         dispatcher_.registerMessageHandler(type, std::move(handler));
@@ -64,11 +280,71 @@ public:
         process_thread_count_ = count;
     }
 
+    // 처리 스레드 수 자동 조절 (start() 전에 설정). 지금 크기는 stats().process_threads와 msgnet_process_threads
+    void setProcessPoolLimits(const ProcessPoolLimits &limits)
+    {
+        pool_limits_ = limits;
+    }
+
     void setRecvThreadCount(int count)
     {
         recv_thread_count_ = count;
     }
 
+    void setSendThreadCount(int count)
+    {
+        send_thread_count_ = count;
+    }
+
+    // 느린 수신자 정책 (start() 전에 설정). 송신 스레드는 소켓에 non-blocking으로만 쓰고,
+    // 못 보낸 프레임은 연결별 대기열에 두었다가 소켓이 쓰기 가능해지면 flush 스레드가 보낸다
+    void setOutboundLimits(const OutboundLimits &limits)
+    {
+        outbound_limits_ = limits;
+    }
+
+    // 유휴/하트비트/송신 정체 타이머 (start() 전에 설정). 클라이언트가 보내는 {"type":"heartbeat"}는
+    // 수신 시각만 갱신하고 디스패치하지 않는다 (AsyncClient는 서버 하트비트에 자동으로 답한다)
+    void setConnectionTimeouts(const ConnectionTimeouts &timeouts)
+    {
+        timeouts_ = timeouts;
+    }
+
+    // recv_queue_ 입장 제어 (start() 전에 설정). 큐 대기가 target을 넘는 상태가 interval 동안 이어지면
+    // "priority":"high"가 아닌 새 요청을 recv 스레드에서 바로 {"ok":false,"reason":"overloaded"}로 돌려보낸다
+    void setAdmissionControl(const AdmissionConfig &config)
+    {
+        admission_.configure(config);
+    }
+
+    // 연결별/메시지 type별 요청 수 제한 (start() 전에 설정). 한 클라이언트가 처리 스레드를 독차지하지 못하게
+    // recv 스레드가 큐에 넣기 전에 확인한다
+    void setRateLimits(const RateLimits &limits)
+    {
+        rate_limits_ = limits;
+    }
+
+    // 스레드 역할별 CPU 고정과 SO_INCOMING_CPU 연결 배정 (start() 전에 설정)
+    // 각 스레드는 자기 코어에 고정한 뒤 스레드 전용 버퍼를 만들어 그 NUMA 노드 메모리를 쓴다
+    void setCpuAffinity(const CpuAffinity &affinity)
+    {
+        affinity_ = affinity;
+    }
+
+    // 공유 메모리 링이 비었을 때 잠들기 전에 바쁜 대기할 시간 (0이면 바로 eventfd로 잠든다)
+    // 짧은 왕복 지연이 필요하면 늘리고, 그 대신 shm 스레드가 그만큼 CPU를 쓴다
+    void setShmSpinMicros(int us)
+    {
+        shm_spin_us_ = us;
+    }
+
+    // 공유 메모리 링 크기 (방향별, 2의 거듭제곱, 64KB 이상. 연결마다 2배가 상주한다)
+    // 이보다 큰 프레임은 공유 메모리로 주고받을 수 없다 (최대 프레임을 쓰려면 8MB)
+    void setShmRingBytes(size_t bytes)
+    {
+        shm_ring_bytes_ = bytes;
+    }
+
     void setLogLevel(LogLevel level)
     {
         Logger::instance().setLevel(level);
@@ -90,17 +366,260 @@ public:
     }
 
 private:
-    void acceptLoop();
+    struct Listener
+    {
+        int fd = -1;
+        ListenAddress address; // port는 bind 후 실제 값
+    };
+
+    // 공유 메모리 전송으로 전환한 연결 (ClientConn과 shm 스레드가 함께 들고 있음)
+    struct ShmSession
+    {
+        int client_id = 0;
+        int fd = -1; // 상대 종료 감지용 유닉스 소켓
+        ShmChannel channel;
+        std::atomic<bool> closed{false}; // 연결이 정리됨. shm 스레드가 보고 목록에서 뺀다
+        std::shared_ptr<RateState> rate; // ClientConn::rate와 같은 상태
+        // s2c 링의 생산자 (send 스레드들과 shm 스레드). client_mutex_ 없이 잡으므로 링 쓰기가 다른 연결을 막지 않는다
+        // 락 순서: client_mutex_ -> write_mutex
+        std::mutex write_mutex;
+        // 링이 차서 ClientConn::outbox에 남은 프레임이 있음. shm 스레드가 링에 자리가 나면 옮긴다
+        std::atomic<bool> out_pending{false};
+        std::shared_ptr<const std::atomic<bool>> paused; // ClientConn::read_paused (shm 스레드가 보고 이 링을 읽지 않는다)
+    };
+
+    // 송신 대기 프레임 (key: COALESCE 정책에서 같은 key끼리 최신 값만 남긴다)
+    struct OutboundFrame
+    {
+        std::shared_ptr<const std::string> frame;
+        std::shared_ptr<const std::string> key; // 발행 한 번의 구독자 프레임이 모두 같은 문자열을 가리킨다
+    };
+
+    // 연결된 클라이언트 (local_port: 접속을 받은 리스너 포트, Message::local_port로 전달. AF_UNIX는 0)
+    struct ClientConn
+    {
+        int fd = -1;
+        int local_port = 0;
+        bool is_unix = false;
+        std::shared_ptr<ShmSession> shm; // 있으면 응답을 소켓 대신 s2c 링으로 보낸다 (링이 차면 outbox를 거친다)
+
+        // 송신 대기열 (client_mutex_ 보호)
+        std::deque<OutboundFrame> outbox;
+        size_t out_off = 0;      // outbox.front()에서 이미 보낸 바이트
+        size_t out_bytes = 0;    // 아직 보내지 못한 바이트 합
+        bool out_armed = false;  // flush 스레드 epoll에 EPOLLOUT 등록됨
+        bool over_limit = false; // 한도를 넘은 상태 (SLOW_CONSUMER 프로브는 넘어설 때 한 번)
+        bool paused = false;     // PAUSE: 수신을 멈추고 생산자를 기다리게 하는 중
+        // paused 사본. recv/shm 스레드가 락 없이 보고 이 연결을 읽지 않는다
+        std::shared_ptr<std::atomic<bool>> read_paused = std::make_shared<std::atomic<bool>>(false);
+        int64_t out_progress_ns = 0; // 송신 대기열이 마지막으로 줄어든(또는 생긴) 시각 (송신 정체 판단)
+        int64_t last_send_ns = 0;    // 마지막으로 프레임을 보낸(대기열에 넣은) 시각 (하트비트 판단)
+        // 연결이 정리되면 true. 아직 처리되지 않은 요청의 CancelToken이 같은 플래그를 본다
+        std::shared_ptr<std::atomic<bool>> closed = std::make_shared<std::atomic<bool>>(false);
+        std::shared_ptr<RateState> rate; // 요청 수 제한이 켜져 있을 때만
+        int recv_thread = 0;             // 이 연결을 읽는 recv 스레드 (공유 메모리로 넘기면 그 스레드에서 빠진다)
+        bool subscribed = false;         // topic을 구독한 적 있음 (연결 종료 시 구독 정리 대상)
+    };
+
+    // recv 스레드가 읽는 연결 하나 (그 스레드만 만진다)
+    struct RecvConn
+    {
+        int client_id = 0;
+        int fd = -1;
+        int local_port = 0;
+        std::shared_ptr<const std::atomic<bool>> closed;
+        std::shared_ptr<const std::atomic<bool>> paused; // ClientConn::read_paused
+        std::shared_ptr<RateState> rate;
+        bool parked = false; // PAUSE/DELAY로 epoll 관심을 잠시 끔
+    };
+
+    // recv 스레드별 변경 요청함. accept 스레드가 새 연결을, 연결을 닫거나 공유 메모리로 넘긴 스레드가 제거를 넣고
+    // wake eventfd로 깨운다. recv 스레드는 들어온 순서대로 자기 epoll에 반영한다 (fd 번호 재사용 대비)
+    // 락 순서: client_mutex_ -> RecvInbox::mutex
+    struct RecvInbox
+    {
+        struct Change
+        {
+            RecvConn conn;
+            bool remove = false; // true면 conn.client_id만 쓴다
+        };
+        std::mutex mutex;
+        std::vector<Change> changes;
+    };
+
+    // recv 스레드 전용 타이머 (연결 점검 타이머와 그 스레드가 마지막으로 읽은 시각)
+    struct IoTimers
+    {
+        IoTimers(TcpServer *owner, int64_t now_ns) : server(owner), wheel(kTimerTickNs, now_ns) {}
+
+        TcpServer *server;
+        TimerWheel wheel;
+        bool shm = false; // shm 스레드의 타이머 (공유 메모리 연결만 점검한다. recv 스레드는 소켓 연결만)
+        std::unordered_map<int, int64_t> last_recv_ns; // client_id -> 마지막 프레임 수신 시각
+    };
+
+    enum class OutboundResult
+    {
+        QUEUED,
+        OVER_LIMIT, // 대기열에 넣었고 이번에 한도를 처음 넘었다 (프로브 대상)
+        DISCONNECT, // 정책상 끊어야 함
+    };
+
+    bool openListeners();
+    void closeListeners();
+    // accept 스레드를 멈추고 리스너를 닫는다 (drain/stop 공용)
+    void stopAccepting();
+
+    // 리스너 넘겨주기 (TcpServerHandoff.cpp)
+    static std::string listenerKey(const ListenAddress &address);
+    bool openHandoffListener();
+    void handoffLoop();
+    bool sendListeners(int fd);
+    bool receiveListeners();
+
+    void acceptLoop(int thread_index);
+    int pickRecvThread(int client_id, int fd) const;
     void recvLoop(int thread_index);
-    void sendLoop();
-    void processLoop();
+    void wakeRecvThread(int thread_index);
+    // client_mutex_를 잡은 상태에서 호출. recv 스레드의 epoll에서 이 연결을 빼게 한다
+    void removeFromRecvThread(int client_id, const ClientConn &conn);
+    // drain() 중이면 drain_wake_fd_로 깨운다. 상태(in_flight_ 등)를 seq_cst로 바꾼 뒤에 부른다
+    // (drain()은 draining_을 세운 뒤 상태를 보므로 둘 중 한쪽은 반드시 상대의 변경을 본다)
+    void notifyDrain();
+    bool drainIdle() const;
+    // 연결 하나의 유휴/송신 정체/하트비트 기한을 확인하고 다음 기한에 다시 건다
+    void checkConnection(IoTimers &timers, int client_id);
+    void scheduleConnectionCheck(IoTimers &timers, int client_id, int64_t at_ns);
+    void shmLoop();
+    void sendLoop(int thread_index);
+    void processLoop(int thread_index);
+
+    // 스레드별 지연 히스토그램 (start()에서 만들고, 각 스레드만 기록)
+    struct RecvThreadStats
+    {
+        LatencyHistogram recv_to_enqueue;
+    };
+
+    struct ProcessThreadStats
+    {
+        LatencyHistogram queue_wait;
+        std::vector<std::unique_ptr<LatencyHistogram>> handler; // handler_types_ 순서 + "_unknown"
+    };
+
+    struct SendThreadStats
+    {
+        LatencyHistogram queue_wait;
+        LatencyHistogram send;
+    };
+
+    std::unique_ptr<ProcessThreadStats> newProcessStats() const;
+    void maybeGrowProcessPool(int64_t now_ns, int64_t wait_ns);
+    bool retireProcessThread(int thread_index);
+
+    // 스레드가 자기 통계 슬롯을 가져온다. 비어 있으면(CPU 고정 역할) 고정한 뒤 여기서 만들어
+    // 첫 접근 정책으로 그 코어의 NUMA 노드 메모리에 잡히게 하고, start()가 기다리는 stats_ready_를 줄인다
+    template <typename T, typename Make>
+    T &threadStats(std::unique_ptr<T> &slot, Make make)
+    {
+        if (!slot)
+        {
+            slot = make();
+            stats_ready_->count_down();
+        }
+        return *slot;
+    }
+
+    // 단계별로 합산한 스냅샷 (stats()와 metricsText()가 공유)
+    struct StageSnapshots
+    {
+        HistogramSnapshot recv_to_enqueue;
+        HistogramSnapshot recv_queue_wait;
+        std::vector<HistogramSnapshot> handler;
+        HistogramSnapshot send_queue_wait;
+        HistogramSnapshot send;
+    };
+
+    // 메시지 하나를 디스패치하고 핸들러 지연/메트릭/트레이스를 기록 (배치 프레임은 요소마다 호출)
+    nlohmann::json dispatchMessage(const Message &msg, ProcessThreadStats &stats);
+
+    size_t handlerTypeIndex(const nlohmann::json &req) const;
+    std::string handlerTypeName(size_t slot) const;
+    StageSnapshots collectStages() const;
+
+    void closeClient(int client_id, int fd, ExceptionType reason);
+    // client_mutex_를 잡은 상태에서 연결을 정리 (fd close, 구독/대기열 정리, 대기 중인 생산자 깨움)
+    void dropClientLocked(std::map<int, ClientConn>::iterator it);
+
+    // 송신 대기열 (client_mutex_를 잡은 상태에서 호출)
+    OutboundResult queueOutbound(int client_id, ClientConn &conn, OutboundFrame frame, size_t already_sent);
+    bool flushOutbound(ClientConn &conn);
+    void armWritable(int client_id, ClientConn &conn);
+    bool overOutboundLimit(const ClientConn &conn) const;
+    bool resumeIfDrained(int client_id, ClientConn &conn);
+    // 송신 대기 바이트를 빼고, 0이 되면 drain()을 깨운다
+    void releaseOutbound(int64_t bytes);
+    void flushLoop();
+    // PAUSE 정책: 대상 연결(정렬된 client_id) 중 멈춘 것이 있으면 풀릴 때까지 기다린다 (시간 초과면 그 연결을 끊는다)
+    // 처리 스레드에서는 기다리지 않는다. 멈춰 있거나 그래서 끊은 연결을 정렬해서 돌려주면 호출자가 그 연결 몫을 버린다
+    std::vector<int> waitForOutboundRoom(const std::vector<int> &client_ids);
+
+    // pub/sub (TcpServerPubSub.cpp)
+    using Subscribers = std::vector<int>; // 정렬된 client_id
+    using TopicMap = std::unordered_map<std::string, std::shared_ptr<const Subscribers>>;
+
+    void registerPubSubHandlers();
+    // 끊긴 연결의 구독 정리는 미뤄 두었다가 한 번에 한다 (retire: client_mutex_ 안, purge: 락 없이 호출)
+    void retireSubscriber(int client_id);
+    void purgeSubscribers();
+    void purgeSubscribersLocked();
+    static uint64_t nextTopicsVersion();
+    size_t fanOut(const Subscribers &client_ids, const nlohmann::json &json, std::shared_ptr<const std::string> key);
+
+    // 수신한 프레임 하나를 파싱해서 recv_queue_로 (소켓/공유 메모리 경로 공용)
+    // 요청 수 제한으로 연결을 끊었으면 false (호출자는 그 연결에서 더 읽지 않는다)
+    bool enqueueFrame(int client_id, int fd, int local_port, std::string_view payload, int64_t recv_ns,
+                      RecvThreadStats &stats, std::shared_ptr<const std::atomic<bool>> closed, RateState *rate,
+                      bool via_shm);
+    // 요청 수 제한 버킷에서 쓴다. 받아도 되면 true (DELAY는 항상 true, 대신 rate.resume_ns까지 읽기를 멈춘다)
+    bool chargeRate(RateState &rate, const nlohmann::json &req, int64_t now_ns);
+    // 큐에 넣지 않고 바로 에러로 답한다 (배치 프레임은 요소마다 에러)
+    void rejectFrame(int client_id, int local_port, const nlohmann::json &req, int64_t recv_ns, ErrorReason reason);
+    void attachShm(int client_id, int fd);
+    void releaseShm(ShmSession &session);
+    // shm 스레드: 링이 차서 outbox에 쌓인 프레임을 s2c 링으로 옮긴다. 링이 망가졌으면 false (끊어야 한다)
+    bool flushShmOutbox(ShmSession &session);
+
+    bool openAdminListener();
+    void closeAdminListener();
+    void adminLoop();
+    void serveAdminRequest(int fd);
 
     static bool recvAll(int fd, void *buf, size_t len);
     static bool sendAll(int fd, const void *buf, size_t len);
+    // non-blocking으로 보낼 수 있는 만큼 보낸다 (sent에 누적). 소켓 에러면 false
+    static bool sendSome(int fd, const char *data, size_t len, size_t &sent);
 
-    int server_fd_;
-    int port_;
+    std::vector<ListenAddress> listen_addresses_;
+    std::vector<Listener> listeners_;
     std::atomic<bool> running_{false};
+    std::atomic<bool> accepting_{false};
+    std::atomic<int64_t> in_flight_{0}; // recv_queue_에 넣었지만 아직 응답을 send_queue_에 넣지 않은 프레임 (drain 판단)
+    // 종료 신호 eventfd (한 번 쓰고 비우지 않는다: 레벨 트리거라 기다리는 스레드가 모두 깨어난다)
+    // 이 신호로 깨우므로 루프들이 running_을 다시 보려고 제한 시간을 두고 깨어날 필요가 없다
+    int accept_stop_fd_ = -1; // stopAccepting(): accept/handoff 스레드
+    int stop_fd_ = -1;        // stop(): admin 스레드
+    int drain_wake_fd_ = -1;  // drain(): 요청/송신 대기열이 비거나 연결이 닫히면 (draining_일 때만 쓴다)
+    std::atomic<bool> draining_{false};
+    std::atomic<uint64_t> drain_arrivals_{0}; // drain 중에 받은 프레임 수 (조용한 구간 판단)
+
+    // 리스너 넘겨주기
+    std::string handoff_path_;
+    std::string inherit_from_;
+    int handoff_fd_ = -1;
+    std::thread handoff_thread_;
+    std::atomic<bool> handed_off_{false};
+    std::map<std::string, int> inherited_fds_; // listenerKey -> 이전 프로세스에게서 받은 리스너 fd (start() 중에만)
+    std::function<void()> handoff_probe_ = nullptr;
 
     int accept_thread_count_ = 1;
     int recv_thread_count_ = 4;
@@ -109,22 +628,87 @@ private:
 
     std::vector<std::thread> accept_threads_;
     std::vector<std::thread> recv_threads_;
-    std::vector<std::thread> process_threads_;
+    std::vector<int> recv_wake_fds_; // recv 스레드별 eventfd: 새 연결 할당/연결 제거/PAUSE 해제 시 깨운다
+    std::vector<std::unique_ptr<RecvInbox>> recv_inboxes_;
+    static constexpr uint64_t kRecvWakeId = UINT64_MAX; // recv epoll에서 wake eventfd 표시
+    std::vector<std::thread> process_threads_; // pool_max_개 슬롯. 줄어든 슬롯은 늘릴 때 join하고 다시 쓴다
     std::vector<std::thread> send_threads_;
 
     std::mutex client_mutex_;
-    std::map<int, int> clients_; // client_id -> socket_fd
-    int next_client_id_ = 1;
+    std::map<int, ClientConn> clients_; // client_id -> 연결
+    std::condition_variable outbound_cv_; // client_mutex_와 함께 사용 (PAUSE 해제/연결 정리 알림)
+    std::unordered_map<int, int64_t> paused_clients_; // client_mutex_ 보호. PAUSE로 멈춘 연결 -> 멈춘 시각
+    std::atomic<size_t> paused_count_{0};             // paused_clients_ 크기 (멈춘 연결이 없으면 생산자는 락을 잡지 않는다)
+
+    // 느린 수신자 처리: 못 보낸 프레임은 연결별 outbox에, flush 스레드가 EPOLLOUT으로 마저 보낸다
+    static constexpr uint64_t kFlushWakeId = UINT64_MAX; // flush epoll에서 wake eventfd 표시
+    OutboundLimits outbound_limits_;
+    std::atomic<int64_t> outbound_bytes_{0}; // 모든 연결의 송신 대기 바이트 (게이지)
+    int flush_epoll_fd_ = -1;
+    int flush_wake_fd_ = -1;
+    std::thread flush_thread_;
 
-    // 소켓 할당: socket_fd -> assigned_thread_index (경쟁 상태 방지)
-    std::mutex socket_assignment_mutex_;
-    std::map<int, int> socket_assignments_;
+    static constexpr int64_t kTimerTickNs = 10 * 1000 * 1000; // 타이머 휠 해상도 10ms
+    ConnectionTimeouts timeouts_;
+    AdmissionController admission_;
+    RateLimits rate_limits_;
+    TokenBucket conn_bucket_;
+    std::vector<TokenBucket> type_buckets_; // handler_types_ 순서 + "_unknown" (start()에서 만든다)
+    CpuAffinity affinity_;
+
+    // 처리 스레드 풀 (pool_min_ == pool_max_면 고정 크기)
+    ProcessPoolLimits pool_limits_;
+    int pool_min_ = 0;
+    int pool_max_ = 0;
+    std::mutex pool_mutex_;               // process_threads_ 슬롯 교체, 스레드 수 변경 보호
+    std::vector<bool> pool_slot_running_; // pool_mutex_: 슬롯에 도는 스레드가 있음
+    bool pool_closed_ = false;            // pool_mutex_: stop() 이후에는 늘리지 않는다
+    std::atomic<int> process_active_{0}; // pool_mutex_ 안에서만 바꾼다
+    std::atomic<int64_t> next_pool_check_ns_{0}; // 늘릴지 다음에 볼 시각 (꺼낼 때마다 보지 않게)
+    std::vector<int> recv_thread_by_cpu_; // SO_INCOMING_CPU -> recv 스레드 (-1: 라운드 로빈). start()에서 만든다
+    int next_client_id_ = 1;
 
     Dispatcher dispatcher_;
 
     ThreadSafeQueue<Message> recv_queue_;
     ThreadSafeQueue<Message> send_queue_;
 
+    std::vector<std::string> handler_types_;
+    std::unordered_map<std::string, size_t> handler_type_index_;
+    std::vector<std::unique_ptr<RecvThreadStats>> recv_stats_;
+    std::unique_ptr<RecvThreadStats> shm_stats_;
+    std::unique_ptr<std::latch> stats_ready_; // 스레드가 만드는 통계 슬롯이 모두 채워지면 0
+    std::vector<std::unique_ptr<ProcessThreadStats>> process_stats_;
+    std::vector<std::unique_ptr<SendThreadStats>> send_stats_;
+
+    ServerMetrics metrics_;
+
+    // topic 구독 목록 (copy-on-write). 구독/해지는 topics_mutex_ 안에서 새 맵을 만들어 통째로 교체하고
+    // topics_version_을 올린다. 발행은 버전만 읽고, 바뀌었을 때만 락을 잡아 스레드별 스냅샷을 새로 받는다
+    // 락 순서: client_mutex_ -> topics_mutex_
+    std::mutex topics_mutex_;
+    std::shared_ptr<const TopicMap> topics_ = std::make_shared<const TopicMap>(); // topics_mutex_ 보호
+    std::atomic<uint64_t> topics_version_{nextTopicsVersion()}; // 프로세스 전체에서 겹치지 않는 값
+    std::unordered_map<int, std::vector<std::string>> client_topics_; // topics_mutex_ 보호, 연결 종료 시 정리용
+    std::vector<int> retired_subscribers_;              // topics_mutex_ 보호. 끊겼지만 아직 목록에 남은 client_id
+    std::atomic<size_t> retired_count_{0};               // retired_subscribers_.size() (락 없이 확인용)
+    bool client_publish_ = false;                        // 내장 메시지 "publish" 등록 여부
+
+    // 공유 메모리 전송 (AF_UNIX 리스너가 있을 때만 shm 스레드를 띄운다)
+    int shm_spin_us_ = 50;
+    size_t shm_ring_bytes_ = kShmRingBytes;
+    int shm_wake_fd_ = -1;
+    std::thread shm_thread_;
+    std::mutex shm_mutex_;
+    std::vector<std::shared_ptr<ShmSession>> shm_pending_; // attach 후 shm 스레드가 가져갈 세션
+    std::atomic<bool> shm_changed_{false};                 // 새 세션 또는 닫힌 세션이 있음
+
+    // 관리용 리스너 (admin_port_ < 0 이고 admin_unix_path_가 비어 있으면 비활성)
+    int admin_port_ = -1;
+    std::string admin_unix_path_;
+    std::vector<int> admin_fds_;
+    std::thread admin_thread_;
+
     std::function<void(const TcpServerConfig &)> start_probe_ = nullptr;
     std::function<void(const TcpServerConfig &)> stop_probe_ = nullptr;
     std::function<void(const int client_id, const int socket_fd, ExceptionType et)> exception_probe_ = nullptr;
@@ -0,0 +1,346 @@
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <string_view>
+
+#include "TcpServer.h"
+#include "Logger.h"
+
+namespace msgnet
+{
+
+namespace
+{
+
+// Prometheus 히스토그램 버킷 경계 (초)
+const double kLatencyBucketsSec[] = {
+    1e-6, 5e-6, 10e-6, 25e-6, 50e-6, 100e-6, 250e-6, 500e-6,
+    1e-3, 2.5e-3, 5e-3, 10e-3, 25e-3, 50e-3, 100e-3, 250e-3, 500e-3, 1.0};
+
+void writeHeader(std::ostringstream &os, const char *name, const char *type, const char *help)
+{
+    os << "# HELP " << name << ' ' << help << '\n'
+       << "# TYPE " << name << ' ' << type << '\n';
+}
+
+// 레이블 값 이스케이프 (exposition format: \\, \", 줄바꿈)
+std::string escapeLabel(std::string_view value)
+{
+    std::string out;
+    out.reserve(value.size());
+    for (char c : value)
+    {
+        if (c == '\\')
+            out += "\\\\";
+        else if (c == '"')
+            out += "\\\"";
+        else if (c == '\n')
+            out += "\\n";
+        else
+            out += c;
+    }
+    return out;
+}
+
+void writeHistogram(std::ostringstream &os, const char *name, const std::string &labels,
+                    const HistogramSnapshot &h)
+{
+    const std::string sep = labels.empty() ? "" : ",";
+    for (double le : kLatencyBucketsSec)
+    {
+        os << name << "_bucket{" << labels << sep << "le=\"" << le << "\"} "
+           << h.countAtOrBelow(static_cast<uint64_t>(le * 1e9)) << '\n';
+    }
+    os << name << "_bucket{" << labels << sep << "le=\"+Inf\"} " << h.count() << '\n';
+    os << name << "_sum{" << labels << "} " << static_cast<double>(h.sum()) / 1e9 << '\n';
+    os << name << "_count{" << labels << "} " << h.count() << '\n';
+}
+
+// 관리 요청 하나(요청 읽기 + 응답 쓰기)에 쓰는 시간 상한
+// 읽지 않거나 조금씩만 읽는 스크레이퍼가 admin 스레드(와 그 스레드를 join하는 stop())를 붙잡지 않게
+constexpr int64_t kAdminRequestTimeoutNs = 2000 * 1000000LL;
+
+// deadline_ns까지 fd가 events 준비되기를 기다린다. 시간이 지났거나 stop_fd가 울리면 false
+bool waitReady(int fd, short events, int stop_fd, int64_t deadline_ns)
+{
+    while (true)
+    {
+        const int64_t left_ns = deadline_ns - monotonicNowNs();
+        if (left_ns <= 0)
+            return false;
+        pollfd pfds[2] = {{fd, events, 0}, {stop_fd, POLLIN, 0}};
+        const int n = ::poll(pfds, stop_fd >= 0 ? 2 : 1, static_cast<int>((left_ns + 999999) / 1000000));
+        if (n < 0 && errno == EINTR)
+            continue;
+        // POLLERR/POLLHUP은 true로 돌려서 뒤이은 recv/send가 실패를 알리게 한다
+        return n > 0 && !(pfds[1].revents & POLLIN);
+    }
+}
+
+bool sendAllNoSignal(int fd, const std::string &data, int stop_fd, int64_t deadline_ns)
+{
+    size_t sent = 0;
+    while (sent < data.size())
+    {
+        ssize_t s = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (s <= 0)
+        {
+            if (s < 0 && errno == EINTR)
+                continue;
+            if (s < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && waitReady(fd, POLLOUT, stop_fd, deadline_ns))
+                continue;
+            return false;
+        }
+        sent += static_cast<size_t>(s);
+    }
+    return true;
+}
+
+} // namespace
+
+std::string TcpServer::metricsText() const
+{
+    const ServerMetrics::Totals t = metrics_.collect();
+    const StageSnapshots stages = collectStages();
+
+    std::ostringstream os;
+
+    writeHeader(os, "msgnet_connections_accepted_total", "counter", "Accepted client connections.");
+    os << "msgnet_connections_accepted_total " << t.connections_accepted << '\n';
+    writeHeader(os, "msgnet_connections_closed_total", "counter", "Closed client connections.");
+    os << "msgnet_connections_closed_total " << t.connections_closed << '\n';
+    writeHeader(os, "msgnet_connections_open", "gauge", "Currently open client connections.");
+    os << "msgnet_connections_open " << (t.connections_accepted - t.connections_closed) << '\n';
+
+    writeHeader(os, "msgnet_bytes_received_total", "counter", "Bytes received in frames (including length prefix).");
+    os << "msgnet_bytes_received_total " << t.bytes_in << '\n';
+    writeHeader(os, "msgnet_bytes_sent_total", "counter", "Bytes sent in frames (including length prefix).");
+    os << "msgnet_bytes_sent_total " << t.bytes_out << '\n';
+    writeHeader(os, "msgnet_frames_received_total", "counter", "Frames received.");
+    os << "msgnet_frames_received_total " << t.frames_in << '\n';
+    writeHeader(os, "msgnet_frames_sent_total", "counter", "Frames sent.");
+    os << "msgnet_frames_sent_total " << t.frames_out << '\n';
+    writeHeader(os, "msgnet_batch_frames_total", "counter", "Frames received as a JSON array of requests.");
+    os << "msgnet_batch_frames_total " << t.batch_frames << '\n';
+    writeHeader(os, "msgnet_batched_messages_total", "counter", "Requests received inside batch frames.");
+    os << "msgnet_batched_messages_total " << t.batch_messages << '\n';
+    writeHeader(os, "msgnet_published_total", "counter", "Broadcast/publish calls, each serialized once.");
+    os << "msgnet_published_total " << t.published << '\n';
+    writeHeader(os, "msgnet_fanout_frames_total", "counter", "Per-subscriber sends queued by broadcast/publish.");
+    os << "msgnet_fanout_frames_total " << t.fanout << '\n';
+
+    writeHeader(os, "msgnet_messages_total", "counter", "Dispatched messages by type.");
+    for (size_t i = 0; i < t.messages.size(); ++i)
+        os << "msgnet_messages_total{type=\"" << escapeLabel(handlerTypeName(i)) << "\"} " << t.messages[i] << '\n';
+
+    writeHeader(os, "msgnet_errors_total", "counter", "Error responses by reason.");
+    for (size_t i = 1; i < t.errors.size(); ++i)
+    {
+        os << "msgnet_errors_total{reason=\"" << escapeLabel(errorReasonName(static_cast<ErrorReason>(i))) << "\"} "
+           << t.errors[i] << '\n';
+    }
+
+    writeHeader(os, "msgnet_queue_depth", "gauge", "Messages waiting in internal queues.");
+    os << "msgnet_queue_depth{queue=\"recv\"} " << recv_queue_.size() << '\n';
+    os << "msgnet_queue_depth{queue=\"send\"} " << send_queue_.size() << '\n';
+
+    writeHeader(os, "msgnet_outbound_queued_bytes", "gauge", "Bytes waiting in per-connection outbound queues.");
+    os << "msgnet_outbound_queued_bytes " << outbound_bytes_.load(std::memory_order_relaxed) << '\n';
+    writeHeader(os, "msgnet_slow_consumer_total", "counter", "Slow-consumer policy actions.");
+    os << "msgnet_slow_consumer_total{action=\"dropped\"} " << t.outbound_dropped << '\n';
+    os << "msgnet_slow_consumer_total{action=\"coalesced\"} " << t.outbound_coalesced << '\n';
+    os << "msgnet_slow_consumer_total{action=\"disconnected\"} " << t.slow_disconnects << '\n';
+    os << "msgnet_slow_consumer_total{action=\"paused\"} " << t.slow_pauses << '\n';
+    writeHeader(os, "msgnet_connection_timeouts_total", "counter", "Connections closed by a connection timer.");
+    os << "msgnet_connection_timeouts_total{reason=\"idle\"} " << t.idle_timeouts << '\n';
+    os << "msgnet_connection_timeouts_total{reason=\"write_stall\"} " << t.write_stalls << '\n';
+    writeHeader(os, "msgnet_heartbeats_sent_total", "counter", "Server-initiated heartbeat frames.");
+    os << "msgnet_heartbeats_sent_total " << t.heartbeats << '\n';
+
+    writeHeader(os, "msgnet_rate_limited_total", "counter", "Requests over a rate limit by action taken.");
+    os << "msgnet_rate_limited_total{action=\"reject\"} " << t.errors[static_cast<size_t>(ErrorReason::RATE_LIMITED)] << '\n';
+    os << "msgnet_rate_limited_total{action=\"delay\"} " << t.rate_delays << '\n';
+    os << "msgnet_rate_limited_total{action=\"disconnect\"} " << t.rate_disconnects << '\n';
+
+    writeHeader(os, "msgnet_admission_shedding", "gauge", "1 while the admission controller rejects low-priority requests.");
+    os << "msgnet_admission_shedding " << (admission_.sheddingNow() ? 1 : 0) << '\n';
+
+    writeHeader(os, "msgnet_process_threads", "gauge", "Running request-processing threads.");
+    os << "msgnet_process_threads " << process_active_.load(std::memory_order_relaxed) << '\n';
+
+    writeHeader(os, "msgnet_requests_abandoned_total", "counter", "Requests dropped because the connection closed before processing.");
+    os << "msgnet_requests_abandoned_total " << t.abandoned << '\n';
+
+    writeHeader(os, "msgnet_log_dropped_total", "counter", "Log records dropped by the async logger.");
+    os << "msgnet_log_dropped_total " << Logger::instance().droppedCount() << '\n';
+
+    writeHeader(os, "msgnet_stage_latency_seconds", "histogram", "Pipeline stage latency.");
+    writeHistogram(os, "msgnet_stage_latency_seconds", "stage=\"recv_to_enqueue\"", stages.recv_to_enqueue);
+    writeHistogram(os, "msgnet_stage_latency_seconds", "stage=\"recv_queue_wait\"", stages.recv_queue_wait);
+    writeHistogram(os, "msgnet_stage_latency_seconds", "stage=\"send_queue_wait\"", stages.send_queue_wait);
+    writeHistogram(os, "msgnet_stage_latency_seconds", "stage=\"send\"", stages.send);
+
+    writeHeader(os, "msgnet_handler_latency_seconds", "histogram", "Handler execution time by message type.");
+    for (size_t i = 0; i < stages.handler.size(); ++i)
+    {
+        writeHistogram(os, "msgnet_handler_latency_seconds",
+                       "type=\"" + escapeLabel(handlerTypeName(i)) + "\"", stages.handler[i]);
+    }
+
+    return os.str();
+}
+
+bool TcpServer::openAdminListener()
+{
+    if (admin_port_ >= 0)
+    {
+        int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            perror("admin socket");
+        }
+        else
+        {
+            int opt = 1;
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = INADDR_ANY;
+            addr.sin_port = htons(admin_port_);
+
+            if (::bind(fd, (sockaddr *)&addr, sizeof(addr)) < 0 || ::listen(fd, 16) < 0)
+            {
+                perror("admin bind/listen");
+                ::close(fd);
+            }
+            else
+            {
+                admin_fds_.push_back(fd);
+                LOG_INFO("[TcpServer] Admin metrics listening on port ", admin_port_);
+            }
+        }
+    }
+
+    if (!admin_unix_path_.empty())
+    {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (fd < 0 || admin_unix_path_.size() >= sizeof(addr.sun_path))
+        {
+            perror("admin unix socket");
+            if (fd >= 0)
+                ::close(fd);
+        }
+        else
+        {
+            std::memcpy(addr.sun_path, admin_unix_path_.c_str(), admin_unix_path_.size() + 1);
+            ::unlink(admin_unix_path_.c_str());
+            if (::bind(fd, (sockaddr *)&addr, sizeof(addr)) < 0 || ::listen(fd, 16) < 0)
+            {
+                perror("admin unix bind/listen");
+                ::close(fd);
+            }
+            else
+            {
+                admin_fds_.push_back(fd);
+                LOG_INFO("[TcpServer] Admin metrics listening on ", admin_unix_path_);
+            }
+        }
+    }
+
+    return !admin_fds_.empty();
+}
+
+void TcpServer::closeAdminListener()
+{
+    for (int fd : admin_fds_)
+        ::close(fd);
+    admin_fds_.clear();
+    if (!admin_unix_path_.empty())
+        ::unlink(admin_unix_path_.c_str());
+}
+
+void TcpServer::adminLoop()
+{
+    std::vector<pollfd> pfds;
+    for (int fd : admin_fds_)
+        pfds.push_back({fd, POLLIN, 0});
+    pfds.push_back({stop_fd_, POLLIN, 0}); // stop()이 깨운다
+
+    while (running_)
+    {
+        int ready = ::poll(pfds.data(), pfds.size(), -1);
+        if (ready <= 0)
+            continue;
+
+        for (auto &pfd : pfds)
+        {
+            if (!(pfd.revents & POLLIN) || pfd.fd == stop_fd_)
+                continue;
+            int fd = ::accept4(pfd.fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd < 0)
+                continue;
+            serveAdminRequest(fd);
+            ::close(fd);
+        }
+    }
+}
+
+void TcpServer::serveAdminRequest(int fd)
+{
+    // 느린 스크레이퍼가 admin 스레드를 오래 붙잡지 않도록 읽기와 쓰기를 합쳐 시간 제한 (stop()이면 바로 그만둔다)
+    const int64_t deadline_ns = monotonicNowNs() + kAdminRequestTimeoutNs;
+
+    std::string req;
+    char buf[1024];
+    while (req.find("\r\n\r\n") == std::string::npos && req.size() < 8192)
+    {
+        ssize_t r = ::recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (r <= 0)
+        {
+            if (r < 0 && errno == EINTR)
+                continue;
+            if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && waitReady(fd, POLLIN, stop_fd_, deadline_ns))
+                continue;
+            break;
+        }
+        req.append(buf, static_cast<size_t>(r));
+    }
+
+    // 요청 라인: "GET /metrics HTTP/1.1"
+    std::istringstream line(req.substr(0, req.find("\r\n")));
+    std::string method, path;
+    line >> method >> path;
+
+    std::string status = "200 OK";
+    std::string body;
+    if (method != "GET")
+    {
+        status = "405 Method Not Allowed";
+        body = "method not allowed\n";
+    }
+    else if (path == "/metrics" || path == "/")
+    {
+        body = metricsText();
+    }
+    else
+    {
+        status = "404 Not Found";
+        body = "not found\n";
+    }
+
+    std::string resp = "HTTP/1.1 " + status + "\r\n"
+                       "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                       "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                       "Connection: close\r\n\r\n" + body;
+    sendAllNoSignal(fd, resp, stop_fd_, deadline_ns);
+}
+
+} // namespace msgnet
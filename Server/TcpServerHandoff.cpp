@@ -0,0 +1,237 @@
+#include <poll.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "TcpServer.h"
+#include "Logger.h"
+
+namespace msgnet
+{
+
+namespace
+{
+
+// 메시지 하나에 붙이는 fd 수 (SCM_MAX_FD 253보다 작게). 리스너가 많으면 여러 메시지로 나눈다
+constexpr size_t kFdsPerMessage = 64;
+constexpr size_t kMaxHandoffMessage = 64 * 1024;
+
+// SOCK_SEQPACKET이라 메시지 경계와 붙은 fd가 함께 간다
+bool sendWithFds(int sock, const std::string &data, const std::vector<int> &fds)
+{
+    iovec iov{const_cast<char *>(data.data()), data.size()};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    std::vector<char> control;
+    if (!fds.empty())
+    {
+        control.resize(CMSG_SPACE(sizeof(int) * fds.size()));
+        msg.msg_control = control.data();
+        msg.msg_controllen = control.size();
+        cmsghdr *cm = CMSG_FIRSTHDR(&msg);
+        cm->cmsg_level = SOL_SOCKET;
+        cm->cmsg_type = SCM_RIGHTS;
+        cm->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+        std::memcpy(CMSG_DATA(cm), fds.data(), sizeof(int) * fds.size());
+    }
+
+    ssize_t r;
+    do
+    {
+        r = ::sendmsg(sock, &msg, MSG_NOSIGNAL);
+    } while (r < 0 && errno == EINTR);
+    return r == static_cast<ssize_t>(data.size());
+}
+
+// 메시지 하나를 받아 본문과 붙어 온 fd를 돌려준다 (fd는 CLOEXEC로 받는다)
+bool recvWithFds(int sock, std::string &data, std::vector<int> &fds)
+{
+    data.resize(kMaxHandoffMessage);
+    iovec iov{data.data(), data.size()};
+    std::vector<char> control(CMSG_SPACE(sizeof(int) * kFdsPerMessage));
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data();
+    msg.msg_controllen = control.size();
+
+    ssize_t r;
+    do
+    {
+        r = ::recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    } while (r < 0 && errno == EINTR);
+    if (r <= 0)
+        return false;
+    data.resize(static_cast<size_t>(r));
+
+    for (cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm))
+    {
+        if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_RIGHTS)
+            continue;
+        const size_t n = (cm->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        const size_t first = fds.size();
+        fds.resize(first + n);
+        std::memcpy(fds.data() + first, CMSG_DATA(cm), sizeof(int) * n);
+    }
+    return (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) == 0;
+}
+
+} // namespace
+
+std::string TcpServer::listenerKey(const ListenAddress &address)
+{
+    if (address.isUnix())
+        return "unix:" + address.unix_path;
+    return address.host + ":" + std::to_string(address.port);
+}
+
+bool TcpServer::openHandoffListener()
+{
+    SocketAddress addr;
+    if (!SocketAddress::fromUnixPath(handoff_path_, addr))
+    {
+        LOG_ERROR("[TcpServer] Invalid handoff path ", handoff_path_);
+        return false;
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        perror("handoff socket");
+        return false;
+    }
+    if (!SocketAddress::isAbstract(handoff_path_))
+        ::unlink(handoff_path_.c_str());
+    if (::bind(fd, addr.get(), addr.length) < 0 || ::listen(fd, 1) < 0)
+    {
+        perror("handoff bind/listen");
+        ::close(fd);
+        return false;
+    }
+    handoff_fd_ = fd;
+    LOG_INFO("[TcpServer] Listener handoff available on ", handoff_path_);
+    return true;
+}
+
+void TcpServer::handoffLoop()
+{
+    while (running_ && accepting_)
+    {
+        pollfd pfds[2] = {{handoff_fd_, POLLIN, 0}, {accept_stop_fd_, POLLIN, 0}}; // stopAccepting()이 깨운다
+        if (::poll(pfds, 2, -1) <= 0 || !(pfds[0].revents & POLLIN))
+            continue;
+        int fd = ::accept4(handoff_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0)
+            continue;
+
+        // 새 프로세스가 같은 경로에 자기 handoff 리스너를 열 수 있도록 넘기기 전에 닫는다
+        // (소켓 파일은 지우지 않는다. 새 프로세스가 지우고 다시 만든다)
+        ::close(handoff_fd_);
+        handoff_fd_ = -1;
+
+        const bool sent = sendListeners(fd);
+        ::close(fd);
+        if (sent)
+        {
+            handed_off_.store(true, std::memory_order_release);
+            LOG_INFO("[TcpServer] Handed off ", listeners_.size(), " listeners");
+            if (handoff_probe_)
+                handoff_probe_();
+            return;
+        }
+
+        LOG_WARN("[TcpServer] Listener handoff failed, keeping listeners");
+        if (!openHandoffListener())
+            return;
+    }
+}
+
+bool TcpServer::sendListeners(int fd)
+{
+    // {"listeners":[{"host":..,"port":..,"unix_path":..},...]} + 같은 순서의 fd, 마지막에 {"done":true}
+    for (size_t i = 0; i < listeners_.size(); i += kFdsPerMessage)
+    {
+        const size_t end = std::min(listeners_.size(), i + kFdsPerMessage);
+        nlohmann::json list = nlohmann::json::array();
+        std::vector<int> fds;
+        for (size_t k = i; k < end; ++k)
+        {
+            const ListenAddress &a = listeners_[k].address;
+            list.push_back({{"host", a.host}, {"port", a.port}, {"unix_path", a.unix_path}});
+            fds.push_back(listeners_[k].fd);
+        }
+        if (!sendWithFds(fd, nlohmann::json{{"listeners", std::move(list)}}.dump(), fds))
+            return false;
+    }
+    return sendWithFds(fd, nlohmann::json{{"done", true}}.dump(), {});
+}
+
+bool TcpServer::receiveListeners()
+{
+    SocketAddress addr;
+    if (!SocketAddress::fromUnixPath(inherit_from_, addr))
+        return false;
+    int sock = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (sock < 0)
+        return false;
+    if (::connect(sock, addr.get(), addr.length) < 0)
+    {
+        ::close(sock);
+        return false;
+    }
+    // 이전 프로세스가 멈춰 있어도 시작이 끝없이 막히지 않게
+    timeval tv{};
+    tv.tv_sec = 5;
+    ::setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    bool done = false;
+    std::string data;
+    while (!done)
+    {
+        std::vector<int> fds;
+        const bool ok = recvWithFds(sock, data, fds);
+        auto j = ok ? nlohmann::json::parse(data, nullptr, false) : nlohmann::json();
+        const nlohmann::json *list = nullptr;
+        if (j.is_object())
+        {
+            done = j.value("done", false);
+            auto it = j.find("listeners");
+            if (it != j.end() && it->is_array())
+                list = &*it;
+        }
+        if (!done && (!list || list->size() != fds.size()))
+        {
+            for (int fd : fds)
+                ::close(fd);
+            break;
+        }
+        for (size_t i = 0; list && i < fds.size(); ++i)
+        {
+            const nlohmann::json &item = (*list)[i];
+            ListenAddress a;
+            a.host = item.value("host", "");
+            a.port = item.value("port", 0);
+            a.unix_path = item.value("unix_path", "");
+            auto [it, inserted] = inherited_fds_.emplace(listenerKey(a), fds[i]);
+            if (!inserted)
+                ::close(fds[i]);
+        }
+    }
+    ::close(sock);
+
+    if (!done)
+    {
+        for (auto &[key, fd] : inherited_fds_)
+            ::close(fd);
+        inherited_fds_.clear();
+        return false;
+    }
+    LOG_INFO("[TcpServer] Inherited ", inherited_fds_.size(), " listeners from ", inherit_from_);
+    return true;
+}
+
+} // namespace msgnet
@@ -0,0 +1,271 @@
+#include <algorithm>
+
+#include "TcpServer.h"
+#include "Logger.h"
+#include "Frame.h"
+
+namespace msgnet
+{
+
+namespace
+{
+
+// 요청 payload의 topic (없거나 문자열이 아니면 예외 -> handler_exception 응답)
+std::string requestTopic(const nlohmann::json &req)
+{
+    return req.at("payload").at("topic").get<std::string>();
+}
+
+nlohmann::json makeResponse(const nlohmann::json &req, const char *type, nlohmann::json payload)
+{
+    nlohmann::json res;
+    res["type"] = type;
+    res["ok"] = true;
+    if (req.contains("req_id"))
+        res["req_id"] = req["req_id"];
+    res["payload"] = std::move(payload);
+    return res;
+}
+
+} // namespace
+
+void TcpServer::registerPubSubHandlers()
+{
+    // 같은 이름의 핸들러를 직접 등록했다면 그쪽을 쓴다
+    auto add = [this](const char *type, Dispatcher::MessageHandler fn)
+    {
+        if (!dispatcher_.hasMessageHandler(type))
+            dispatcher_.registerMessageHandler(type, std::move(fn));
+    };
+
+    // {"type":"subscribe","req_id":..,"payload":{"topic":"t"}}
+    add("subscribe", [this](const Message &msg)
+        {
+            const std::string topic = requestTopic(msg.json);
+            const size_t subscribers = subscribe(msg.client_id, topic);
+            return makeResponse(msg.json, "subscribe_resp", {{"topic", topic}, {"subscribers", subscribers}}); });
+
+    // {"type":"unsubscribe","req_id":..,"payload":{"topic":"t"}}
+    add("unsubscribe", [this](const Message &msg)
+        {
+            const std::string topic = requestTopic(msg.json);
+            const size_t subscribers = unsubscribe(msg.client_id, topic);
+            return makeResponse(msg.json, "unsubscribe_resp", {{"topic", topic}, {"subscribers", subscribers}}); });
+
+    // 클라이언트 발행은 setClientPublishEnabled(true)일 때만 받는다
+    if (!client_publish_)
+        return;
+
+    // {"type":"publish","req_id":..,"payload":{"topic":"t","data":...}}
+    // 구독자는 {"type":"message","topic":"t","payload":<data>}를 받는다 (req_id 없는 푸시)
+    add("publish", [this](const Message &msg)
+        {
+            const std::string topic = requestTopic(msg.json);
+            nlohmann::json push;
+            push["type"] = "message";
+            push["topic"] = topic;
+            push["payload"] = msg.json["payload"].value("data", nlohmann::json());
+            const size_t delivered = publish(topic, push);
+            return makeResponse(msg.json, "publish_resp", {{"topic", topic}, {"delivered", delivered}}); });
+}
+
+uint64_t TcpServer::nextTopicsVersion()
+{
+    // 서버 인스턴스가 여러 개여도 버전이 겹치지 않아야 스레드별 스냅샷을 잘못 재사용하지 않는다
+    static std::atomic<uint64_t> version{0};
+    return version.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+size_t TcpServer::subscribe(int client_id, const std::string &topic)
+{
+    // 끊긴 연결의 구독이 남지 않도록 client_mutex_를 잡은 채로 등록한다 (연결이 정리되면 retireSubscriber로 넘어간다)
+    std::lock_guard<std::mutex> client_lock(client_mutex_);
+    auto conn = clients_.find(client_id);
+    if (conn == clients_.end())
+        return 0;
+    conn->second.subscribed = true;
+
+    std::lock_guard<std::mutex> lock(topics_mutex_);
+    purgeSubscribersLocked();
+    auto it = topics_->find(topic);
+    auto subs = std::make_shared<Subscribers>();
+    if (it != topics_->end())
+    {
+        if (std::binary_search(it->second->begin(), it->second->end(), client_id))
+            return it->second->size();
+        subs->reserve(it->second->size() + 1);
+        *subs = *it->second;
+    }
+    subs->insert(std::lower_bound(subs->begin(), subs->end(), client_id), client_id);
+    const size_t count = subs->size();
+
+    auto next = std::make_shared<TopicMap>(*topics_);
+    (*next)[topic] = std::move(subs);
+    topics_ = std::move(next);
+    topics_version_.store(nextTopicsVersion(), std::memory_order_release);
+    client_topics_[client_id].push_back(topic);
+    return count;
+}
+
+size_t TcpServer::unsubscribe(int client_id, const std::string &topic)
+{
+    std::lock_guard<std::mutex> lock(topics_mutex_);
+    purgeSubscribersLocked();
+    auto it = topics_->find(topic);
+    if (it == topics_->end())
+        return 0;
+    const Subscribers &old = *it->second;
+    auto pos = std::lower_bound(old.begin(), old.end(), client_id);
+    if (pos == old.end() || *pos != client_id)
+        return old.size();
+
+    auto next = std::make_shared<TopicMap>(*topics_);
+    const size_t count = old.size() - 1;
+    if (count == 0)
+    {
+        next->erase(topic);
+    }
+    else
+    {
+        auto subs = std::make_shared<Subscribers>();
+        subs->reserve(count);
+        subs->insert(subs->end(), old.begin(), pos);
+        subs->insert(subs->end(), pos + 1, old.end());
+        (*next)[topic] = std::move(subs);
+    }
+    topics_ = std::move(next);
+    topics_version_.store(nextTopicsVersion(), std::memory_order_release);
+
+    auto ct = client_topics_.find(client_id);
+    if (ct != client_topics_.end())
+    {
+        std::erase(ct->second, topic);
+        if (ct->second.empty())
+            client_topics_.erase(ct);
+    }
+    return count;
+}
+
+void TcpServer::retireSubscriber(int client_id)
+{
+    // client_mutex_ 안에서 불리므로 기록만 한다. 그때까지 발행이 이 id로 보내도 송신 스레드가 건너뛴다
+    std::lock_guard<std::mutex> lock(topics_mutex_);
+    retired_subscribers_.push_back(client_id);
+    retired_count_.store(retired_subscribers_.size(), std::memory_order_relaxed);
+}
+
+void TcpServer::purgeSubscribers()
+{
+    std::lock_guard<std::mutex> lock(topics_mutex_);
+    purgeSubscribersLocked();
+}
+
+void TcpServer::purgeSubscribersLocked()
+{
+    if (retired_subscribers_.empty())
+        return;
+    std::vector<int> retired;
+    retired.swap(retired_subscribers_);
+    retired_count_.store(0, std::memory_order_relaxed);
+    std::sort(retired.begin(), retired.end());
+
+    // 한꺼번에 끊겨도 맵 교체는 한 번, 영향받는 topic마다 구독자 목록도 한 번씩만 다시 만든다
+    std::vector<std::string> touched;
+    for (int client_id : retired)
+    {
+        auto ct = client_topics_.find(client_id);
+        if (ct == client_topics_.end())
+            continue;
+        for (std::string &topic : ct->second)
+            touched.push_back(std::move(topic));
+        client_topics_.erase(ct);
+    }
+    if (touched.empty())
+        return;
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+    auto next = std::make_shared<TopicMap>(*topics_);
+    for (const std::string &topic : touched)
+    {
+        auto it = next->find(topic);
+        if (it == next->end())
+            continue;
+        auto subs = std::make_shared<Subscribers>();
+        subs->reserve(it->second->size());
+        for (int client_id : *it->second)
+        {
+            if (!std::binary_search(retired.begin(), retired.end(), client_id))
+                subs->push_back(client_id);
+        }
+        if (subs->empty())
+            next->erase(it);
+        else
+            it->second = std::move(subs);
+    }
+    topics_ = std::move(next);
+    topics_version_.store(nextTopicsVersion(), std::memory_order_release);
+}
+
+size_t TcpServer::publish(const std::string &topic, const nlohmann::json &json)
+{
+    // 스레드마다 마지막으로 본 맵을 쥐고 있다가 버전이 바뀌었을 때만 락을 잡고 새로 받는다
+    // (쥐고 있는 동안은 구독 목록이 바뀌어도 이 목록이 유지된다. 옛 맵은 그 스레드가 다시 발행할 때 놓는다)
+    struct TopicsSnapshot
+    {
+        uint64_t version = 0;
+        std::shared_ptr<const TopicMap> topics;
+    };
+    thread_local TopicsSnapshot snapshot;
+    if (snapshot.version != topics_version_.load(std::memory_order_acquire))
+    {
+        std::lock_guard<std::mutex> lock(topics_mutex_);
+        snapshot.topics = topics_;
+        snapshot.version = topics_version_.load(std::memory_order_relaxed);
+    }
+    const TopicMap &topics = *snapshot.topics;
+    auto it = topics.find(topic);
+    if (it == topics.end())
+        return 0;
+    return fanOut(*it->second, json, std::make_shared<const std::string>(topic));
+}
+
+size_t TcpServer::broadcast(const nlohmann::json &json)
+{
+    Subscribers client_ids;
+    {
+        std::lock_guard<std::mutex> lock(client_mutex_);
+        client_ids.reserve(clients_.size());
+        for (auto &[client_id, conn] : clients_)
+            client_ids.push_back(client_id);
+    }
+    return fanOut(client_ids, json, nullptr);
+}
+
+size_t TcpServer::fanOut(const Subscribers &client_ids, const nlohmann::json &json, std::shared_ptr<const std::string> key)
+{
+    if (client_ids.empty())
+        return 0;
+    const std::vector<int> skipped = waitForOutboundRoom(client_ids); // PAUSE로 멈춘 연결 (핸들러 안에서만)
+
+    // 직렬화는 한 번. 송신 스레드는 구독자마다 같은 버퍼(와 key)를 그대로 쓴다
+    auto frame = std::make_shared<const std::string>(encodeFrame(json));
+    const int64_t now = monotonicNowNs();
+    std::vector<Message> out;
+    out.reserve(client_ids.size());
+    for (int client_id : client_ids)
+    {
+        if (!skipped.empty() && std::binary_search(skipped.begin(), skipped.end(), client_id))
+            continue;
+        Message msg{client_id, nullptr, 0, now, now};
+        msg.frame = frame;
+        msg.key = key;
+        out.push_back(std::move(msg));
+    }
+    const size_t queued = out.size();
+    send_queue_.pushAll(std::move(out));
+    metrics_.publish(queued);
+    return queued;
+}
+
+} // namespace msgnet
@@ -1,7 +1,9 @@
+#include <chrono>
 #include <queue>
 #include <mutex>
 #include <condition_variable>
 #include <optional>
+#include <vector>
 
 namespace msgnet
 {
@@ -31,6 +33,17 @@ public:
         cv_.notify_one();
     }
 
+    // 여러 개를 락 한 번으로 넣는다 (브로드캐스트 팬아웃)
+    void pushAll(std::vector<T> &&values)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (shutdown_)
+            return;
+        for (T &value : values)
+            queue_.push(std::move(value));
+        cv_.notify_all();
+    }
+
     // 블로킹 pop - move를 사용하여 불필요한 복사 제거
     std::optional<T> pop()
     {
@@ -44,6 +57,21 @@ public:
         return val;
     }
 
+    // 최대 timeout만큼 기다리는 pop. 시간 안에 못 받았거나 shutdown이면 nullopt
+    template <typename Rep, typename Period>
+    std::optional<T> pop_for(std::chrono::duration<Rep, Period> timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!cv_.wait_for(lock, timeout, [&]
+                          { return !queue_.empty() || shutdown_; }))
+            return std::nullopt;
+        if (shutdown_ && queue_.empty())
+            return std::nullopt;
+        T val = std::move(queue_.front());
+        queue_.pop();
+        return val;
+    }
+
     // 비블로킹 try_pop - 대기하지 않고 즉시 반환
     std::optional<T> try_pop()
     {
@@ -55,6 +83,16 @@ public:
         return val;
     }
 
+    // 맨 앞 원소를 꺼내지 않고 fn(front)를 돌려준다. 비었으면 empty_value
+    template <typename R, typename F>
+    R peek_front(R empty_value, F &&fn) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.empty())
+            return empty_value;
+        return fn(queue_.front());
+    }
+
     // 큐가 비어있는지 확인 (참고: 멀티스레드에서는 race condition 가능)
     bool empty() const
     {
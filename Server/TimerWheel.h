@@ -0,0 +1,240 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace msgnet
+{
+
+// 계층형 타이머 휠 (스레드 하나 전용, 락/시스템 콜 없음)
+// - tick 단위로 시간을 자르고 단계마다 64칸 (tick 10ms면 640ms / 41s / 44분 / 46시간, 그 이상은 마지막 단계에 둔다)
+// - schedule/cancel은 O(1): 노드는 slab에 두고 칸마다 이중 연결 리스트, 칸 점유는 단계별 64비트 비트맵
+// - advance(now)는 소유 스레드가 루프마다 부른다. 빈 구간은 비트맵으로 건너뛰고,
+//   0단계가 한 바퀴 돌 때마다 윗단계 칸 하나를 아래로 내린다
+// - 콜백 안에서 schedule/cancel을 불러도 된다
+class TimerWheel
+{
+public:
+    using Callback = std::function<void()>;
+    using TimerId = uint64_t; // 0은 무효
+
+    static constexpr int kLevels = 4;
+    static constexpr int kSlotBits = 6;
+    static constexpr uint64_t kSlots = 1u << kSlotBits;
+
+    TimerWheel(int64_t tick_ns, int64_t now_ns) : tick_ns_(tick_ns), base_ns_(now_ns)
+    {
+        for (auto &level : heads_)
+            level.fill(kNil);
+    }
+
+    TimerWheel(const TimerWheel &) = delete;
+    TimerWheel &operator=(const TimerWheel &) = delete;
+
+    // deadline_ns(monotonicNowNs 기준)에 cb를 부른다. 이미 지났으면 다음 tick에
+    TimerId schedule(int64_t deadline_ns, Callback cb)
+    {
+        uint32_t index;
+        if (free_ != kNil)
+        {
+            index = free_;
+            free_ = nodes_[index].next;
+        }
+        else
+        {
+            index = static_cast<uint32_t>(nodes_.size());
+            nodes_.emplace_back();
+        }
+
+        Node &n = nodes_[index];
+        const int64_t rel = deadline_ns - base_ns_;
+        const uint64_t tick = rel <= 0 ? 0 : static_cast<uint64_t>((rel + tick_ns_ - 1) / tick_ns_);
+        n.tick = std::max(tick, current_tick_ + 1);
+        n.active = true;
+        n.callback = std::move(cb);
+        link(index);
+        ++size_;
+        return (static_cast<uint64_t>(n.generation) << 32) | (index + 1);
+    }
+
+    // 아직 안 불린 타이머면 취소하고 true
+    bool cancel(TimerId id)
+    {
+        const uint32_t index = static_cast<uint32_t>(id & 0xffffffffu) - 1;
+        if (id == 0 || index >= nodes_.size())
+            return false;
+        Node &n = nodes_[index];
+        if (!n.active || n.generation != static_cast<uint32_t>(id >> 32))
+            return false;
+        unlink(index);
+        release(index);
+        return true;
+    }
+
+    // now_ns까지 만료된 타이머를 부른다. 부른 개수를 돌려준다
+    size_t advance(int64_t now_ns)
+    {
+        if (now_ns < base_ns_)
+            return 0;
+        const uint64_t target = static_cast<uint64_t>((now_ns - base_ns_) / tick_ns_);
+        size_t fired = 0;
+        while (current_tick_ < target)
+        {
+            // 0단계가 비어 있으면 한 바퀴 끝(윗단계를 내릴 지점) 직전까지 건너뛴다
+            if (occupied_[0] == 0)
+            {
+                const uint64_t last_in_round = current_tick_ | (kSlots - 1);
+                if (last_in_round > current_tick_)
+                {
+                    current_tick_ = std::min(target, last_in_round);
+                    if (size_ == 0)
+                    {
+                        current_tick_ = target;
+                        break;
+                    }
+                    continue;
+                }
+            }
+
+            ++current_tick_;
+            cascade();
+            fired += fire(static_cast<uint32_t>(current_tick_ & (kSlots - 1)));
+        }
+        return fired;
+    }
+
+    // 다음에 advance를 불러야 할 때까지 남은 시간 (ns). 타이머가 없으면 -1
+    // 0단계에 다음 타이머가 없으면 윗단계를 내릴 한 바퀴 끝까지 (그 이상 자지 않는다)
+    int64_t nextTimeoutNs(int64_t now_ns) const
+    {
+        if (size_ == 0)
+            return -1;
+        const uint64_t pos = current_tick_ & (kSlots - 1);
+        const uint64_t ahead = pos + 1 < kSlots ? occupied_[0] >> (pos + 1) : 0;
+        const uint64_t ticks = ahead ? static_cast<uint64_t>(std::countr_zero(ahead)) + 1 : kSlots - pos;
+        const int64_t at = base_ns_ + static_cast<int64_t>(current_tick_ + ticks) * tick_ns_;
+        return std::max<int64_t>(0, at - now_ns);
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+private:
+    static constexpr uint32_t kNil = UINT32_MAX;
+
+    struct Node
+    {
+        uint64_t tick = 0;
+        uint32_t next = kNil;
+        uint32_t prev = kNil;
+        uint32_t generation = 0;
+        uint8_t level = 0;
+        uint8_t slot = 0;
+        bool active = false;
+        Callback callback;
+    };
+
+    void link(uint32_t index)
+    {
+        Node &n = nodes_[index];
+        const uint64_t delta = n.tick - current_tick_;
+        int level = 0;
+        while (level + 1 < kLevels && delta >= (uint64_t{1} << (kSlotBits * (level + 1))))
+            ++level;
+        // 마지막 단계보다 먼 타이머는 그 단계 범위 끝에 두고, 내려올 때 다시 자리를 찾는다
+        const uint64_t tick = level == kLevels - 1 ? std::min(n.tick, current_tick_ + (uint64_t{1} << (kSlotBits * kLevels)) - 1)
+                                                   : n.tick;
+        const uint32_t slot = static_cast<uint32_t>((tick >> (kSlotBits * level)) & (kSlots - 1));
+
+        n.level = static_cast<uint8_t>(level);
+        n.slot = static_cast<uint8_t>(slot);
+        n.prev = kNil;
+        n.next = heads_[level][slot];
+        if (n.next != kNil)
+            nodes_[n.next].prev = index;
+        heads_[level][slot] = index;
+        occupied_[level] |= uint64_t{1} << slot;
+    }
+
+    void unlink(uint32_t index)
+    {
+        Node &n = nodes_[index];
+        if (n.prev != kNil)
+            nodes_[n.prev].next = n.next;
+        else
+            heads_[n.level][n.slot] = n.next;
+        if (n.next != kNil)
+            nodes_[n.next].prev = n.prev;
+        if (heads_[n.level][n.slot] == kNil)
+            occupied_[n.level] &= ~(uint64_t{1} << n.slot);
+    }
+
+    void release(uint32_t index)
+    {
+        Node &n = nodes_[index];
+        n.active = false;
+        n.callback = nullptr;
+        ++n.generation;
+        n.next = free_;
+        free_ = index;
+        --size_;
+    }
+
+    // 아랫단계가 한 바퀴를 돌았으면 윗단계의 현재 칸을 풀어서 다시 넣는다
+    void cascade()
+    {
+        for (int level = 1; level < kLevels; ++level)
+        {
+            if ((current_tick_ & ((uint64_t{1} << (kSlotBits * level)) - 1)) != 0)
+                break;
+            const uint32_t slot = static_cast<uint32_t>((current_tick_ >> (kSlotBits * level)) & (kSlots - 1));
+            uint32_t index = heads_[level][slot];
+            heads_[level][slot] = kNil;
+            occupied_[level] &= ~(uint64_t{1} << slot);
+            while (index != kNil)
+            {
+                const uint32_t next = nodes_[index].next;
+                link(index);
+                index = next;
+            }
+        }
+    }
+
+    size_t fire(uint32_t slot)
+    {
+        // 칸 맨 앞부터 하나씩 떼어내며 부른다 (콜백이 같은 칸의 다른 타이머를 취소해도 안전)
+        // 콜백이 새로 넣는 타이머는 다음 tick 이후라 이 칸에 들어오지 않는다
+        size_t fired = 0;
+        uint32_t index;
+        while ((index = heads_[0][slot]) != kNil)
+        {
+            unlink(index);
+            if (nodes_[index].tick > current_tick_)
+            {
+                link(index); // 마지막 단계에서 범위 끝에 맞춰 둔 먼 타이머
+                continue;
+            }
+            Callback cb = std::move(nodes_[index].callback);
+            release(index);
+            cb();
+            ++fired;
+        }
+        return fired;
+    }
+
+    int64_t tick_ns_;
+    int64_t base_ns_;
+    uint64_t current_tick_ = 0;
+    size_t size_ = 0;
+    uint32_t free_ = kNil;
+    std::vector<Node> nodes_;
+    std::array<std::array<uint32_t, kSlots>, kLevels> heads_;
+    std::array<uint64_t, kLevels> occupied_{};
+};
+
+} // namespace msgnet
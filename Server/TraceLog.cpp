@@ -0,0 +1,219 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define MSGNET_TRACE_HAS_TSC 1
+#endif
+
+#include "TraceLog.h"
+
+namespace msgnet
+{
+
+namespace
+{
+
+// 스레드별 예약 구간 [next, end)
+struct TraceChunk
+{
+    uint64_t generation = 0;
+    uint64_t next = 0;
+    uint64_t end = 0;
+};
+
+thread_local TraceChunk t_chunk;
+
+std::atomic<uint64_t> g_trace_generation{1};
+
+uint64_t monotonicNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+#ifdef MSGNET_TRACE_HAS_TSC
+// invariant TSC (CPUID 0x80000007 EDX bit 8)일 때만 TSC 사용
+bool hasInvariantTsc()
+{
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+        return false;
+    return (edx & (1u << 8)) != 0;
+}
+#endif
+
+size_t roundUpPow2(size_t v)
+{
+    size_t p = 1;
+    while (p < v)
+        p <<= 1;
+    return p;
+}
+
+} // namespace
+
+TraceLog::~TraceLog()
+{
+    close();
+}
+
+bool TraceLog::open(const TraceLogConfig &config)
+{
+    close();
+
+    const size_t capacity = roundUpPow2(config.capacity < 1024 ? 1024 : config.capacity);
+    const size_t size = sizeof(TraceFileHeader) + capacity * sizeof(TraceRecord);
+
+    fd_ = ::open(config.path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+    {
+        perror("open trace file");
+        return false;
+    }
+    if (::ftruncate(fd_, static_cast<off_t>(size)) < 0)
+    {
+        perror("ftruncate trace file");
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    map_ = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map_ == MAP_FAILED)
+    {
+        perror("mmap trace file");
+        map_ = nullptr;
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    map_size_ = size;
+
+    header_ = static_cast<TraceFileHeader *>(map_);
+    records_ = reinterpret_cast<TraceRecord *>(static_cast<char *>(map_) + sizeof(TraceFileHeader));
+    mask_ = capacity - 1;
+
+    // 클럭 선택 및 보정
+    use_tsc_ = false;
+    double ns_per_tick = 1.0;
+#ifdef MSGNET_TRACE_HAS_TSC
+    if (hasInvariantTsc())
+    {
+        uint64_t ns0 = monotonicNs();
+        uint64_t tsc0 = __rdtsc();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        uint64_t ns1 = monotonicNs();
+        uint64_t tsc1 = __rdtsc();
+        if (tsc1 > tsc0)
+        {
+            ns_per_tick = static_cast<double>(ns1 - ns0) / static_cast<double>(tsc1 - tsc0);
+            use_tsc_ = true;
+        }
+    }
+#endif
+
+    std::memcpy(header_->magic, TraceFileHeader::kMagic, sizeof(header_->magic));
+    header_->version = TraceFileHeader::kVersion;
+    header_->record_size = sizeof(TraceRecord);
+    header_->capacity = capacity;
+    header_->clock = static_cast<uint32_t>(use_tsc_ ? TraceClock::TSC : TraceClock::MONOTONIC_NS);
+    header_->ns_per_tick = ns_per_tick;
+    header_->ts_at_open = now();
+    header_->wall_ns_at_open = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::system_clock::now().time_since_epoch())
+                                   .count();
+    header_->head.store(0, std::memory_order_relaxed);
+
+    generation_.store(g_trace_generation.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+    enabled_.store(true, std::memory_order_release);
+    return true;
+}
+
+void TraceLog::close()
+{
+    enabled_.store(false, std::memory_order_release);
+    if (map_)
+    {
+        ::msync(map_, map_size_, MS_ASYNC);
+        ::munmap(map_, map_size_);
+        map_ = nullptr;
+        header_ = nullptr;
+        records_ = nullptr;
+    }
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+uint64_t TraceLog::now() const
+{
+#ifdef MSGNET_TRACE_HAS_TSC
+    if (use_tsc_)
+        return __rdtsc();
+#endif
+    return monotonicNs();
+}
+
+void TraceLog::record(TraceEvent event, int client_id, uint64_t req_hash, uint64_t arg)
+{
+    const uint64_t gen = generation_.load(std::memory_order_relaxed);
+    TraceChunk &chunk = t_chunk;
+    if (chunk.generation != gen || chunk.next == chunk.end)
+    {
+        chunk.next = header_->head.fetch_add(kChunk, std::memory_order_relaxed);
+        chunk.end = chunk.next + kChunk;
+        chunk.generation = gen;
+    }
+
+    const uint64_t index = chunk.next++;
+    TraceRecord &rec = records_[index & mask_];
+    rec.ts = now();
+    rec.event = static_cast<uint16_t>(event);
+    rec.reserved = 0;
+    rec.client_id = client_id;
+    rec.arg = arg > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(arg);
+    rec.req_hash = req_hash;
+    // seq를 마지막에 기록해서 디코더가 완성된 레코드만 받아들이게 한다
+    std::atomic_ref<uint32_t>(rec.seq).store(static_cast<uint32_t>(index + 1), std::memory_order_release);
+}
+
+uint64_t TraceLog::hashString(std::string_view s)
+{
+    // FNV-1a 64
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : s)
+    {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+uint64_t TraceLog::hashReqId(const nlohmann::json &req)
+{
+    if (!req.is_object())
+        return 0;
+    auto it = req.find("req_id");
+    if (it == req.end())
+        return 0;
+    if (it->is_string())
+        return hashString(it->get_ref<const std::string &>());
+    if (it->is_number_unsigned())
+        return it->get<uint64_t>();
+    if (it->is_number_integer())
+        return static_cast<uint64_t>(it->get<int64_t>());
+    return hashString(it->dump());
+}
+
+} // namespace msgnet
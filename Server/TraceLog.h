@@ -0,0 +1,142 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "json.hpp"
+
+namespace msgnet
+{
+
+// 메시지 단위 이벤트 ID (파일 포맷의 일부이므로 값을 바꾸지 말 것)
+enum class TraceEvent : uint16_t
+{
+    CONNECT = 1,        // arg: listen port
+    DISCONNECT = 2,     // arg: ExceptionType
+    RECV = 3,           // arg: payload bytes
+    PARSE_ERROR = 4,    // arg: payload bytes
+    DISPATCH_BEGIN = 5, // arg: 0
+    DISPATCH_END = 6,   // arg: 응답의 ok 값 (1/0)
+    SEND = 7,           // arg: frame bytes
+    SEND_FAILED = 8,    // arg: frame bytes
+};
+
+inline const char *traceEventName(uint16_t event)
+{
+    switch (static_cast<TraceEvent>(event))
+    {
+    case TraceEvent::CONNECT:
+        return "CONNECT";
+    case TraceEvent::DISCONNECT:
+        return "DISCONNECT";
+    case TraceEvent::RECV:
+        return "RECV";
+    case TraceEvent::PARSE_ERROR:
+        return "PARSE_ERROR";
+    case TraceEvent::DISPATCH_BEGIN:
+        return "DISPATCH_BEGIN";
+    case TraceEvent::DISPATCH_END:
+        return "DISPATCH_END";
+    case TraceEvent::SEND:
+        return "SEND";
+    case TraceEvent::SEND_FAILED:
+        return "SEND_FAILED";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+// 고정 크기 레코드 (32 bytes)
+struct TraceRecord
+{
+    uint64_t ts;       // 원시 타임스탬프 (TSC tick 또는 monotonic ns, 헤더의 clock 참고)
+    uint32_t seq;      // 전역 슬롯 번호 + 1의 하위 32비트 (미기록/이전 바퀴 슬롯 판별용)
+    uint16_t event;    // TraceEvent
+    uint16_t reserved;
+    int32_t client_id;
+    uint32_t arg;      // 이벤트별 부가 값 (TraceEvent 주석 참고, 32비트로 포화)
+    uint64_t req_hash; // req_id 해시 (없으면 0)
+};
+static_assert(sizeof(TraceRecord) == 32, "TraceRecord must stay 32 bytes");
+
+enum class TraceClock : uint32_t
+{
+    MONOTONIC_NS = 0,
+    TSC = 1,
+};
+
+// mmap 파일 헤더 (4096 bytes). 레코드 링은 헤더 바로 뒤에 이어진다.
+struct TraceFileHeader
+{
+    static constexpr char kMagic[8] = {'M', 'S', 'G', 'T', 'R', 'C', '1', '\0'};
+    static constexpr uint32_t kVersion = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t capacity;         // 레코드 수 (2의 거듭제곱)
+    uint32_t clock;            // TraceClock
+    uint32_t pad0;
+    double ns_per_tick;        // ts → ns 변환 계수
+    uint64_t ts_at_open;       // 열 때의 원시 타임스탬프
+    int64_t wall_ns_at_open;   // 열 때의 system_clock epoch ns
+    std::atomic<uint64_t> head; // 지금까지 예약된 슬롯 수
+    char pad1[4096 - 64];
+};
+static_assert(sizeof(TraceFileHeader) == 4096, "TraceFileHeader must stay one page");
+
+struct TraceLogConfig
+{
+    std::string path;
+    size_t capacity = 1 << 20; // 레코드 수 (2의 거듭제곱으로 올림, 기본 32MB)
+};
+
+// 바이너리 이벤트 트레이스
+// - mmap된 링 파일에 고정 크기 레코드를 기록한다 (프로세스가 죽어도 페이지 캐시에 남음)
+// - 스레드는 슬롯을 kChunk개씩 한 번에 예약해서 공유 카운터 경합을 줄인다
+// - 오프라인에서 trace_decode로 텍스트/JSON lines로 변환한다
+class TraceLog
+{
+public:
+    static constexpr uint32_t kChunk = 64;
+
+    TraceLog() = default;
+    ~TraceLog();
+
+    TraceLog(const TraceLog &) = delete;
+    TraceLog &operator=(const TraceLog &) = delete;
+
+    bool open(const TraceLogConfig &config);
+    // 매핑을 해제하므로 record()를 부를 수 있는 스레드가 모두 멈춘 뒤에 호출해야 한다
+    // (enabled()를 확인한 직후의 record()를 막을 방법이 없다)
+    void close();
+
+    // open()이 release로 게시한 header_/records_/mask_를 함께 보도록 acquire
+    bool enabled() const { return enabled_.load(std::memory_order_acquire); }
+
+    // enabled()가 true를 돌려준 뒤에만 부른다
+    void record(TraceEvent event, int client_id, uint64_t req_hash, uint64_t arg);
+
+    // 원시 타임스탬프 (헤더의 clock 단위)
+    uint64_t now() const;
+
+    // req_id(문자열/숫자)를 64비트 해시로 변환
+    static uint64_t hashReqId(const nlohmann::json &req);
+    static uint64_t hashString(std::string_view s);
+
+private:
+    std::atomic<bool> enabled_{false};
+    std::atomic<uint64_t> generation_{0};
+
+    int fd_ = -1;
+    void *map_ = nullptr;
+    size_t map_size_ = 0;
+    TraceFileHeader *header_ = nullptr;
+    TraceRecord *records_ = nullptr;
+    uint64_t mask_ = 0;
+    bool use_tsc_ = false;
+};
+
+} // namespace msgnet
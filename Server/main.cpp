@@ -1,8 +1,14 @@
 // main.cpp
 #include <atomic>
 #include <csignal>
+#include <cstdlib>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
 
 #include "TcpServer.h" 
 #include "json.hpp"
@@ -13,35 +19,284 @@ using namespace std::chrono;
 using namespace msgnet;
 
 static std::atomic<bool> g_run{true};
+static int g_wake_fd = -1; // 메인 스레드를 깨우는 eventfd (신호 처리기에서 write는 async-signal-safe)
+
+static void wakeMain()
+{
+    uint64_t one = 1;
+    ssize_t ignored = ::write(g_wake_fd, &one, sizeof(one));
+    (void)ignored;
+}
 
 static void onSignal(int)
 {
     g_run = false;
+    wakeMain();
+}
+
+static void logLatency(const char *stage, const msgnet::LatencySummary &s)
+{
+    if (s.count == 0)
+        return;
+    LOG_INFO("[Stats] ", stage, ": count=", s.count,
+             " p50=", s.p50_ns / 1000.0, "us p99=", s.p99_ns / 1000.0,
+             "us p999=", s.p999_ns / 1000.0, "us max=", s.max_ns / 1000.0, "us");
+}
+
+// 리스닝 주소 목록: "55000", "55001-56000", "55001,55002", "127.0.0.1:55001-55010",
+// "unix:/tmp/msgnet.sock", "@msgnet" (abstract) — 쉼표로 섞어서 지정 가능
+static std::vector<msgnet::ListenAddress> parseListenSpec(const std::string &spec)
+{
+    std::vector<msgnet::ListenAddress> out;
+    size_t pos = 0;
+    while (pos <= spec.size())
+    {
+        size_t comma = spec.find(',', pos);
+        std::string item = spec.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        if (item.rfind("unix:", 0) == 0 || item.rfind("@", 0) == 0)
+        {
+            msgnet::ListenAddress la;
+            la.host.clear();
+            la.unix_path = item[0] == '@' ? item : item.substr(5);
+            out.push_back(std::move(la));
+        }
+        else if (!item.empty())
+        {
+            std::string host = "0.0.0.0";
+            size_t colon = item.rfind(':');
+            if (colon != std::string::npos)
+            {
+                host = item.substr(0, colon);
+                item = item.substr(colon + 1);
+            }
+            size_t dash = item.find('-');
+            int first = std::stoi(item.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+            for (int p = first; p <= last; ++p)
+                out.push_back({host, p, ""});
+        }
+        if (comma == std::string::npos)
+            break;
+        pos = comma + 1;
+    }
+    return out;
+}
+
+// 리스너 + 클라이언트 수만큼 fd가 필요하므로 soft limit을 hard limit까지 올린다
+static void raiseFdLimit()
+{
+    rlimit rl{};
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max)
+    {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+}
+
+static void logStats(const msgnet::TcpServerStats &stats)
+{
+    logLatency("recv->enqueue", stats.recv_to_enqueue);
+    logLatency("recv_queue wait", stats.recv_queue_wait);
+    for (auto &[type, s] : stats.handler)
+        logLatency(("handler " + type).c_str(), s);
+    logLatency("send_queue wait", stats.send_queue_wait);
+    logLatency("serialize+send", stats.send);
+    LOG_INFO("[Stats] process threads: ", stats.process_threads);
 }
 
 int initServer(int argc, char **argv)
 {
-    // 포트 입력 (기본 55000)
-    int port = 55000;
+    // 포트 입력 (기본 55000). 범위/목록을 주면 한 프로세스가 모든 포트를 연다 (예: 55001-56000)
+    std::string listen_spec = "55000";
     if (argc >= 2)
     {
-        port = std::stoi(argv[1]);
+        listen_spec = argv[1];
     }
 
     // SIGINT(Ctrl+C), SIGTERM 처리
+    g_wake_fd = ::eventfd(0, EFD_CLOEXEC);
+    if (g_wake_fd < 0)
+    {
+        perror("eventfd");
+        return 1;
+    }
     signal(SIGINT, onSignal);
     signal(SIGTERM, onSignal);
 
     try
     {
         // 서버 객체 생성
-        msgnet::TcpServer server(port);
+        const std::vector<msgnet::ListenAddress> listen_addresses = parseListenSpec(listen_spec);
+        if (listen_addresses.empty())
+        {
+            LOG_ERROR("[Server] No listen port in '", listen_spec, "'");
+            return 1;
+        }
+        raiseFdLimit();
+
+        msgnet::TcpServer server;
+        for (const auto &la : listen_addresses)
+        {
+            if (la.isUnix())
+                server.addListenUnixPath(la.unix_path);
+            else
+                server.addListenAddress(la.host, la.port);
+        }
 
         // 로그 레벨 설정 (DEBUG, INFO, WARN, ERROR)
         server.setLogLevel(msgnet::LogLevel::DEBUG);
 
+        // MSGNET_LOG_FILE이 지정되면 비동기 로거로 파일에 기록 (핫 패스에서 콘솔 flush 제거)
+        if (const char *log_file = std::getenv("MSGNET_LOG_FILE"))
+        {
+            if (!Logger::instance().startAsync(msgnet::AsyncLogConfig{.path = log_file}))
+                LOG_WARN("[Server] Failed to open log file ", log_file, ", logging to console");
+        }
+
+        // MSGNET_TRACE_FILE이 지정되면 메시지 단위 바이너리 트레이스 기록 (trace_decode로 확인)
+        if (const char *trace_file = std::getenv("MSGNET_TRACE_FILE"))
+        {
+            if (!Logger::instance().startTrace(msgnet::TraceLogConfig{.path = trace_file}))
+                LOG_WARN("[Server] Failed to open trace file ", trace_file);
+        }
+
         server.setRecvThreadCount(1);
 
+        // MSGNET_ADMIN_PORT가 지정되면 Prometheus 메트릭 엔드포인트 (GET /metrics)
+        if (const char *admin_port = std::getenv("MSGNET_ADMIN_PORT"))
+        {
+            server.setAdminPort(std::stoi(admin_port));
+        }
+
+        // 느린 수신자 정책: MSGNET_SLOW_CONSUMER=disconnect|drop_oldest|coalesce|pause,
+        // MSGNET_OUTBOUND_MAX_BYTES=연결별 송신 대기 바이트 상한
+        {
+            msgnet::OutboundLimits limits;
+            if (const char *policy = std::getenv("MSGNET_SLOW_CONSUMER"))
+            {
+                if (!msgnet::parseSlowConsumerPolicy(policy, limits.policy))
+                    LOG_WARN("[Server] Unknown MSGNET_SLOW_CONSUMER '", policy, "', using disconnect");
+            }
+            if (const char *max_bytes = std::getenv("MSGNET_OUTBOUND_MAX_BYTES"))
+                limits.max_bytes = std::stoull(max_bytes);
+            server.setOutboundLimits(limits);
+        }
+
+        // 연결 타이머: MSGNET_IDLE_TIMEOUT_MS, MSGNET_HEARTBEAT_MS, MSGNET_WRITE_STALL_MS (0이면 끔)
+        {
+            msgnet::ConnectionTimeouts timeouts;
+            if (const char *v = std::getenv("MSGNET_IDLE_TIMEOUT_MS"))
+                timeouts.idle_timeout_ms = std::stoi(v);
+            if (const char *v = std::getenv("MSGNET_HEARTBEAT_MS"))
+                timeouts.heartbeat_interval_ms = std::stoi(v);
+            if (const char *v = std::getenv("MSGNET_WRITE_STALL_MS"))
+                timeouts.write_stall_timeout_ms = std::stoi(v);
+            server.setConnectionTimeouts(timeouts);
+        }
+
+        // 입장 제어: MSGNET_SHED_TARGET_MS=큐 대기 목표 (0이면 끔), MSGNET_SHED_INTERVAL_MS=판단 구간
+        {
+            msgnet::AdmissionConfig admission;
+            if (const char *v = std::getenv("MSGNET_SHED_TARGET_MS"))
+                admission.target_ms = std::stoi(v);
+            if (const char *v = std::getenv("MSGNET_SHED_INTERVAL_MS"))
+                admission.interval_ms = std::stoi(v);
+            server.setAdmissionControl(admission);
+        }
+
+        // 요청 수 제한: MSGNET_RATE_LIMIT=초당요청[:버스트] (연결별), MSGNET_RATE_LIMIT_TYPES=type=초당[:버스트],...,
+        // MSGNET_RATE_LIMIT_ACTION=reject|delay|disconnect
+        {
+            auto parse_limit = [](const std::string &spec)
+            {
+                msgnet::RateLimit limit;
+                const size_t colon = spec.find(':');
+                limit.rate = std::stod(spec.substr(0, colon));
+                if (colon != std::string::npos)
+                    limit.burst = std::stod(spec.substr(colon + 1));
+                return limit;
+            };
+            msgnet::RateLimits limits;
+            if (const char *v = std::getenv("MSGNET_RATE_LIMIT"))
+                limits.per_connection = parse_limit(v);
+            if (const char *v = std::getenv("MSGNET_RATE_LIMIT_TYPES"))
+            {
+                std::stringstream ss(v);
+                std::string item;
+                while (std::getline(ss, item, ','))
+                {
+                    const size_t eq = item.find('=');
+                    if (eq != std::string::npos)
+                        limits.per_type[item.substr(0, eq)] = parse_limit(item.substr(eq + 1));
+                }
+            }
+            if (const char *action = std::getenv("MSGNET_RATE_LIMIT_ACTION"))
+            {
+                if (!msgnet::parseRateLimitAction(action, limits.action))
+                    LOG_WARN("[Server] Unknown MSGNET_RATE_LIMIT_ACTION '", action, "', using reject");
+            }
+            server.setRateLimits(limits);
+        }
+
+        // 처리 스레드 자동 조절: MSGNET_PROCESS_THREADS_MIN/MAX (MAX가 MIN보다 크면 켜짐),
+        // MSGNET_PROCESS_GROW_WAIT_MS=늘리는 큐 대기 기준, MSGNET_PROCESS_SHRINK_IDLE_MS=줄이는 유휴 기준
+        {
+            msgnet::ProcessPoolLimits pool;
+            if (const char *v = std::getenv("MSGNET_PROCESS_THREADS_MIN"))
+                pool.min_threads = std::stoi(v);
+            if (const char *v = std::getenv("MSGNET_PROCESS_THREADS_MAX"))
+                pool.max_threads = std::stoi(v);
+            if (const char *v = std::getenv("MSGNET_PROCESS_GROW_WAIT_MS"))
+                pool.grow_wait_ms = std::stoi(v);
+            if (const char *v = std::getenv("MSGNET_PROCESS_SHRINK_IDLE_MS"))
+                pool.shrink_idle_ms = std::stoi(v);
+            server.setProcessPoolLimits(pool);
+        }
+
+        // CPU 고정: MSGNET_CPUS_{ACCEPT,RECV,PROCESS,SEND}=0-3,8 형식 (역할의 i번째 스레드는 i번째 코어)
+        // MSGNET_CPUS_RECV를 주면 recv 스레드를 코어마다 하나씩 둔다. MSGNET_STEER_INCOMING_CPU=1이면 새 연결을
+        // SO_INCOMING_CPU 코어(없으면 같은 NUMA 노드)의 recv 스레드로 보낸다
+        {
+            msgnet::CpuAffinity affinity;
+            const std::pair<const char *, std::vector<int> *> roles[] = {
+                {"MSGNET_CPUS_ACCEPT", &affinity.accept},
+                {"MSGNET_CPUS_RECV", &affinity.recv},
+                {"MSGNET_CPUS_PROCESS", &affinity.process},
+                {"MSGNET_CPUS_SEND", &affinity.send},
+            };
+            for (const auto &[name, cpus] : roles)
+            {
+                const char *v = std::getenv(name);
+                if (v && !msgnet::parseCpuList(v, *cpus))
+                    LOG_WARN("[Server] Invalid ", name, " '", v, "', not pinning");
+            }
+            if (const char *v = std::getenv("MSGNET_STEER_INCOMING_CPU"))
+                affinity.steer_incoming_cpu = std::string(v) == "1";
+            if (!affinity.recv.empty())
+                server.setRecvThreadCount(static_cast<int>(affinity.recv.size()));
+            server.setCpuAffinity(affinity);
+        }
+
+        // 클라이언트 발행: MSGNET_CLIENT_PUBLISH=1이면 내장 메시지 "publish"를 받는다 (subscribe/unsubscribe는 항상)
+        if (const char *v = std::getenv("MSGNET_CLIENT_PUBLISH"))
+            server.setClientPublishEnabled(std::string(v) == "1");
+
+        // 공유 메모리 링 크기: MSGNET_SHM_RING_BYTES (방향별, 2의 거듭제곱. 이보다 큰 프레임은 shm으로 못 보낸다)
+        if (const char *v = std::getenv("MSGNET_SHM_RING_BYTES"))
+            server.setShmRingBytes(std::stoull(v));
+
+        // 무중단 재시작: MSGNET_HANDOFF_PATH=이 경로로 접속한 새 프로세스에 리스너를 넘김,
+        // MSGNET_INHERIT_FROM=시작할 때 이전 프로세스의 handoff 경로에서 리스너를 받음 (보통 둘 다 같은 경로)
+        if (const char *v = std::getenv("MSGNET_HANDOFF_PATH"))
+            server.setHandoffPath(v);
+        if (const char *v = std::getenv("MSGNET_INHERIT_FROM"))
+            server.setInheritFrom(v);
+        server.setHandoffProbe(wakeMain);
+        // 종료 시 drain 제한 시간: MSGNET_DRAIN_MS (기본 10초, 0이면 바로 멈춤)
+        int drain_ms = 10000;
+        if (const char *v = std::getenv("MSGNET_DRAIN_MS"))
+            drain_ms = std::stoi(v);
+
         msgnet::ExampleMessageHandler handler;
         server.addMessageHandler("ping", msgnet::ExampleMessageHandler::handlePing);
         server.addMessageHandler("echo", msgnet::ExampleMessageHandler::handleEcho);
@@ -51,6 +306,7 @@ int initServer(int argc, char **argv)
         server.setStartProbe([](const msgnet::TcpServerConfig &config)
         {
             LOG_INFO("[Probe] Server started on port ", config.port,
+                     " (", config.listen_ports.size(), " listeners)",
                      " with ", config.accept_thread_count, " accept threads, ",
                      config.recv_thread_count, " recv threads, ",
                      config.process_thread_count, " process threads, ",
@@ -68,20 +324,42 @@ int initServer(int argc, char **argv)
         });
 
         // 서버 시작
-        server.start();
+        if (!server.start())
+        {
+            LOG_ERROR("[Server] Failed to start on ", listen_spec);
+            return 1;
+        }
 
-        LOG_INFO("[Server] Listening on port ", port);
+        LOG_INFO("[Server] Listening on ", listen_spec);
         LOG_INFO("[Server] Press Ctrl+C to stop.");
 
-        // 메인 루프: 신호 대기
-        while (g_run.load())
+        // 메인 루프: 신호 또는 새 프로세스로 리스너를 넘길 때까지 잠든다 (둘 다 g_wake_fd로 깨운다)
+        while (g_run.load() && !server.handedOff())
         {
-            this_thread::sleep_for(milliseconds(200));
+            uint64_t v;
+            ssize_t ignored = ::read(g_wake_fd, &v, sizeof(v));
+            (void)ignored;
         }
 
-        LOG_INFO("[Server] Stopping...");
-        server.stop();
+        if (server.handedOff())
+            LOG_INFO("[Server] Listeners handed off, draining...");
+        else
+            LOG_INFO("[Server] Stopping...");
+        if (drain_ms > 0)
+        {
+            if (!server.drain(drain_ms))
+                LOG_WARN("[Server] Drain did not finish within ", drain_ms, "ms");
+        }
+        else
+        {
+            server.stop();
+        }
+        logStats(server.stats());
         LOG_INFO("[Server] Stopped.");
+        if (uint64_t dropped = Logger::instance().droppedCount())
+            LOG_WARN("[Server] Dropped log records: ", dropped);
+        Logger::instance().stopTrace();
+        Logger::instance().stopAsync();
         return 0;
     }
     catch (const std::exception &e)
@@ -0,0 +1,146 @@
+// trace_decode: TraceLog 바이너리 링 파일을 텍스트 또는 JSON lines로 변환한다.
+//
+// 사용법: trace_decode [--json] <trace_file>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "TraceLog.h"
+
+using namespace std;
+using namespace msgnet;
+
+static void usage(const char *prog)
+{
+    cerr << "Usage: " << prog << " [--json] <trace_file>\n";
+}
+
+static string formatWall(int64_t wall_ns)
+{
+    time_t sec = static_cast<time_t>(wall_ns / 1000000000);
+    tm tm{};
+    localtime_r(&sec, &tm);
+    char buf[64];
+    size_t n = strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+    snprintf(buf + n, sizeof(buf) - n, ".%09lld", static_cast<long long>(wall_ns % 1000000000));
+    return buf;
+}
+
+int main(int argc, char **argv)
+{
+    bool json_out = false;
+    const char *path = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--json") == 0)
+            json_out = true;
+        else if (!path)
+            path = argv[i];
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!path)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        perror("open");
+        return 1;
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(TraceFileHeader))
+    {
+        cerr << "Not a trace file (too small): " << path << "\n";
+        ::close(fd);
+        return 1;
+    }
+
+    void *map = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+    {
+        perror("mmap");
+        ::close(fd);
+        return 1;
+    }
+
+    const auto *header = static_cast<const TraceFileHeader *>(map);
+    if (memcmp(header->magic, TraceFileHeader::kMagic, sizeof(header->magic)) != 0 ||
+        header->version != TraceFileHeader::kVersion ||
+        header->record_size != sizeof(TraceRecord) ||
+        sizeof(TraceFileHeader) + header->capacity * sizeof(TraceRecord) > static_cast<size_t>(st.st_size))
+    {
+        cerr << "Invalid or unsupported trace file: " << path << "\n";
+        ::munmap(map, st.st_size);
+        ::close(fd);
+        return 1;
+    }
+
+    const auto *records = reinterpret_cast<const TraceRecord *>(
+        static_cast<const char *>(map) + sizeof(TraceFileHeader));
+    const uint64_t capacity = header->capacity;
+    const uint64_t mask = capacity - 1;
+    const uint64_t head = header->head.load(std::memory_order_acquire);
+    const uint64_t first = head > capacity ? head - capacity : 0;
+
+    // 유효한(완성된, 현재 바퀴의) 레코드만 모아서 시간순 정렬
+    vector<TraceRecord> valid;
+    valid.reserve(static_cast<size_t>(head - first));
+    for (uint64_t idx = first; idx < head; ++idx)
+    {
+        const TraceRecord &rec = records[idx & mask];
+        if (rec.seq == static_cast<uint32_t>(idx + 1))
+            valid.push_back(rec);
+    }
+    stable_sort(valid.begin(), valid.end(),
+                [](const TraceRecord &a, const TraceRecord &b)
+                { return a.ts < b.ts; });
+
+    const char *clock_name = header->clock == static_cast<uint32_t>(TraceClock::TSC) ? "tsc" : "monotonic";
+    cerr << "[trace_decode] " << valid.size() << " records (reserved=" << head
+         << ", capacity=" << capacity << ", clock=" << clock_name << ")\n";
+
+    for (const TraceRecord &rec : valid)
+    {
+        const double delta_ns = (static_cast<double>(rec.ts) - static_cast<double>(header->ts_at_open)) * header->ns_per_tick;
+        const int64_t wall_ns = header->wall_ns_at_open + static_cast<int64_t>(delta_ns);
+        char hash[24];
+        snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(rec.req_hash));
+
+        if (json_out)
+        {
+            cout << "{\"ts_ns\":" << wall_ns
+                 << ",\"time\":\"" << formatWall(wall_ns) << "\""
+                 << ",\"event\":\"" << traceEventName(rec.event) << "\""
+                 << ",\"client_id\":" << rec.client_id
+                 << ",\"req_hash\":\"" << hash << "\""
+                 << ",\"arg\":" << rec.arg << "}\n";
+        }
+        else
+        {
+            char line[160];
+            snprintf(line, sizeof(line), "%s %-14s client=%d req=%s arg=%u\n",
+                     formatWall(wall_ns).c_str(), traceEventName(rec.event), rec.client_id, hash, rec.arg);
+            cout << line;
+        }
+    }
+
+    ::munmap(map, st.st_size);
+    ::close(fd);
+    return 0;
+}
@@ -7,6 +7,9 @@ MODE=${1:-all}   # clean|debug|release|all
 BUILD_SERVER=${BUILD_SERVER:-ON}
 BUILD_SERVER_LIBS=${BUILD_SERVER_LIBS:-ON}
 BUILD_CLIENT=${BUILD_CLIENT:-ON}
+BUILD_TOOLS=${BUILD_TOOLS:-ON}
+BUILD_BENCH=${BUILD_BENCH:-ON}
+LOG_MIN_LEVEL=${LOG_MIN_LEVEL:-}   # 비우면 Debug=DEBUG, Release=INFO
 
 # 인자 파싱: --no-server --no-libs --no-client 등
 shift || true
@@ -18,10 +21,14 @@ while [[ $# -gt 0 ]]; do
     --no-libs)     BUILD_SERVER_LIBS=OFF ;;
     --client)      BUILD_CLIENT=ON ;;
     --no-client)   BUILD_CLIENT=OFF ;;
+    --tools)       BUILD_TOOLS=ON ;;
+    --no-tools)    BUILD_TOOLS=OFF ;;
+    --bench)       BUILD_BENCH=ON ;;
+    --no-bench)    BUILD_BENCH=OFF ;;
     *)
       echo "Unknown option: $1"
       echo "Usage:"
-      echo "  $0 {clean|debug|release|all} [--no-server] [--no-libs] [--no-client]"
+      echo "  $0 {clean|debug|release|all} [--no-server] [--no-libs] [--no-client] [--no-tools] [--no-bench]"
       exit 1
       ;;
   esac
@@ -35,7 +42,10 @@ RELEASE_DIR=$BUILD_DIR/release
 common_cmake_args() {
   echo -DBUILD_SERVER=${BUILD_SERVER} \
        -DBUILD_SERVER_LIBS=${BUILD_SERVER_LIBS} \
-       -DBUILD_CLIENT=${BUILD_CLIENT}
+       -DBUILD_CLIENT=${BUILD_CLIENT} \
+       -DBUILD_TOOLS=${BUILD_TOOLS} \
+       -DBUILD_BENCH=${BUILD_BENCH} \
+       -DLOG_MIN_LEVEL=${LOG_MIN_LEVEL}
 }
 
 clean() {
@@ -64,7 +74,7 @@ case "$MODE" in
     release) build_release ;;
     all)     build_debug; build_release ;;
     *)
-        echo "Usage: $0 {clean|debug|release|all} [--no-server] [--no-libs] [--no-client]"
+        echo "Usage: $0 {clean|debug|release|all} [--no-server] [--no-libs] [--no-client] [--no-tools] [--no-bench]"
         exit 1
         ;;
 esac
@@ -1,12 +1,10 @@
 #!/bin/bash
 
-START=55001
-END=56000
-BIN=./build/release/Server/tcp_server
+# 한 프로세스가 55001..56000 전체를 리스닝한다 (스레드 풀 / dispatcher 공유)
+# 예전처럼 포트마다 tcp_server 프로세스를 띄우지 않는다.
+START=${START:-55001}
+END=${END:-56000}
+BIN=${BIN:-./build/release/Server/tcp_server}
 
-for ((port=START; port<=END; port++)); do
-    echo "Starting tcp_server on port $port"
-    $BIN $port &
-done
-
-wait
+echo "Starting tcp_server on ports $START-$END"
+exec $BIN "$START-$END"